@@ -4,33 +4,48 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
+../adc.c \
 ../buzzer.c \
 ../control_ecu.c \
+../current_sensor.c \
 ../dc_motor.c \
+../door_sensor.c \
 ../external_eeprom.c \
 ../gpio.c \
+../power.c \
+../prof.c \
 ../pwm.c \
 ../timer1.c \
 ../twi.c \
 ../uart.c 
 
 OBJS += \
+./adc.o \
 ./buzzer.o \
 ./control_ecu.o \
+./current_sensor.o \
 ./dc_motor.o \
+./door_sensor.o \
 ./external_eeprom.o \
 ./gpio.o \
+./power.o \
+./prof.o \
 ./pwm.o \
 ./timer1.o \
 ./twi.o \
 ./uart.o 
 
 C_DEPS += \
+./adc.d \
 ./buzzer.d \
 ./control_ecu.d \
+./current_sensor.d \
 ./dc_motor.d \
+./door_sensor.d \
 ./external_eeprom.d \
 ./gpio.d \
+./power.d \
+./prof.d \
 ./pwm.d \
 ./timer1.d \
 ./twi.d \
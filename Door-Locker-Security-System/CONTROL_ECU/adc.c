@@ -0,0 +1,84 @@
+/******************************************************************************
+ *
+ * Module: ADC
+ *
+ * File Name: adc.c
+ *
+ * Description: Source file for the ATmega32 ADC driver
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+#include "adc.h"
+#include "common_macros.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/* Global variables to hold the address of the call back function in the application */
+static void (*volatile g_callBackPtr)(uint16 sample) = NULL_PTR;
+
+/*******************************************************************************
+ *                       Interrupt Service Routines                            *
+ *******************************************************************************/
+
+ISR(ADC_vect)
+{
+	if(g_callBackPtr != NULL_PTR)
+	{
+		/* Call the Call Back function in the application with the new sample */
+		(*g_callBackPtr)(ADC);
+	}
+}
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+void ADC_init(const ADC_ConfigType * Config_Ptr)
+{
+	/* ADMUX Register Bits Description:
+	 * REFS1:0 = the required reference voltage
+	 * ADLAR   = 0 right adjusted
+	 * MUX4:0  = 00000 to choose channel 0 as initialization
+	 */
+	ADMUX = (Config_Ptr->ref_volt << REFS0);
+
+	/* ADCSRA Register Bits Description:
+	 * ADEN    = 1 Enable ADC
+	 * ADIE    = 0 the interrupt is enabled with the conversions
+	 * ADATE   = 0 Disable Auto Trigger until the conversions are started
+	 * ADPS2:0 = the required ADC clock prescaler
+	 */
+	ADCSRA = (1<<ADEN) | Config_Ptr->prescaler;
+}
+
+void ADC_setCallBack(void(*a_ptr)(uint16 sample))
+{
+	/* Save the address of the Call back function in a global variable */
+	g_callBackPtr = a_ptr;
+}
+
+void ADC_startFreeRunning(uint8 channel_num)
+{
+	/* Choose the correct channel by setting the channel number in MUX4:0 bits */
+	ADMUX = (ADMUX & 0xE0) | (channel_num & 0x07);
+
+	/* Free running trigger source ADTS2:0 = 000 */
+	SFIOR &= 0x1F;
+
+	/* Clear an old conversion complete flag then start converting forever */
+	ADCSRA |= (1<<ADIF);
+	ADCSRA |= (1<<ADATE) | (1<<ADIE) | (1<<ADSC);
+}
+
+void ADC_stop(void)
+{
+	/* Stop triggering new conversions and drop the pending one */
+	ADCSRA &= ~((1<<ADATE) | (1<<ADIE));
+	ADCSRA |= (1<<ADIF);
+}
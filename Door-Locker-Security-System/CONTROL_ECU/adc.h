@@ -0,0 +1,67 @@
+ /******************************************************************************
+ *
+ * Module: ADC
+ *
+ * File Name: adc.h
+ *
+ * Description: header file for the ATmega32 ADC driver
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+#ifndef ADC_H_
+#define ADC_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* A conversion takes 13 ADC clocks in the free running mode */
+#define ADC_CONVERSION_CLOCKS            13UL
+
+/*******************************************************************************
+ *                                Enums                                        *
+ *******************************************************************************/
+typedef enum{
+	AREF, AVCC, INTERNAL_2_56V = 3
+}ADC_ReferenceVoltage;
+
+typedef enum{
+	ADC_F_CPU_2 = 1, ADC_F_CPU_4, ADC_F_CPU_8, ADC_F_CPU_16, ADC_F_CPU_32, ADC_F_CPU_64, ADC_F_CPU_128
+}ADC_Prescaler;
+
+/*******************************************************************************
+ *                                Structs                                      *
+ *******************************************************************************/
+typedef struct{
+	ADC_ReferenceVoltage ref_volt;
+	ADC_Prescaler prescaler;
+}ADC_ConfigType;
+
+/*******************************************************************************
+ *                                Functions Prototypes                         *
+ *******************************************************************************/
+
+/* Description: Function to initialize the ADC driver, the ADC stays idle until
+ * ADC_startFreeRunning() is called.
+ * */
+void ADC_init(const ADC_ConfigType * Config_Ptr);
+
+/* Description: Function to set the Call Back function address, it is called from
+ * the ADC interrupt with every new 10-bit sample.
+ * */
+void ADC_setCallBack(void(*a_ptr)(uint16 sample));
+
+/* Description: Function to convert a channel continuously in the free running
+ * mode, every conversion ends with an interrupt and the CPU never waits for it.
+ * */
+void ADC_startFreeRunning(uint8 channel_num);
+
+/* Description: Function to stop the conversions.
+ * */
+void ADC_stop(void);
+
+#endif /* ADC_H_ */
@@ -2,7 +2,7 @@
  *
  * Module: Buzzer
  *
- * File Name: uart.c
+ * File Name: buzzer.c
  *
  * Description: Source file for the Buzzer driver
  *
@@ -16,6 +16,77 @@
 
 #include "buzzer.h"
 #include "gpio.h"
+#include "timer1.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+/*******************************************************************************
+ *                      Patterns Tables                                        *
+ *******************************************************************************/
+
+static const Buzzer_StepType g_steps[] PROGMEM = {
+	/* Key click */
+	{BUZZER_TONE(4000),  15,    0},
+	/* Denied: two low beeps */
+	{BUZZER_TONE(400),  150,  100},
+	{BUZZER_TONE(300),  400,    0},
+	/* Lockout siren: two alternating tones */
+	{BUZZER_TONE(800),  250,    0},
+	{BUZZER_TONE(1200), 250,    0},
+	/* Door ajar: a chime every 2 seconds */
+	{BUZZER_TONE(1000), 120,   60},
+	{BUZZER_TONE(750),  200, 1620},
+};
+
+static const Buzzer_PatternType g_patterns[BUZZER_PATTERNS_NUM] PROGMEM = {
+	{0, 1, 1,                     0}, /* BUZZER_KEY_CLICK */
+	{1, 2, 1,                     1}, /* BUZZER_DENIED */
+	{3, 2, BUZZER_REPEAT_FOREVER, 3}, /* BUZZER_LOCKOUT_SIREN */
+	{5, 2, BUZZER_REPEAT_FOREVER, 2}, /* BUZZER_DOOR_AJAR */
+};
+
+/*******************************************************************************
+ *                      Global Variables                                       *
+ *******************************************************************************/
+
+/* Steps of the pattern being played */
+static volatile uint8 g_firstStep = 0;
+static volatile uint8 g_lastStep = 0;
+static volatile uint8 g_step = 0;
+static volatile uint8 g_repeatsLeft = 0;
+static volatile uint8 g_priority = 0;
+
+/* Time left in the on or off part of the step, in ms */
+static volatile uint16 g_timeLeft = 0;
+static volatile boolean g_toneOn = FALSE;
+
+/* Timer1 subscriber id of the step function while a pattern is played */
+static volatile uint8 g_tickId = TIMER1_INVALID_SUBSCRIBER;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Generate a tone on OC2 with Timer2 in CTC toggle mode, no CPU is used to keep it.
+ */
+static void Buzzer_toneOn(uint8 tone);
+
+/*
+ * Stop Timer2 and leave OC2 low.
+ */
+static void Buzzer_toneOff(void);
+
+/*
+ * Start the on part of the current step.
+ */
+static void Buzzer_startStep(void);
+
+/*
+ * Called every 1ms from the Timer1 compare B interrupt while a pattern is played.
+ */
+static void Buzzer_tick(void);
 
 /*******************************************************************************
  *                      Function Definitions                                      *
@@ -30,24 +101,133 @@ void Buzzer_init(void)
 	GPIO_setupPinDirection(BUZZER_PORT_ID,BUZZER_PIN_ID,PIN_OUTPUT);
 
 	GPIO_writePin(BUZZER_PORT_ID,BUZZER_PIN_ID,LOGIC_LOW);
+
+	Buzzer_toneOff();
 }
 
-/*[FUNCTION NAME]	: Buzzer_init
- *[DESCRIPTION]		: Function to turn on the Buzzer
- *[ARGUMENTS]		: void
+/*[FUNCTION NAME]	: Buzzer_play
+ *[DESCRIPTION]		: Function to play a pattern in the background, unless a pattern of a higher
+ *                    priority is played
+ *[ARGUMENTS]		: pattern id of type Buzzer_PatternId
  *[RETURNS]			: void
  */
-void Buzzer_on(void)
+void Buzzer_play(Buzzer_PatternId pattern_id)
 {
-	GPIO_writePin(BUZZER_PORT_ID,BUZZER_PIN_ID,LOGIC_HIGH);
+	uint8 sreg = SREG;
+
+	if(pattern_id >= BUZZER_PATTERNS_NUM)
+	{
+		return;
+	}
+
+	cli();
+	if((g_tickId != TIMER1_INVALID_SUBSCRIBER) && (pgm_read_byte(&g_patterns[pattern_id].priority) < g_priority))
+	{
+		/* Keep the alarm sounding */
+		SREG = sreg;
+		return;
+	}
+
+	g_priority = pgm_read_byte(&g_patterns[pattern_id].priority);
+	g_firstStep = pgm_read_byte(&g_patterns[pattern_id].first_step);
+	g_lastStep = g_firstStep + pgm_read_byte(&g_patterns[pattern_id].steps_num) - 1;
+	g_repeatsLeft = pgm_read_byte(&g_patterns[pattern_id].repeat);
+	g_step = g_firstStep;
+	Buzzer_startStep();
+
+	if(g_tickId == TIMER1_INVALID_SUBSCRIBER)
+	{
+		g_tickId = Timer1_subscribe(TIMER1_COMPB_CHANNEL,Buzzer_tick,1);
+	}
+	SREG = sreg;
 }
 
-/*[FUNCTION NAME]	: Buzzer_init
- *[DESCRIPTION]		: Function to turn off the Buzzer
+/*[FUNCTION NAME]	: Buzzer_stop
+ *[DESCRIPTION]		: Function to stop the pattern and turn off the Buzzer
  *[ARGUMENTS]		: void
  *[RETURNS]			: void
  */
-void Buzzer_off(void)
+void Buzzer_stop(void)
 {
-	GPIO_writePin(BUZZER_PORT_ID,BUZZER_PIN_ID,LOGIC_LOW);
+	uint8 sreg = SREG;
+
+	cli();
+	Timer1_unsubscribe(g_tickId);
+	g_tickId = TIMER1_INVALID_SUBSCRIBER;
+	Buzzer_toneOff();
+	SREG = sreg;
+}
+
+/*[FUNCTION NAME]	: Buzzer_isPlaying
+ *[DESCRIPTION]		: Function to check if a pattern is played
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: TRUE while playing of type boolean
+ */
+boolean Buzzer_isPlaying(void)
+{
+	return (g_tickId != TIMER1_INVALID_SUBSCRIBER);
+}
+
+static void Buzzer_toneOn(uint8 tone)
+{
+	OCR2 = tone;
+	TCNT2 = 0;
+
+	/* Configure timer control register
+	 * 1. FOC2=0, a forced compare would toggle OC2
+	 * 2. CTC Mode WGM21=1 & WGM20=0
+	 * 3. Toggle OC2 on compare match COM20=1 & COM21=0
+	 * 4. clock = F_CPU/64 CS22=1 CS21=0 CS20=0
+	 */
+	TCCR2 = (1<<WGM21) | (1<<COM20) | BUZZER_TIMER_PRESCALER_BITS;
+	g_toneOn = TRUE;
+}
+
+static void Buzzer_toneOff(void)
+{
+	/* Stop the timer and disconnect OC2, the pin goes back to its low port value */
+	TCCR2 = 0;
+	g_toneOn = FALSE;
+}
+
+static void Buzzer_startStep(void)
+{
+	Buzzer_toneOn(pgm_read_byte(&g_steps[g_step].tone));
+	g_timeLeft = pgm_read_word(&g_steps[g_step].on_time);
+}
+
+static void Buzzer_tick(void)
+{
+	if(--g_timeLeft != 0)
+	{
+		return;
+	}
+
+	if(g_toneOn)
+	{
+		Buzzer_toneOff();
+		g_timeLeft = pgm_read_word(&g_steps[g_step].off_time);
+		if(g_timeLeft != 0)
+		{
+			return;
+		}
+	}
+
+	/* Move on to the next step, then to the next repeat of the pattern */
+	if(g_step < g_lastStep)
+	{
+		g_step++;
+	}
+	else if((g_repeatsLeft == BUZZER_REPEAT_FOREVER) || (--g_repeatsLeft != 0))
+	{
+		g_step = g_firstStep;
+	}
+	else
+	{
+		/* The pattern is over */
+		Timer1_unsubscribe(g_tickId);
+		g_tickId = TIMER1_INVALID_SUBSCRIBER;
+		return;
+	}
+	Buzzer_startStep();
 }
@@ -13,11 +13,54 @@
 #ifndef BUZZER_H_
 #define BUZZER_H_
 
+#include "std_types.h"
+
 /*******************************************************************************
  *                      Definitions                                    *
  *******************************************************************************/
-#define BUZZER_PORT_ID   PORTA_ID
-#define BUZZER_PIN_ID    PIN0_ID
+
+/* The buzzer is driven by the Timer2 compare output OC2 */
+#define BUZZER_PORT_ID   PORTD_ID
+#define BUZZER_PIN_ID    PIN7_ID
+
+/* Timer2 clock = F_CPU/64, tones from 245Hz up */
+#define BUZZER_TIMER_PRESCALER_BITS   (1<<CS22)
+#define BUZZER_TIMER_DIVISION         64UL
+
+/* Timer2 compare value of a tone in Hz, OC2 toggles twice per tone period */
+#define BUZZER_TONE(FREQUENCY)        ((uint8)((F_CPU / (2UL * BUZZER_TIMER_DIVISION * (FREQUENCY))) - 1))
+
+/* Repeat count of the patterns played until Buzzer_stop() */
+#define BUZZER_REPEAT_FOREVER         0xFF
+
+/*******************************************************************************
+ *                      Enums                                                  *
+ *******************************************************************************/
+typedef enum{
+	BUZZER_KEY_CLICK, BUZZER_DENIED, BUZZER_LOCKOUT_SIREN, BUZZER_DOOR_AJAR, BUZZER_PATTERNS_NUM
+}Buzzer_PatternId;
+
+/*******************************************************************************
+ *                      Structs                                                *
+ *******************************************************************************/
+
+/* One step of a pattern: a tone for on_time then silence for off_time (ms) */
+typedef struct{
+	uint8 tone;
+	uint16 on_time;
+	uint16 off_time;
+}Buzzer_StepType;
+
+/*
+ * A pattern plays steps_num steps from first_step, repeat times. It does not
+ * replace a pattern of a higher priority being played.
+ */
+typedef struct{
+	uint8 first_step;
+	uint8 steps_num;
+	uint8 repeat;
+	uint8 priority;
+}Buzzer_PatternType;
 
 /*******************************************************************************
  *                      Functions Prototypes                                    *
@@ -31,13 +74,21 @@
 void Buzzer_init(void);
 
 /*Description:
- * Function to enable the Buzzer through the GPIO
+ * Start playing a pattern in the background, replacing the one being played
+ * unless that one has a higher priority (a key click never cuts an alarm).
+ * The tones are generated by Timer2 and the steps are timed by the Timer1
+ * compare B ticks, so Timer1 must be initialized first.
+ * */
+void Buzzer_play(Buzzer_PatternId pattern_id);
+
+/*Description:
+ * Stop the pattern being played and turn off the buzzer.
  * */
-void Buzzer_on(void);
+void Buzzer_stop(void);
 
 /*Description:
- * Function to disable the Buzzer through the GPIO
+ * Return TRUE while a pattern is played.
  * */
-void Buzzer_off(void);
+boolean Buzzer_isPlaying(void);
 
 #endif /* BUZZER_H_ */
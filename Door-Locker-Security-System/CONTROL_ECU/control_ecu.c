@@ -14,10 +14,13 @@
 #include "external_eeprom.h"
 #include "twi.h"
 #include "timer1.h"
+#include "power.h"
+#include "prof.h"
 #include "std_types.h"
 #include "dc_motor.h"
 #include "buzzer.h"
-#include <util/delay.h>
+#include "door_sensor.h"
+#include "current_sensor.h"
 #include <avr/io.h>
 
 #define HMI_ECU_READY             0x10
@@ -29,19 +32,36 @@
 #define SECOND_PASSWORD_DELIVERED 0x08
 #define OPEN_DOOR                 43   /* + */
 #define CHANGE_PASS               45  /* - */
-#define DOOR_IS_UNLOCKING         15
+#define DOOR_IS_UNLOCKING         15   /* safety timeout, the limit switches or a stall stop the door earlier */
 #define DOOR_IS_LOCKING           15
 #define MOTOR_HOLD                3
 #define WRONG_PASSWORD            0
 #define EEPROM_START_ADDRESS      0x0311
 #define PASS_TRIALS               3
 #define WARNING                   0x3C
+#define WAIT_TIMER_ID             0
+#define PROGRESS_TIMER_ID         1
+#define DOOR_PROGRESS             0x7E
+#define DOOR_PROGRESS_PERIOD_MS   250
+#define DOOR_PHASE_UNLOCKING      1
+#define DOOR_PHASE_OPEN           2
+#define DOOR_PHASE_LOCKING        3
+#define DOOR_PHASE_LOCKED         4
+#define DOOR_NO_FAULT             0
+#define DOOR_FAULT_TIMEOUT        1
+#define DOOR_FAULT_OBSTRUCTION    2
+#define MOTOR_ACCELERATION_TIME   1000 /* ms */
+#define MOTOR_DECELERATION_TIME   1500 /* ms */
+#define DOOR_LANDING_PULSES       (DOOR_SENSOR_TRAVEL_PULSES / 8) /* the last 1/8 of the travel */
+#define DOOR_LANDING_SPEED        60   /* % the stall current stays above the stall threshold */
+#define DOOR_CLOSE_RETRIES        3    /* closings tried again after a stall, after the first one */
+#define DOOR_REACHED              0
+#define DOOR_TIMEOUT              1
+#define DOOR_STALLED              2
 
 uint8 current_password[PASSWORD_SIZE];
-uint8 g_ticks = 0;
 uint8 pressed_key = 0;
 
-void Timer1_callBack(void);
 void Save_Password(void);
 void Receive_Password(uint8 *password, uint8 password_size);
 uint8 Compare_Password(uint8 *pass1, uint8 *pass2, uint8 size);
@@ -49,8 +69,12 @@ void EEPROM_savePass(uint8 *pass, uint8 pass_size);
 void Open_Door(void);
 uint8 EEPROM_comparePass(uint8 *pass, uint8 pass_size);
 void Motor_Fun(void);
+uint8 Door_move(DcMotor_State direction, DoorSensor_LimitType limit, uint8 timeout);
+void Door_hold(void);
+void Door_sendProgress(uint8 phase, uint8 percent, uint8 remaining_time, uint8 fault);
 void Change_Password(void);
 void Buzzer_function(void);
+void Wait_ms(uint16 time_ms);
 
 int main(void)
 {
@@ -65,13 +89,32 @@ int main(void)
 	UART_ConfigType uart_configurations = {EIGHT_BITS,EVEN,ONE_BIT,9600};
 	UART_init(&uart_configurations);
 
-	/* Initialize Timer1 Driver to make an interrupt every 1sec */
-	Timer1_ConfigType configurations = {0,8000,F_CPU_1024,CTC};
+#if (TIMER1_TICKLESS_MODE == TRUE)
+	/* Initialize Timer1 Driver to run free and interrupt only at the software timers deadlines */
+	Timer1_ConfigType configurations = {0,0,TIMER1_TIMEBASE_PRESCALER,NORMAL};
+#else
+	/* Initialize Timer1 Driver to make an interrupt every 1sec (every 1msec in the profiling builds) */
+	Timer1_ConfigType configurations = {0,8000,TIMER1_TIMEBASE_PRESCALER,CTC};
+#endif
 	Timer1_init(&configurations);
-	Timer1_setCallBack(Timer1_callBack);
 
-	/* Initialize the Motor Driver */
+	/* Initialize the Power Management driver to sleep while waiting */
+	POWER_init();
+
+	/* Initialize the profiler (only in the profiling builds) */
+	PROF_INIT();
+
+	/* Initialize the Motor Driver with soft start and soft stop ramps */
 	DcMotor_Init();
+	DcMotor_RampConfigType ramp_configurations = {S_CURVE_RAMP,MOTOR_ACCELERATION_TIME,MOTOR_DECELERATION_TIME};
+	DcMotor_setRamp(&ramp_configurations);
+
+	/* Initialize the Buzzer driver */
+	Buzzer_init();
+
+	/* Initialize the door limit switches and the motor current sensor */
+	DoorSensor_init();
+	CurrentSensor_init();
 
 	/* Wait for the verification byte to start */
 	while(UART_recieveByte() != HMI_ECU_READY);
@@ -84,6 +127,7 @@ int main(void)
 	{
 		/* Receive the pressed key is received */
 		pressed_key = UART_recieveByte();
+		Buzzer_play(BUZZER_KEY_CLICK);
 
 		if(pressed_key == OPEN_DOOR)
 		{
@@ -93,16 +137,19 @@ int main(void)
 		{
 			Change_Password();
 		}
+#ifdef PROF_ENABLE
+		if(pressed_key == PROF_DUMP_KEY)
+		{
+			/* This table goes first, then the one of the HMI_ECU is dropped */
+			PROF_DUMP();
+			PROF_SKIP_DUMP();
+		}
+#endif
 	}
 
 }
 
 
-void Timer1_callBack(void)
-{
-	g_ticks++;
-}
-
 void Save_Password(void)
 {
 	uint8 pass_state = UNMATCHED_PASSWORD;
@@ -155,7 +202,7 @@ void Receive_Password(uint8 *password, uint8 password_size)
 	for(counter = 0 ; counter < password_size ; counter++)
 	{
 		password[counter] = UART_recieveByte();
-		_delay_ms(50);
+		Wait_ms(50);
 	}
 }
 
@@ -186,7 +233,7 @@ void EEPROM_savePass(uint8 *pass, uint8 pass_size)
 	for(counter = 0 ; counter < pass_size ; counter++)
 	{
 		EEPROM_writeByte(EEPROM_START_ADDRESS + counter, pass[counter]);
-		_delay_ms(10);
+		Wait_ms(10);
 	}
 }
 
@@ -235,6 +282,7 @@ void Open_Door(void)
 			else
 			{
 				UART_sendByte(UNMATCHED_PASSWORD);
+				Buzzer_play(BUZZER_DENIED);
 			}
 		}
 	}
@@ -246,6 +294,8 @@ uint8 EEPROM_comparePass(uint8 *pass, uint8 pass_size)
 	uint8 counter = 0;
 	uint8 read_byte = 0;
 
+	PROF_BEGIN(PROF_ID_EEPROM_COMPARE_PASS);
+
 	for(counter = 0 ; counter < pass_size ; counter++)
 	{
 		/* Read the password from EEPROM byte by byte */
@@ -261,29 +311,157 @@ uint8 EEPROM_comparePass(uint8 *pass, uint8 pass_size)
 			pass_state = MATCHED_PASSWORD;
 		}
 	}
+
+	PROF_END(PROF_ID_EEPROM_COMPARE_PASS);
+
 	return pass_state;
 }
 
 void Motor_Fun(void)
 {
-	/*Opening the door in 15sec*/
-	g_ticks=0;
-	DcMotor_Rotate(CW,100); /* Rotate the DC Motor in clock wise direction with maximum speed */
-	while (g_ticks < DOOR_IS_UNLOCKING);
+	uint8 close_retries = 0;
+	uint8 result;
+
+	/*Opening the door until the open limit switch, an obstruction or 15sec at most*/
+	Door_move(CW,DOOR_OPEN_LIMIT,DOOR_IS_UNLOCKING);
 
 	/*Holding the door in 3sec*/
-	g_ticks=0;
-	DcMotor_Rotate(STOP,0); /* Hold the DC Motor */
-	while (g_ticks < MOTOR_HOLD);
-
-	/*Closing the door in 15sec*/
-	g_ticks=0;
-	DcMotor_Rotate(A_CW,100); /* Rotate the DC Motor in anti-clock wise direction with maximum speed */
-	while (g_ticks < DOOR_IS_LOCKING);
-
-	/*Stop the Motor*/
-	DcMotor_Rotate(STOP,0); /* Stop the DC Motor */
-	_delay_ms(1000);
+	Door_hold();
+
+	/*Closing the door until the closed limit switch or 15sec at most*/
+	while((result = Door_move(A_CW,DOOR_CLOSED_LIMIT,DOOR_IS_LOCKING)) == DOOR_STALLED)
+	{
+		if(close_retries == DOOR_CLOSE_RETRIES)
+		{
+			/* Still blocked after all the retries, leave it stopped where it is */
+			break;
+		}
+		close_retries++;
+
+		/* Something is blocking the door, open it again to release it and retry after the hold time */
+		Door_move(CW,DOOR_OPEN_LIMIT,DOOR_IS_UNLOCKING);
+		Door_hold();
+	}
+
+	/* End of the door sequence, chime while the door could not be closed */
+	if(result != DOOR_REACHED)
+	{
+		Buzzer_play(BUZZER_DOOR_AJAR);
+	}
+	Door_sendProgress(DOOR_PHASE_LOCKED,100,0,(result == DOOR_STALLED) ? DOOR_FAULT_OBSTRUCTION :
+			(result == DOOR_TIMEOUT) ? DOOR_FAULT_TIMEOUT : DOOR_NO_FAULT);
+	Wait_ms(1000);
+}
+
+void Door_hold(void)
+{
+	uint8 second;
+
+	for(second = 0 ; second < MOTOR_HOLD ; second++)
+	{
+		Door_sendProgress(DOOR_PHASE_OPEN,(uint8)((second * 100) / MOTOR_HOLD),MOTOR_HOLD - second,DOOR_NO_FAULT);
+		Timer1_startSwTimer(WAIT_TIMER_ID,TIMER1_SECONDS(1));
+		POWER_WAIT_WHILE(!Timer1_isSwTimerExpired(WAIT_TIMER_ID));
+	}
+}
+
+void Door_sendProgress(uint8 phase, uint8 percent, uint8 remaining_time, uint8 fault)
+{
+	UART_sendByte(DOOR_PROGRESS);
+	UART_sendByte(phase);
+	UART_sendByte(percent);
+	UART_sendByte(remaining_time);
+	UART_sendByte(fault);
+}
+
+uint8 Door_move(DcMotor_State direction, DoorSensor_LimitType limit, uint8 timeout)
+{
+	uint8 phase = (direction == CW) ? DOOR_PHASE_UNLOCKING : DOOR_PHASE_LOCKING;
+	uint8 result;
+	uint32 start_time;
+	uint32 elapsed_time;
+	uint32 estimated_time;
+	uint8 safety_time;
+	uint16 pulses;
+	uint8 percent = 0;
+	uint8 remaining_time = timeout;
+	boolean landing = FALSE;
+
+	if(DoorSensor_isLimitReached(limit))
+	{
+		Door_sendProgress(phase,100,0,DOOR_NO_FAULT);
+		return DOOR_REACHED;
+	}
+
+	start_time = Timer1_getTimeStamp();
+	DoorSensor_resetEncoderCount();
+	Timer1_startSwTimer(WAIT_TIMER_ID,TIMER1_SECONDS(timeout));
+	CurrentSensor_start();
+	DcMotor_Rotate(direction,100); /* Rotate the DC Motor with maximum speed */
+
+	while(!Timer1_isSwTimerExpired(WAIT_TIMER_ID) && !DoorSensor_isLimitReached(limit) && !CurrentSensor_isStalled())
+	{
+		/* The travel done is counted by the encoder, the remaining time follows its speed so far */
+		elapsed_time = Timer1_getTimeStamp() - start_time;
+		pulses = DoorSensor_getEncoderCount();
+
+		/* Seconds left before the safety timeout stops the door anyway */
+		safety_time = (elapsed_time < TIMER1_SECONDS(timeout)) ? (timeout - (uint8)(elapsed_time / TIMER1_COUNTS_PER_SECOND)) : 0;
+
+		/* Slow down on the deceleration ramp near the end so the door lands softly on its end stop */
+		if(!landing && (pulses >= (DOOR_SENSOR_TRAVEL_PULSES - DOOR_LANDING_PULSES)))
+		{
+			DcMotor_Rotate(direction,DOOR_LANDING_SPEED);
+			landing = TRUE;
+		}
+
+		if(pulses >= DOOR_SENSOR_TRAVEL_PULSES)
+		{
+			percent = 99;
+			remaining_time = 0;
+		}
+		else if(pulses != 0)
+		{
+			percent = (uint8)(((uint32)pulses * 100) / DOOR_SENSOR_TRAVEL_PULSES);
+			estimated_time = ((elapsed_time / pulses) * (DOOR_SENSOR_TRAVEL_PULSES - pulses)) / TIMER1_COUNTS_PER_SECOND;
+
+			/* A slow first pulse gives a long estimate, it would wrap in the progress frame byte */
+			remaining_time = (estimated_time < safety_time) ? (uint8)estimated_time : safety_time;
+		}
+		else
+		{
+			/* No pulse yet, only the safety timeout is known */
+			remaining_time = safety_time;
+		}
+		Door_sendProgress(phase,percent,remaining_time,DOOR_NO_FAULT);
+
+		Timer1_startSwTimer(PROGRESS_TIMER_ID,TIMER1_MILLISECONDS(DOOR_PROGRESS_PERIOD_MS));
+		POWER_WAIT_WHILE(!Timer1_isSwTimerExpired(PROGRESS_TIMER_ID) && !Timer1_isSwTimerExpired(WAIT_TIMER_ID) &&
+				!DoorSensor_isLimitReached(limit) && !CurrentSensor_isStalled() &&
+				(landing || (DoorSensor_getEncoderCount() < (DOOR_SENSOR_TRAVEL_PULSES - DOOR_LANDING_PULSES))));
+	}
+
+	/* Stop at once at the end stop, the obstruction or the timeout, no more pushing against them */
+	DcMotor_Stop();
+	CurrentSensor_stop();
+	Timer1_stopSwTimer(PROGRESS_TIMER_ID);
+
+	if(DoorSensor_isLimitReached(limit))
+	{
+		result = DOOR_REACHED;
+		Door_sendProgress(phase,100,0,DOOR_NO_FAULT);
+	}
+	else if(CurrentSensor_isStalled())
+	{
+		result = DOOR_STALLED;
+		Door_sendProgress(phase,percent,0,DOOR_FAULT_OBSTRUCTION);
+	}
+	else
+	{
+		result = DOOR_TIMEOUT;
+		Door_sendProgress(phase,percent,0,DOOR_FAULT_TIMEOUT);
+	}
+	return result;
 }
 
 void Change_Password(void)
@@ -330,15 +508,23 @@ void Change_Password(void)
 			else
 			{
 				UART_sendByte(UNMATCHED_PASSWORD);
+				Buzzer_play(BUZZER_DENIED);
 			}
 		}
 	}
 }
 
 void Buzzer_function(void){
-	g_ticks=0;
-	/*operate buzzer for 60 sec*/
-	Buzzer_on();
-	while (g_ticks < WARNING);
-	Buzzer_off();
+	Timer1_startSwTimer(WAIT_TIMER_ID,TIMER1_SECONDS(WARNING));
+	/*operate the lockout siren for 60 sec*/
+	Buzzer_play(BUZZER_LOCKOUT_SIREN);
+	POWER_WAIT_WHILE(!Timer1_isSwTimerExpired(WAIT_TIMER_ID));
+	Buzzer_stop();
+}
+
+void Wait_ms(uint16 time_ms)
+{
+	/* Sleep until the software timer expires instead of spinning in _delay_ms() */
+	Timer1_startSwTimer(WAIT_TIMER_ID,TIMER1_MILLISECONDS(time_ms));
+	POWER_WAIT_WHILE(!Timer1_isSwTimerExpired(WAIT_TIMER_ID));
 }
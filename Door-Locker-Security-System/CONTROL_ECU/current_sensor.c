@@ -0,0 +1,165 @@
+/******************************************************************************
+ *
+ * Module: Current Sensor
+ *
+ * File Name: current_sensor.c
+ *
+ * Description: Source file for the motor current sensor driver
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                      Used Header Files                                      *
+ *******************************************************************************/
+
+#include "current_sensor.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+/*******************************************************************************
+ *                      Global Variables                                       *
+ *******************************************************************************/
+
+/* Filter accumulator, holds the filtered current multiplied by 2^CURRENT_SENSOR_FILTER_SHIFT */
+static volatile uint16 g_filterSum = 0;
+
+static volatile uint16 g_current = 0;
+static volatile uint16 g_peakCurrent = 0;
+
+/* Samples left in the blanking time and consecutive samples above the stall current */
+static volatile uint16 g_blankingSamples = 0;
+static volatile uint16 g_overCurrentSamples = 0;
+
+static volatile boolean g_stalled = FALSE;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Called from the ADC interrupt with every new sample.
+ */
+static void CurrentSensor_newSample(uint16 sample);
+
+/*******************************************************************************
+ *                      Function Definitions                                   *
+ *******************************************************************************/
+
+/*[FUNCTION NAME]	: CurrentSensor_init
+ *[DESCRIPTION]		: Function to initialize the current measurement
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: void
+ */
+void CurrentSensor_init(void)
+{
+	ADC_ConfigType adc_configurations = {CURRENT_SENSOR_REF_VOLT,CURRENT_SENSOR_PRESCALER};
+
+	ADC_init(&adc_configurations);
+	ADC_setCallBack(CurrentSensor_newSample);
+}
+
+/*[FUNCTION NAME]	: CurrentSensor_start
+ *[DESCRIPTION]		: Function to start sampling the motor current in the background
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: void
+ */
+void CurrentSensor_start(void)
+{
+	uint8 sreg = SREG;
+
+	cli();
+	g_filterSum = 0;
+	g_current = 0;
+	g_peakCurrent = 0;
+	g_blankingSamples = CURRENT_SENSOR_SAMPLES(CURRENT_SENSOR_BLANKING_TIME_MS);
+	g_overCurrentSamples = 0;
+	g_stalled = FALSE;
+	SREG = sreg;
+
+	ADC_startFreeRunning(CURRENT_SENSOR_CHANNEL_ID);
+}
+
+/*[FUNCTION NAME]	: CurrentSensor_stop
+ *[DESCRIPTION]		: Function to stop sampling the motor current
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: void
+ */
+void CurrentSensor_stop(void)
+{
+	ADC_stop();
+}
+
+/*[FUNCTION NAME]	: CurrentSensor_getCurrent
+ *[DESCRIPTION]		: Function to get the filtered motor current
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: current in ADC counts of type uint16
+ */
+uint16 CurrentSensor_getCurrent(void)
+{
+	uint8 sreg = SREG;
+	uint16 current;
+
+	cli();
+	current = g_current;
+	SREG = sreg;
+
+	return current;
+}
+
+/*[FUNCTION NAME]	: CurrentSensor_getPeakCurrent
+ *[DESCRIPTION]		: Function to get the highest filtered motor current
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: current in ADC counts of type uint16
+ */
+uint16 CurrentSensor_getPeakCurrent(void)
+{
+	uint8 sreg = SREG;
+	uint16 current;
+
+	cli();
+	current = g_peakCurrent;
+	SREG = sreg;
+
+	return current;
+}
+
+/*[FUNCTION NAME]	: CurrentSensor_isStalled
+ *[DESCRIPTION]		: Function to check the stall event of the motor
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: TRUE once the motor is stalled of type boolean
+ */
+boolean CurrentSensor_isStalled(void)
+{
+	return g_stalled;
+}
+
+static void CurrentSensor_newSample(uint16 sample)
+{
+	/* First order low pass filter: current += (sample - current) / 2^SHIFT */
+	g_filterSum = g_filterSum - (g_filterSum >> CURRENT_SENSOR_FILTER_SHIFT) + sample;
+	g_current = g_filterSum >> CURRENT_SENSOR_FILTER_SHIFT;
+
+	if(g_current > g_peakCurrent)
+	{
+		g_peakCurrent = g_current;
+	}
+
+	if(g_blankingSamples != 0)
+	{
+		g_blankingSamples--;
+	}
+	else if(g_current < CURRENT_SENSOR_STALL_CURRENT)
+	{
+		g_overCurrentSamples = 0;
+	}
+	else if(g_overCurrentSamples < CURRENT_SENSOR_SAMPLES(CURRENT_SENSOR_STALL_TIME_MS))
+	{
+		g_overCurrentSamples++;
+	}
+	else
+	{
+		g_stalled = TRUE;
+	}
+}
@@ -0,0 +1,89 @@
+ /******************************************************************************
+ *
+ * Module: Current Sensor
+ *
+ * File Name: current_sensor.h
+ *
+ * Description: Header file for the motor current sensor driver
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+#ifndef CURRENT_SENSOR_H_
+#define CURRENT_SENSOR_H_
+
+/*******************************************************************************
+ *                      Used Header Files                                      *
+ *******************************************************************************/
+#include "std_types.h"
+#include "adc.h"
+
+/*******************************************************************************
+ *                      Definitions                                            *
+ *******************************************************************************/
+
+/* Shunt resistor in the motor ground path, measured on ADC7 (PA7) */
+#define CURRENT_SENSOR_CHANNEL_ID        7
+#define CURRENT_SENSOR_SHUNT_MILLIOHM    500UL
+
+/* ADC configurations, ~4.8k samples per second from the internal 2.56V reference */
+#define CURRENT_SENSOR_REF_VOLT          INTERNAL_2_56V
+#define CURRENT_SENSOR_REF_MILLIVOLT     2560UL
+#define CURRENT_SENSOR_PRESCALER         ADC_F_CPU_128
+#define CURRENT_SENSOR_SAMPLE_RATE       (F_CPU / (128UL * ADC_CONVERSION_CLOCKS))
+
+/* ADC counts of a current in mA */
+#define CURRENT_SENSOR_MILLIAMPS(MA)     ((uint16)(((MA) * CURRENT_SENSOR_SHUNT_MILLIOHM * 1024UL) / (CURRENT_SENSOR_REF_MILLIVOLT * 1000UL)))
+
+/* Number of samples in a time in ms */
+#define CURRENT_SENSOR_SAMPLES(MS)       ((uint16)(((MS) * CURRENT_SENSOR_SAMPLE_RATE) / 1000UL))
+
+/* The filtered current follows the samples with a time constant of 2^SHIFT samples (~3ms) */
+#define CURRENT_SENSOR_FILTER_SHIFT      4
+
+/* The motor is stalled when the filtered current stays above the threshold for the stall time */
+#define CURRENT_SENSOR_STALL_CURRENT     CURRENT_SENSOR_MILLIAMPS(800)
+#define CURRENT_SENSOR_STALL_TIME_MS     30
+
+/* The inrush current of the motor start is not checked for a stall */
+#define CURRENT_SENSOR_BLANKING_TIME_MS  250
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*Description:
+ * Initialize the ADC for the current measurement, no sample is taken until
+ * CurrentSensor_start() is called.
+ */
+void CurrentSensor_init(void);
+
+/*Description:
+ * Start sampling the motor current in the background with a new blanking time,
+ * and clear the peak current and the stall event.
+ */
+void CurrentSensor_start(void);
+
+/*Description:
+ * Stop sampling the motor current, the last values are kept.
+ */
+void CurrentSensor_stop(void);
+
+/*Description:
+ * Return the filtered motor current in ADC counts.
+ */
+uint16 CurrentSensor_getCurrent(void);
+
+/*Description:
+ * Return the highest filtered motor current since CurrentSensor_start() in ADC counts.
+ */
+uint16 CurrentSensor_getPeakCurrent(void);
+
+/*Description:
+ * Return TRUE once the motor is stalled, the event stays raised until the next
+ * CurrentSensor_start().
+ */
+boolean CurrentSensor_isStalled(void);
+
+#endif /* CURRENT_SENSOR_H_ */
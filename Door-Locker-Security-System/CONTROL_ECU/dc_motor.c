@@ -17,7 +17,53 @@
 #include "dc_motor.h"
 #include "pwm.h"
 #include "gpio.h"
+#include "timer1.h"
 #include <avr/io.h>
+#include <avr/interrupt.h>
+
+/*******************************************************************************
+ *                                Global Variables                             *
+ *******************************************************************************/
+
+/* Selected speed profile */
+static DcMotor_RampConfigType g_ramp = {NO_RAMP,0,0};
+
+/* Direction applied on the motor pins and speed applied on the PWM */
+static volatile DcMotor_State g_state = STOP;
+static volatile uint8 g_speed = 0;
+
+/* Last requested direction and speed */
+static volatile DcMotor_State g_targetState = STOP;
+static volatile uint8 g_targetSpeed = 0;
+
+/* Current ramp segment, from the start speed to the end speed in a number of steps */
+static volatile uint8 g_segmentStartSpeed = 0;
+static volatile uint8 g_segmentEndSpeed = 0;
+static volatile uint16 g_segmentSteps = 0;
+static volatile uint16 g_segmentStep = 0;
+
+/* Timer1 subscriber id of the ramp step function */
+static volatile uint8 g_rampTickId = TIMER1_INVALID_SUBSCRIBER;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Apply the direction on the motor pins.
+ */
+static void DcMotor_setDirection(DcMotor_State state);
+
+/*
+ * Move on to the next ramp segment, or stop the ramp ticks when the requested
+ * state and speed are reached. It must be called with the interrupts disabled.
+ */
+static void DcMotor_updateRamp(void);
+
+/*
+ * Called every ramp step from the Timer1 compare B interrupt.
+ */
+static void DcMotor_rampStep(void);
 
 /*******************************************************************************
  *                                Functions Definitions                        *
@@ -38,37 +84,165 @@ void DcMotor_Init(void)
 	GPIO_writePin(DC_MOTOR_PORT_ID,DC_MOTOR_IN1_PIN_ID,LOGIC_LOW);
 	GPIO_writePin(DC_MOTOR_PORT_ID,DC_MOTOR_IN2_PIN_ID,LOGIC_LOW);
 
+	/* Start the PWM once, the speed changes only update its duty cycle */
+	PWM_init(PWM_PRESCALER(DC_MOTOR_PWM_FREQUENCY,DC_MOTOR_PWM_MODE),DC_MOTOR_PWM_MODE);
 }
 
 /*[FUNCTION NAME]	: DcMotor_Rotate
  *[DESCRIPTION]		: The function responsible for rotate the DC Motor CW/ or A-CW or
-                      stop the motor in a certain speed
- *[ARGUMENTS]		: void
- *[RETURNS]			: temperature value of type uint8
+                      stop the motor in a certain speed, following the selected ramp
+ *[ARGUMENTS]		: motor state of type DcMotor_State and speed percentage of type uint8
+ *[RETURNS]			: void
  */
 void DcMotor_Rotate(DcMotor_State state,uint8 speed)
 {
+	uint8 sreg = SREG;
+
+	cli();
+	g_targetState = state;
+	g_targetSpeed = (state == STOP) ? 0 : speed;
+
+	/* Restart from the speed reached so far */
+	g_segmentSteps = 0;
+	DcMotor_updateRamp();
+	SREG = sreg;
+}
+
+/*[FUNCTION NAME]	: DcMotor_Stop
+ *[DESCRIPTION]		: The function responsible for stopping the DC Motor at once,
+                      skipping the deceleration ramp
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: void
+ */
+void DcMotor_Stop(void)
+{
+	uint8 sreg = SREG;
+
+	cli();
+	g_targetState = STOP;
+	g_targetSpeed = 0;
+	g_speed = 0;
+	PWM_setDuty(0);
+	DcMotor_setDirection(STOP);
+
+	/* Nothing left to ramp, release the ramp ticks */
+	g_segmentSteps = 0;
+	DcMotor_updateRamp();
+	SREG = sreg;
+}
+
+/*[FUNCTION NAME]	: DcMotor_setRamp
+ *[DESCRIPTION]		: Select the speed profile used to reach a new speed
+ *[ARGUMENTS]		: pointer to the ramp configurations of type DcMotor_RampConfigType
+ *[RETURNS]			: void
+ */
+void DcMotor_setRamp(const DcMotor_RampConfigType * Config_Ptr)
+{
+	uint8 sreg = SREG;
+
+	cli();
+	g_ramp = *Config_Ptr;
+	SREG = sreg;
+}
+
+static void DcMotor_setDirection(DcMotor_State state)
+{
+	uint8 pins = 0;
+
 	switch(state)
 	{
 	case STOP:
 		/* Stop DC Motor */
-		GPIO_writePin(DC_MOTOR_PORT_ID,DC_MOTOR_IN1_PIN_ID,LOGIC_LOW);
-		GPIO_writePin(DC_MOTOR_PORT_ID,DC_MOTOR_IN2_PIN_ID,LOGIC_LOW);
+		pins = 0;
 		break;
 	case CW:
 		/* Rotate DC Motor in clockwise direction */
-		GPIO_writePin(DC_MOTOR_PORT_ID,DC_MOTOR_IN1_PIN_ID,LOGIC_LOW);
-		GPIO_writePin(DC_MOTOR_PORT_ID,DC_MOTOR_IN2_PIN_ID,LOGIC_HIGH);
+		pins = (1<<DC_MOTOR_IN2_PIN_ID);
 		break;
 	case A_CW:
 		/* Rotate DC Motor in anti-clockwise direction */
-		GPIO_writePin(DC_MOTOR_PORT_ID,DC_MOTOR_IN1_PIN_ID,LOGIC_HIGH);
-		GPIO_writePin(DC_MOTOR_PORT_ID,DC_MOTOR_IN2_PIN_ID,LOGIC_LOW);
+		pins = (1<<DC_MOTOR_IN1_PIN_ID);
 		break;
 	}
-	/* Setup Motor Speed */
-	PWM_Timer0_Start(speed);
+
+	/* Both inputs change in one port write, the other PORTB pins are kept even if an interrupt writes them */
+	GPIO_WRITE_PORT_FIELD(DC_MOTOR_PORT_ID,DC_MOTOR_PINS_MASK,pins);
+	g_state = state;
+}
+
+static void DcMotor_updateRamp(void)
+{
+	uint8 end_speed;
+	uint16 ramp_time;
+
+	/* Nothing to do while the current segment is not finished */
+	if(g_segmentStep < g_segmentSteps)
+	{
+		return;
+	}
+
+	while((g_state != g_targetState) || (g_speed != g_targetSpeed))
+	{
+		if((g_state != g_targetState) && (g_speed == 0))
+		{
+			/* The motor is at rest, the direction can be changed safely */
+			DcMotor_setDirection(g_targetState);
+			continue;
+		}
+
+		/* A change of direction slows the motor down to zero first */
+		end_speed = (g_state != g_targetState) ? 0 : g_targetSpeed;
+		ramp_time = (end_speed > g_speed) ? g_ramp.acceleration_time : g_ramp.deceleration_time;
+
+		g_segmentStartSpeed = g_speed;
+		g_segmentEndSpeed = end_speed;
+		g_segmentStep = 0;
+		g_segmentSteps = 0;
+		if(g_ramp.profile != NO_RAMP)
+		{
+			/* The segment time is proportional to the speed difference */
+			g_segmentSteps = (uint16)(((uint32)((end_speed > g_speed) ? (end_speed - g_speed) : (g_speed - end_speed)) * ramp_time) / (100UL * DC_MOTOR_RAMP_STEP_MS));
+		}
+
+		if(g_segmentSteps == 0)
+		{
+			/* Too short for a ramp, apply the speed at once */
+			g_speed = end_speed;
+			PWM_setDuty(g_speed);
+			continue;
+		}
+
+		if(g_rampTickId == TIMER1_INVALID_SUBSCRIBER)
+		{
+			g_rampTickId = Timer1_subscribe(TIMER1_COMPB_CHANNEL,DcMotor_rampStep,DC_MOTOR_RAMP_STEP_MS);
+		}
+		return;
+	}
+
+	/* The requested state and speed are reached */
+	Timer1_unsubscribe(g_rampTickId);
+	g_rampTickId = TIMER1_INVALID_SUBSCRIBER;
 }
 
+static void DcMotor_rampStep(void)
+{
+	uint32 progress;
+
+	if(g_segmentStep < g_segmentSteps)
+	{
+		g_segmentStep++;
 
+		/* Fraction of the segment done, from 0 to 256 */
+		progress = ((uint32)g_segmentStep << 8) / g_segmentSteps;
+		if(g_ramp.profile == S_CURVE_RAMP)
+		{
+			/* Smooth step 3x^2 - 2x^3, the speed changes slowly at both ends of the segment */
+			progress = (progress * progress * (768 - 2 * progress)) >> 16;
+		}
 
+		g_speed = (uint8)(g_segmentStartSpeed + (sint16)((((sint32)g_segmentEndSpeed - g_segmentStartSpeed) * (sint32)progress) >> 8));
+		PWM_setDuty(g_speed);
+	}
+
+	DcMotor_updateRamp();
+}
@@ -14,6 +14,7 @@
 #define DC_MOTOR_H_
 
 #include "std_types.h"
+#include "pwm.h"
 
 /*******************************************************************************
  *                                Definitions                                  *
@@ -21,6 +22,14 @@
 #define DC_MOTOR_PORT_ID      PORTB_ID
 #define DC_MOTOR_IN1_PIN_ID   PIN0_ID
 #define DC_MOTOR_IN2_PIN_ID   PIN1_ID
+#define DC_MOTOR_PINS_MASK    ((1<<DC_MOTOR_IN1_PIN_ID) | (1<<DC_MOTOR_IN2_PIN_ID))
+
+/* Motor PWM configurations, the phase correct mode at ~15kHz keeps the motor silent */
+#define DC_MOTOR_PWM_MODE       PWM_PHASE_CORRECT_MODE
+#define DC_MOTOR_PWM_FREQUENCY  15000UL
+
+/* Time between two speed updates of a ramp, in Timer1 fast ticks (1ms each) */
+#define DC_MOTOR_RAMP_STEP_MS 10
 
 /*******************************************************************************
  *                                Enums                                  *
@@ -29,6 +38,19 @@ typedef enum{
 	STOP,CW,A_CW
 }DcMotor_State;
 
+typedef enum{
+	NO_RAMP,TRAPEZOID_RAMP,S_CURVE_RAMP
+}DcMotor_RampProfile;
+
+/*******************************************************************************
+ *                                Structs                                      *
+ *******************************************************************************/
+typedef struct{
+	DcMotor_RampProfile profile;
+	uint16 acceleration_time; /* ms to speed up from 0 to 100% */
+	uint16 deceleration_time; /* ms to slow down from 100% to 0 */
+}DcMotor_RampConfigType;
+
 /*******************************************************************************
  *                                Functions Prototype                          *
  *******************************************************************************/
@@ -47,4 +69,18 @@ void DcMotor_Init(void);
  */
 void DcMotor_Rotate(DcMotor_State state,uint8 speed);
 
+/*Description:
+ * Stop the motor at once without the deceleration ramp, used when the door
+ * reached its end position, stalled or timed out.
+ */
+void DcMotor_Stop(void);
+
+/*Description:
+ * 1.Select the speed profile used by DcMotor_Rotate() to reach the new speed,
+ * the speed is updated from the Timer1 compare B interrupt so Timer1 must be
+ * initialized first.
+ * 2.A change of direction first slows the motor down to zero.
+ */
+void DcMotor_setRamp(const DcMotor_RampConfigType * Config_Ptr);
+
 #endif /* DC_MOTOR_H_ */
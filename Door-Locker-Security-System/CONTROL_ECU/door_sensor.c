@@ -0,0 +1,240 @@
+/******************************************************************************
+ *
+ * Module: Door Sensor
+ *
+ * File Name: door_sensor.c
+ *
+ * Description: Source file for the door limit switches and travel encoder driver
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                      Used Header Files                                      *
+ *******************************************************************************/
+
+#include "door_sensor.h"
+#include "gpio.h"
+#include "timer1.h"
+#include "common_macros.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+/*******************************************************************************
+ *                      Global Variables                                       *
+ *******************************************************************************/
+
+/* Debounced state of the limit switches, one bit per DoorSensor_LimitType */
+static volatile uint8 g_limitsReached = 0;
+
+/* Limit switches ignored until the end of their debounce time */
+static volatile uint8 g_limitsSettling = 0;
+
+/* Time stamp of the first edge of each settling limit switch */
+static volatile uint32 g_edgeTime[2];
+
+/* Timer1 subscriber id of the debounce function while a switch is settling */
+static volatile uint8 g_debounceTickId = TIMER1_INVALID_SUBSCRIBER;
+
+/* Encoder pulses and the time stamp of the last one */
+static volatile uint16 g_encoderCount = 0;
+static volatile uint32 g_lastPulseTime = 0;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Read the level of a limit switch, TRUE when it is closed.
+ */
+static boolean DoorSensor_readLimit(DoorSensor_LimitType limit);
+
+/*
+ * Report the new level of a limit switch at once and ignore it until the end
+ * of its debounce time. It is called from the INT0/INT1 interrupts.
+ */
+static void DoorSensor_limitEdge(DoorSensor_LimitType limit);
+
+/*
+ * Called every 1ms from the Timer1 compare B interrupt while a switch is settling.
+ */
+static void DoorSensor_debounce(void);
+
+/*******************************************************************************
+ *                      Interrupt Service Routines                             *
+ *******************************************************************************/
+
+ISR(INT0_vect)
+{
+	DoorSensor_limitEdge(DOOR_OPEN_LIMIT);
+}
+
+ISR(INT1_vect)
+{
+	DoorSensor_limitEdge(DOOR_CLOSED_LIMIT);
+}
+
+ISR(INT2_vect)
+{
+	uint32 time_stamp = Timer1_getTimeStamp();
+
+	if((time_stamp - g_lastPulseTime) >= TIMER1_MILLISECONDS(DOOR_SENSOR_ENCODER_MIN_PERIOD_MS))
+	{
+		g_encoderCount++;
+		g_lastPulseTime = time_stamp;
+	}
+}
+
+/*******************************************************************************
+ *                      Function Definitions                                   *
+ *******************************************************************************/
+
+/*[FUNCTION NAME]	: DoorSensor_init
+ *[DESCRIPTION]		: Function to initialize the limit switches and the encoder inputs
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: void
+ */
+void DoorSensor_init(void)
+{
+	/* Inputs with the internal pull ups enabled */
+	GPIO_setupPinDirection(DOOR_SENSOR_OPEN_PORT_ID,DOOR_SENSOR_OPEN_PIN_ID,PIN_INPUT);
+	GPIO_writePin(DOOR_SENSOR_OPEN_PORT_ID,DOOR_SENSOR_OPEN_PIN_ID,LOGIC_HIGH);
+	GPIO_setupPinDirection(DOOR_SENSOR_CLOSED_PORT_ID,DOOR_SENSOR_CLOSED_PIN_ID,PIN_INPUT);
+	GPIO_writePin(DOOR_SENSOR_CLOSED_PORT_ID,DOOR_SENSOR_CLOSED_PIN_ID,LOGIC_HIGH);
+	GPIO_setupPinDirection(DOOR_SENSOR_ENCODER_PORT_ID,DOOR_SENSOR_ENCODER_PIN_ID,PIN_INPUT);
+	GPIO_writePin(DOOR_SENSOR_ENCODER_PORT_ID,DOOR_SENSOR_ENCODER_PIN_ID,LOGIC_HIGH);
+
+	/* Initial position of the door */
+	g_limitsReached = 0;
+	if(DoorSensor_readLimit(DOOR_OPEN_LIMIT))
+	{
+		SET_BIT(g_limitsReached,DOOR_OPEN_LIMIT);
+	}
+	if(DoorSensor_readLimit(DOOR_CLOSED_LIMIT))
+	{
+		SET_BIT(g_limitsReached,DOOR_CLOSED_LIMIT);
+	}
+
+	/* INT0/INT1 on any logical change ISC00=1 ISC01=0 & ISC10=1 ISC11=0 */
+	MCUCR = (MCUCR & 0xF0) | (1<<ISC00) | (1<<ISC10);
+
+	/* INT2 on the rising edge ISC2=1, INT2 must be disabled while changing its sense */
+	CLEAR_BIT(GICR,INT2);
+	SET_BIT(MCUCSR,ISC2);
+
+	/* Clear any edge detected during the configurations then enable the interrupts */
+	GIFR = (1<<INTF0) | (1<<INTF1) | (1<<INTF2);
+	GICR |= (1<<INT0) | (1<<INT1) | (1<<INT2);
+}
+
+/*[FUNCTION NAME]	: DoorSensor_isLimitReached
+ *[DESCRIPTION]		: Function to check if the door is at an end position
+ *[ARGUMENTS]		: limit switch of type DoorSensor_LimitType
+ *[RETURNS]			: TRUE at the end position of type boolean
+ */
+boolean DoorSensor_isLimitReached(DoorSensor_LimitType limit)
+{
+	return BIT_IS_SET(g_limitsReached,limit) ? TRUE : FALSE;
+}
+
+/*[FUNCTION NAME]	: DoorSensor_getEncoderCount
+ *[DESCRIPTION]		: Function to get the encoder pulses counted since the last reset
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: number of pulses of type uint16
+ */
+uint16 DoorSensor_getEncoderCount(void)
+{
+	uint8 sreg = SREG;
+	uint16 count;
+
+	cli();
+	count = g_encoderCount;
+	SREG = sreg;
+
+	return count;
+}
+
+/*[FUNCTION NAME]	: DoorSensor_resetEncoderCount
+ *[DESCRIPTION]		: Function to count the encoder pulses from zero again
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: void
+ */
+void DoorSensor_resetEncoderCount(void)
+{
+	uint8 sreg = SREG;
+
+	cli();
+	g_encoderCount = 0;
+	SREG = sreg;
+}
+
+static boolean DoorSensor_readLimit(DoorSensor_LimitType limit)
+{
+	if(limit == DOOR_OPEN_LIMIT)
+	{
+		return (GPIO_readPin(DOOR_SENSOR_OPEN_PORT_ID,DOOR_SENSOR_OPEN_PIN_ID) == LOGIC_LOW);
+	}
+	else
+	{
+		return (GPIO_readPin(DOOR_SENSOR_CLOSED_PORT_ID,DOOR_SENSOR_CLOSED_PIN_ID) == LOGIC_LOW);
+	}
+}
+
+static void DoorSensor_limitEdge(DoorSensor_LimitType limit)
+{
+	uint8 int_bit = (limit == DOOR_OPEN_LIMIT) ? INT0 : INT1;
+
+	if(DoorSensor_readLimit(limit))
+	{
+		SET_BIT(g_limitsReached,limit);
+	}
+	else
+	{
+		CLEAR_BIT(g_limitsReached,limit);
+	}
+
+	/* Ignore the bounces until the switch is settled */
+	CLEAR_BIT(GICR,int_bit);
+	g_edgeTime[limit] = Timer1_getTimeStamp();
+	SET_BIT(g_limitsSettling,limit);
+
+	if(g_debounceTickId == TIMER1_INVALID_SUBSCRIBER)
+	{
+		g_debounceTickId = Timer1_subscribe(TIMER1_COMPB_CHANNEL,DoorSensor_debounce,1);
+	}
+}
+
+static void DoorSensor_debounce(void)
+{
+	uint32 time_stamp = Timer1_getTimeStamp();
+	uint8 limit;
+	uint8 int_bit;
+
+	for(limit = DOOR_OPEN_LIMIT ; limit <= DOOR_CLOSED_LIMIT ; limit++)
+	{
+		if(BIT_IS_SET(g_limitsSettling,limit) &&
+				((time_stamp - g_edgeTime[limit]) >= TIMER1_MILLISECONDS(DOOR_SENSOR_DEBOUNCE_MS)))
+		{
+			/* Settled, take its final level and watch its edges again */
+			if(DoorSensor_readLimit(limit))
+			{
+				SET_BIT(g_limitsReached,limit);
+			}
+			else
+			{
+				CLEAR_BIT(g_limitsReached,limit);
+			}
+			CLEAR_BIT(g_limitsSettling,limit);
+			int_bit = (limit == DOOR_OPEN_LIMIT) ? INT0 : INT1;
+			GIFR = (1<<int_bit); /* INTF0/INTF1 have the same bit numbers as INT0/INT1 */
+			SET_BIT(GICR,int_bit);
+		}
+	}
+
+	if(g_limitsSettling == 0)
+	{
+		Timer1_unsubscribe(g_debounceTickId);
+		g_debounceTickId = TIMER1_INVALID_SUBSCRIBER;
+	}
+}
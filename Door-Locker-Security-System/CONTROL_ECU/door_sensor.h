@@ -0,0 +1,81 @@
+ /******************************************************************************
+ *
+ * Module: Door Sensor
+ *
+ * File Name: door_sensor.h
+ *
+ * Description: Header file for the door limit switches and travel encoder driver
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+#ifndef DOOR_SENSOR_H_
+#define DOOR_SENSOR_H_
+
+/*******************************************************************************
+ *                      Used Header Files                                      *
+ *******************************************************************************/
+#include "std_types.h"
+
+/*******************************************************************************
+ *                      Definitions                                            *
+ *******************************************************************************/
+
+/* Limit switches, closed to ground at the end positions (internal pull ups) */
+#define DOOR_SENSOR_OPEN_PORT_ID         PORTD_ID
+#define DOOR_SENSOR_OPEN_PIN_ID          PIN2_ID   /* INT0 */
+#define DOOR_SENSOR_CLOSED_PORT_ID       PORTD_ID
+#define DOOR_SENSOR_CLOSED_PIN_ID        PIN3_ID   /* INT1 */
+
+/* Travel encoder, one rising edge per pulse */
+#define DOOR_SENSOR_ENCODER_PORT_ID      PORTB_ID
+#define DOOR_SENSOR_ENCODER_PIN_ID       PIN2_ID   /* INT2 */
+
+/* Encoder pulses of a full travel between the two limit switches */
+#define DOOR_SENSOR_TRAVEL_PULSES        200
+
+/* Time a limit switch is left to settle after its first edge */
+#define DOOR_SENSOR_DEBOUNCE_MS          20
+
+/* Encoder edges closer than this time to the previous pulse are contact bounce */
+#define DOOR_SENSOR_ENCODER_MIN_PERIOD_MS 1
+
+/*******************************************************************************
+ *                      Enums                                                  *
+ *******************************************************************************/
+typedef enum{
+	DOOR_OPEN_LIMIT, DOOR_CLOSED_LIMIT
+}DoorSensor_LimitType;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*Description:
+ * 1. Setup the limit switches and the encoder pins as inputs with pull ups.
+ * 2. Enable INT0/INT1 on any change of the limit switches and INT2 on the
+ *    encoder rising edges.
+ * The debounce uses the Timer1 time stamps and compare B ticks, so Timer1 must
+ * be initialized first.
+ */
+void DoorSensor_init(void);
+
+/*Description:
+ * Return TRUE while the door is at the required end position.
+ * A switch change is reported at its first edge, then the switch is ignored
+ * for DOOR_SENSOR_DEBOUNCE_MS and sampled again at the end of this time.
+ */
+boolean DoorSensor_isLimitReached(DoorSensor_LimitType limit);
+
+/*Description:
+ * Return the number of encoder pulses counted since the last reset.
+ */
+uint16 DoorSensor_getEncoderCount(void);
+
+/*Description:
+ * Restart counting the encoder pulses from zero.
+ */
+void DoorSensor_resetEncoderCount(void);
+
+#endif /* DOOR_SENSOR_H_ */
@@ -13,26 +13,71 @@
 #include <avr/io.h>
 #include "pwm.h"
 #include "gpio.h"
+#include "common_macros.h"
+
+/*******************************************************************************
+ *                                Global Variables                             *
+ *******************************************************************************/
+
+/* PWM mode selected in PWM_init() */
+static PWM_Mode g_mode = PWM_FAST_MODE;
 
 /*******************************************************************************
  *                                Functions Definitions                        *
  *******************************************************************************/
 
-void PWM_Timer0_Start(uint8 duty_cycle)
+void PWM_init(PWM_Prescaler prescaler, PWM_Mode mode)
 {
-	/* Configure timer control register
-	 * 1. Fast PWM mode FOC0=0
-	 * 2. Fast PWM Mode WGM01=1 & WGM00=1
-	 * 3. Clear OC0 when match occurs (non inverted mode) COM00=0 & COM01=1
-	 * 4. clock = F_CPU/8 CS00=0 CS01=1 CS02=0
-	 */
-	TCCR0 = (1<<WGM00) | (1<<WGM01) | (1<<COM01) | (1<<CS01);
+	g_mode = mode;
 
+	/* Start from a zero duty cycle */
+	OCR0 = 0;
 	TCNT0 = 0;
 
-	/* Set Compare Value */
-	OCR0  = (uint8)((uint16)(duty_cycle*255)/ 100);
+	/* Configure timer control register
+	 * 1. PWM mode FOC0=0
+	 * 2. Fast PWM Mode WGM01=1 & WGM00=1 or Phase Correct PWM Mode WGM01=0 & WGM00=1
+	 * 3. Clear OC0 when match occurs (non inverted mode) COM00=0 & COM01=1,
+	 *    in fast mode OC0 is connected by the first non zero duty cycle
+	 * 4. clock = the required prescaler CS02:0
+	 */
+	if(mode == PWM_FAST_MODE)
+	{
+		TCCR0 = (1<<WGM00) | (1<<WGM01) | prescaler;
+	}
+	else
+	{
+		TCCR0 = (1<<WGM00) | (1<<COM01) | prescaler;
+	}
 
-	/* Set OC0 -> PB3 as output pin*/
+	/* Set OC0 -> PB3 as output pin driven low while it is disconnected */
+	GPIO_writePin(PORTB_ID, PIN3_ID, LOGIC_LOW);
 	GPIO_setupPinDirection(PORTB_ID, PIN3_ID, PIN_OUTPUT);
 }
+
+void PWM_setDuty(uint8 duty_cycle)
+{
+	if(duty_cycle > 100)
+	{
+		duty_cycle = 100;
+	}
+
+	/* Scale 0 --> 100% to 0 --> 255 without a division: 100 * 653 / 256 = 255 */
+	OCR0 = (uint8)(((uint16)duty_cycle * 653) >> 8);
+
+	/*
+	 * In fast mode a zero compare value still outputs a one clock pulse every
+	 * period, so OC0 is disconnected to keep the output low for a zero duty cycle.
+	 */
+	if(g_mode == PWM_FAST_MODE)
+	{
+		if(duty_cycle == 0)
+		{
+			CLEAR_BIT(TCCR0,COM01);
+		}
+		else
+		{
+			SET_BIT(TCCR0,COM01);
+		}
+	}
+}
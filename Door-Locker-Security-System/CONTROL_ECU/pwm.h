@@ -15,13 +15,53 @@
 
 #include"std_types.h"
 
+/*******************************************************************************
+ *                                Enums                                        *
+ *******************************************************************************/
+typedef enum{
+	PWM_FAST_MODE, PWM_PHASE_CORRECT_MODE
+}PWM_Mode;
+
+/* Timer0 clock select values */
+typedef enum{
+	PWM_F_CPU_1 = 1, PWM_F_CPU_8, PWM_F_CPU_64, PWM_F_CPU_256, PWM_F_CPU_1024
+}PWM_Prescaler;
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Timer clocks in one PWM period: 256 in fast mode, up and down (510) in phase correct mode */
+#define PWM_PERIOD_CLOCKS(MODE)          (((MODE) == PWM_FAST_MODE) ? 256UL : 510UL)
+
+/* PWM frequency in Hz for a prescaler division and a mode */
+#define PWM_FREQUENCY(DIVISION,MODE)     (F_CPU / ((DIVISION) * PWM_PERIOD_CLOCKS(MODE)))
+
+/*
+ * Select at compile time the largest prescaler that still gives a PWM frequency
+ * at or above the target frequency (F_CPU/1 if none does).
+ */
+#define PWM_PRESCALER(FREQUENCY,MODE) \
+	((PWM_FREQUENCY(1024UL,MODE) >= (FREQUENCY)) ? PWM_F_CPU_1024 : \
+	 (PWM_FREQUENCY(256UL,MODE) >= (FREQUENCY))  ? PWM_F_CPU_256  : \
+	 (PWM_FREQUENCY(64UL,MODE) >= (FREQUENCY))   ? PWM_F_CPU_64   : \
+	 (PWM_FREQUENCY(8UL,MODE) >= (FREQUENCY))    ? PWM_F_CPU_8    : PWM_F_CPU_1)
+
 /*******************************************************************************
  *                                Functions Prototype                          *
  *******************************************************************************/
 
 /*Description:
- *The function responsible for trigger the Timer0 with the PWM Mode.
+ *The function responsible for starting Timer0 in the required PWM mode and frequency
+ *with a zero duty cycle, it is called once.
+ */
+void PWM_init(PWM_Prescaler prescaler, PWM_Mode mode);
+
+/*Description:
+ *The function responsible for changing the duty cycle (0 --> 100%) of the running PWM.
+ *The compare register is double buffered by the hardware in the PWM modes, so the
+ *new duty cycle starts with the next PWM period without any glitch.
  */
-void PWM_Timer0_Start(uint8 duty_cycle);
+void PWM_setDuty(uint8 duty_cycle);
 
 #endif /* PWM_H_ */
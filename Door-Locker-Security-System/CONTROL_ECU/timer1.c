@@ -16,14 +16,62 @@
 #include "timer1.h"
 #include <avr/io.h>
 #include "common_macros.h"
+#include "prof.h"
 #include <avr/interrupt.h>
 
 /*******************************************************************************
  *                                Global Variables                             *
  *******************************************************************************/
 
-/* Global variables to hold the address of the call back function in the application */
-static volatile void(*g_callBackPtr)(void) = NULL_PTR;
+/* Call back functions subscribed to the Timer1 interrupt channels */
+static Timer1_SubscriberType g_subscribers[TIMER1_MAX_SUBSCRIBERS];
+
+/* Subscriber id used by Timer1_setCallBack() */
+static uint8 g_callBackId = TIMER1_INVALID_SUBSCRIBER;
+
+/* Timer1 counts elapsed in all the completed timer periods */
+static volatile uint32 g_timeBase = 0;
+
+/* Time stamps at which the software timers expire */
+static volatile uint32 g_swTimerDeadline[TIMER1_SW_TIMERS_NUM];
+
+/* Bit mask of the running software timers */
+static volatile uint8 g_swTimersRunning = 0;
+
+#if (TIMER1_TICKLESS_MODE == FALSE)
+/* TRUE while the compare B match is armed at a software timer deadline, not at the subscribers period */
+static volatile boolean g_compBWake = FALSE;
+#endif
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+#if (TIMER1_TICKLESS_MODE == TRUE)
+/*
+ * Program the compare A unit to interrupt at the nearest software timer deadline.
+ * It must be called with the interrupts disabled.
+ */
+static void Timer1_armNextDeadline(void);
+#else
+/*
+ * Program the compare B unit to wake the CPU at the nearest software timer
+ * deadline of the current compare A period, used while compare B has no subscribers.
+ * It must be called with the interrupts disabled.
+ */
+static void Timer1_armSwTimerWake(void);
+#endif
+
+/*
+ * Call every subscriber of the channel whose divider count is reached.
+ */
+static void Timer1_dispatch(Timer1_Channel channel);
+
+/*
+ * Enable the interrupt of the channel only while it has subscribers.
+ * It must be called with the interrupts disabled.
+ */
+static void Timer1_updateChannelInterrupt(Timer1_Channel channel);
 
 /*******************************************************************************
  *                       Interrupt Service Routines                            *
@@ -31,18 +79,53 @@ static volatile void(*g_callBackPtr)(void) = NULL_PTR;
 
 ISR(TIMER1_COMPA_vect)
 {
-	if(g_callBackPtr != NULL_PTR)
+#if (TIMER1_TICKLESS_MODE == TRUE)
+	/* A software timer deadline is reached, wait for the next one */
+	Timer1_armNextDeadline();
+#else
+	/* One more CTC period (0 --> OCR1A) is completed */
+	g_timeBase += (uint32)OCR1A + 1;
+
+	/* The nearest deadline may be in the new period */
+	Timer1_updateChannelInterrupt(TIMER1_COMPB_CHANNEL);
+#endif
+
+	Timer1_dispatch(TIMER1_COMPA_CHANNEL);
+}
+
+ISR(TIMER1_COMPB_vect)
+{
+	uint16 next_match = OCR1B + TIMER1_COMPB_PERIOD;
+
+	/* Keep the same period across the counter wrap, the CTC mode wraps after OCR1A */
+	if(BIT_IS_SET(TCCR1B,WGM12) && ((next_match > OCR1A) || (next_match < OCR1B)))
+	{
+		next_match -= OCR1A + 1;
+	}
+	OCR1B = next_match;
+
+	Timer1_dispatch(TIMER1_COMPB_CHANNEL);
+
+#if (TIMER1_TICKLESS_MODE == FALSE)
+	/* A software timer deadline is reached, wait for the next one */
+	if(g_compBWake)
 	{
-		(*g_callBackPtr)();
+		Timer1_armSwTimerWake();
 	}
+#endif
 }
 
 ISR(TIMER1_OVF_vect)
 {
-	if(g_callBackPtr != NULL_PTR)
-	{
-		(*g_callBackPtr)();
-	}
+	/* One more normal mode period (0 --> 0xFFFF) is completed */
+	g_timeBase += 0x10000UL;
+
+#if (TIMER1_TICKLESS_MODE == TRUE)
+	/* The nearest deadline may be in the new period */
+	Timer1_armNextDeadline();
+#endif
+
+	Timer1_dispatch(TIMER1_OVF_CHANNEL);
 }
 
 /*******************************************************************************
@@ -68,26 +151,378 @@ void Timer1_init(const Timer1_ConfigType * Config_Ptr){
 		TCCR1B = (Config_Ptr->prescaler);
 	}
 	TCNT1 = Config_Ptr->initial_value;
+
+	/* Start counting the time base from the initial value */
+	g_timeBase = 0;
 }
 
 void Timer1_deInit(void)
 {
+	uint8 id;
+
 	/* Clear all initialized registers */
 	TCCR1A = 0;
 	TCCR1B = 0;
 	TCNT1 = 0;
 	OCR1A = 0;
-
-	/* Reset the global pointer value */
-	g_callBackPtr = NULL_PTR;
+	OCR1B = 0;
+	g_timeBase = 0;
 
 	/* Disable Interrupts */
 	CLEAR_BIT(TIMSK,OCIE1A);
+	CLEAR_BIT(TIMSK,OCIE1B);
 	CLEAR_BIT(TIMSK,TOIE1);
+
+	/* Remove all the subscribers */
+	for(id = 0 ; id < TIMER1_MAX_SUBSCRIBERS ; id++)
+	{
+		g_subscribers[id].callBackPtr = NULL_PTR;
+	}
+	g_callBackId = TIMER1_INVALID_SUBSCRIBER;
+#if (TIMER1_TICKLESS_MODE == FALSE)
+	g_compBWake = FALSE;
+#endif
 }
 
 void Timer1_setCallBack(void(*a_ptr)(void))
 {
-	g_callBackPtr = a_ptr;
+	/* The call back follows the interrupt of the configured mode like before */
+	Timer1_unsubscribe(g_callBackId);
+	g_callBackId = Timer1_subscribe(BIT_IS_SET(TCCR1B,WGM12) ? TIMER1_COMPA_CHANNEL : TIMER1_OVF_CHANNEL, a_ptr, 1);
+}
+
+uint8 Timer1_subscribe(Timer1_Channel channel, void(*a_ptr)(void), uint8 divider)
+{
+	uint8 sreg = SREG;
+	uint8 id;
+
+	if((a_ptr == NULL_PTR) || (divider == 0))
+	{
+		return TIMER1_INVALID_SUBSCRIBER;
+	}
+
+	/*
+	 * Compare A only interrupts in CTC mode and the overflow only in NORMAL mode,
+	 * the tickless compare A match belongs to the software timers.
+	 */
+	if(((channel == TIMER1_COMPA_CHANNEL) && BIT_IS_CLEAR(TCCR1B,WGM12)) ||
+			((channel == TIMER1_OVF_CHANNEL) && BIT_IS_SET(TCCR1B,WGM12)) ||
+			(channel > TIMER1_OVF_CHANNEL))
+	{
+		return TIMER1_INVALID_SUBSCRIBER;
+	}
+
+	cli();
+	for(id = 0 ; id < TIMER1_MAX_SUBSCRIBERS ; id++)
+	{
+		if(g_subscribers[id].callBackPtr == NULL_PTR)
+		{
+			g_subscribers[id].channel = channel;
+			g_subscribers[id].divider = divider;
+			g_subscribers[id].count = 0;
+			g_subscribers[id].callBackPtr = a_ptr;
+			Timer1_updateChannelInterrupt(channel);
+			break;
+		}
+	}
+	SREG = sreg;
+
+	return (id < TIMER1_MAX_SUBSCRIBERS) ? id : TIMER1_INVALID_SUBSCRIBER;
+}
+
+void Timer1_unsubscribe(uint8 subscriber_id)
+{
+	uint8 sreg = SREG;
+
+	if(subscriber_id >= TIMER1_MAX_SUBSCRIBERS)
+	{
+		/* Do Nothing */
+	}
+	else
+	{
+		cli();
+		g_subscribers[subscriber_id].callBackPtr = NULL_PTR;
+		Timer1_updateChannelInterrupt(g_subscribers[subscriber_id].channel);
+		SREG = sreg;
+	}
+}
+
+uint32 Timer1_getTimeStamp(void)
+{
+	uint8 sreg = SREG;
+	uint32 time_stamp;
+	uint16 count;
+
+	/* Read the time base and the counter as one unit */
+	cli();
+	time_stamp = g_timeBase;
+	count = TCNT1;
+
+	/*
+	 * The period may have completed after the interrupts were disabled, in this
+	 * case its interrupt is still pending and not yet added to the time base.
+	 * Re-read the counter to know on which side of the wrap it was read.
+	 */
+	if(BIT_IS_SET(TCCR1B,WGM12))
+	{
+		if(BIT_IS_SET(TIFR,OCF1A))
+		{
+			count = TCNT1;
+			if(count != OCR1A)
+			{
+				time_stamp += (uint32)OCR1A + 1;
+			}
+		}
+	}
+	else if(BIT_IS_SET(TIFR,TOV1))
+	{
+		count = TCNT1;
+		time_stamp += 0x10000UL;
+	}
+
+	SREG = sreg;
+
+	return time_stamp + count;
 }
 
+void Timer1_startSwTimer(uint8 timer_id, uint32 timeout)
+{
+	uint8 sreg = SREG;
+
+	if(timer_id >= TIMER1_SW_TIMERS_NUM)
+	{
+		/* Do Nothing */
+	}
+	else
+	{
+		cli();
+		g_swTimerDeadline[timer_id] = Timer1_getTimeStamp() + timeout;
+		SET_BIT(g_swTimersRunning,timer_id);
+#if (TIMER1_TICKLESS_MODE == TRUE)
+		Timer1_armNextDeadline();
+#else
+		Timer1_updateChannelInterrupt(TIMER1_COMPB_CHANNEL);
+#endif
+		SREG = sreg;
+	}
+}
+
+void Timer1_stopSwTimer(uint8 timer_id)
+{
+	uint8 sreg = SREG;
+
+	if(timer_id >= TIMER1_SW_TIMERS_NUM)
+	{
+		/* Do Nothing */
+	}
+	else
+	{
+		cli();
+		CLEAR_BIT(g_swTimersRunning,timer_id);
+#if (TIMER1_TICKLESS_MODE == TRUE)
+		Timer1_armNextDeadline();
+#else
+		Timer1_updateChannelInterrupt(TIMER1_COMPB_CHANNEL);
+#endif
+		SREG = sreg;
+	}
+}
+
+boolean Timer1_isSwTimerExpired(uint8 timer_id)
+{
+	uint8 sreg = SREG;
+	boolean expired = TRUE;
+
+	if(timer_id >= TIMER1_SW_TIMERS_NUM)
+	{
+		/* Do Nothing */
+	}
+	else
+	{
+		cli();
+		if(BIT_IS_SET(g_swTimersRunning,timer_id))
+		{
+			/* The signed difference keeps the comparison right when the time stamp wraps */
+			if((sint32)(Timer1_getTimeStamp() - g_swTimerDeadline[timer_id]) >= 0)
+			{
+				CLEAR_BIT(g_swTimersRunning,timer_id);
+			}
+			else
+			{
+				expired = FALSE;
+			}
+		}
+		SREG = sreg;
+	}
+	return expired;
+}
+
+#if (TIMER1_TICKLESS_MODE == TRUE)
+static void Timer1_armNextDeadline(void)
+{
+	uint32 now = Timer1_getTimeStamp();
+	uint32 nearest_remaining = 0xFFFFFFFFUL;
+	uint32 remaining;
+	uint32 deadline;
+	uint8 timer_id;
+
+	for(timer_id = 0 ; timer_id < TIMER1_SW_TIMERS_NUM ; timer_id++)
+	{
+		if(BIT_IS_SET(g_swTimersRunning,timer_id))
+		{
+			remaining = g_swTimerDeadline[timer_id] - now;
+
+			/*
+			 * A passed deadline needs no interrupt, the CPU is awake and the
+			 * waiting code will find the timer expired on its next check.
+			 */
+			if(((sint32)remaining > 0) && (remaining < nearest_remaining))
+			{
+				nearest_remaining = remaining;
+			}
+		}
+	}
+
+	/*
+	 * The compare unit can only catch a deadline in the current counter period,
+	 * a later deadline is armed by the overflow interrupt of its own period.
+	 */
+	if((nearest_remaining != 0xFFFFFFFFUL) && (((now + nearest_remaining) - g_timeBase) <= 0xFFFFUL))
+	{
+		deadline = now + nearest_remaining;
+		TIFR = (1 << OCF1A); /* Clear any old compare match */
+		OCR1A = (uint16)deadline;
+
+		/*
+		 * The counter may have gone past the deadline before OCR1A was written, then
+		 * no match would come before the counter wraps. The flag can't be set by
+		 * the software, so ask for a match at the next counter tick instead.
+		 */
+		while(BIT_IS_CLEAR(TIFR,OCF1A) && ((sint32)(Timer1_getTimeStamp() - deadline) >= 0))
+		{
+			deadline = Timer1_getTimeStamp() + 1;
+			OCR1A = (uint16)deadline;
+		}
+		SET_BIT(TIMSK,OCIE1A);
+	}
+	else
+	{
+		CLEAR_BIT(TIMSK,OCIE1A);
+	}
+}
+#else
+static void Timer1_armSwTimerWake(void)
+{
+	uint32 now = Timer1_getTimeStamp();
+	uint32 nearest_remaining = 0xFFFFFFFFUL;
+	uint32 remaining;
+	uint32 deadline;
+	uint8 timer_id;
+
+	for(timer_id = 0 ; timer_id < TIMER1_SW_TIMERS_NUM ; timer_id++)
+	{
+		if(BIT_IS_SET(g_swTimersRunning,timer_id))
+		{
+			/* A passed deadline needs no interrupt, the waiting code finds it on its next check */
+			remaining = g_swTimerDeadline[timer_id] - now;
+			if(((sint32)remaining > 0) && (remaining < nearest_remaining))
+			{
+				nearest_remaining = remaining;
+			}
+		}
+	}
+
+	/*
+	 * The compare B unit can only catch a deadline in the current compare A period,
+	 * a later deadline is armed by the compare A interrupt of its own period.
+	 */
+	deadline = now + nearest_remaining;
+	if((nearest_remaining != 0xFFFFFFFFUL) && ((deadline - g_timeBase) <= OCR1A))
+	{
+		TIFR = (1 << OCF1B); /* Clear any old compare match */
+		OCR1B = (uint16)(deadline - g_timeBase);
+
+		/* The counter may have gone past the deadline before OCR1B was written */
+		while(BIT_IS_CLEAR(TIFR,OCF1B) && ((sint32)(Timer1_getTimeStamp() - deadline) >= 0))
+		{
+			deadline = Timer1_getTimeStamp() + 1;
+			OCR1B = (uint16)(deadline - g_timeBase);
+		}
+		g_compBWake = TRUE;
+		SET_BIT(TIMSK,OCIE1B);
+	}
+	else
+	{
+		g_compBWake = FALSE;
+		CLEAR_BIT(TIMSK,OCIE1B);
+	}
+}
+#endif
+
+static void Timer1_dispatch(Timer1_Channel channel)
+{
+	uint8 id;
+
+	PROF_BEGIN(PROF_ID_TIMER1_CALLBACK);
+	for(id = 0 ; id < TIMER1_MAX_SUBSCRIBERS ; id++)
+	{
+		if((g_subscribers[id].callBackPtr != NULL_PTR) && (g_subscribers[id].channel == channel))
+		{
+			g_subscribers[id].count++;
+			if(g_subscribers[id].count >= g_subscribers[id].divider)
+			{
+				g_subscribers[id].count = 0;
+				(*g_subscribers[id].callBackPtr)();
+			}
+		}
+	}
+	PROF_END(PROF_ID_TIMER1_CALLBACK);
+}
+
+static void Timer1_updateChannelInterrupt(Timer1_Channel channel)
+{
+	uint8 id;
+	boolean used = FALSE;
+
+	for(id = 0 ; id < TIMER1_MAX_SUBSCRIBERS ; id++)
+	{
+		if((g_subscribers[id].callBackPtr != NULL_PTR) && (g_subscribers[id].channel == channel))
+		{
+			used = TRUE;
+		}
+	}
+
+	/*
+	 * Only the compare B interrupt belongs to the subscribers alone, the compare A
+	 * and the overflow interrupts are driven by the time base configuration. Without
+	 * the tickless mode compare B also wakes the CPU at the software timer deadlines.
+	 */
+	if(channel == TIMER1_COMPB_CHANNEL)
+	{
+#if (TIMER1_TICKLESS_MODE == FALSE)
+		if(used && (BIT_IS_CLEAR(TIMSK,OCIE1B) || g_compBWake))
+		{
+			g_compBWake = FALSE;
+#else
+		if(used && BIT_IS_CLEAR(TIMSK,OCIE1B))
+		{
+#endif
+			/* Start the periodic compare B match one period from now */
+			OCR1B = TCNT1 + TIMER1_COMPB_PERIOD;
+			if(BIT_IS_SET(TCCR1B,WGM12) && (OCR1B > OCR1A))
+			{
+				OCR1B -= OCR1A + 1;
+			}
+			TIFR = (1 << OCF1B); /* Clear any old compare match */
+			SET_BIT(TIMSK,OCIE1B);
+		}
+		else if(!used)
+		{
+#if (TIMER1_TICKLESS_MODE == FALSE)
+			Timer1_armSwTimerWake();
+#else
+			CLEAR_BIT(TIMSK,OCIE1B);
+#endif
+		}
+	}
+}
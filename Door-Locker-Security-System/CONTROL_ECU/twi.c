@@ -16,6 +16,20 @@
 #include "twi.h"
 #include <avr/io.h>
 #include "common_macros.h"
+#include "power.h"
+
+/*******************************************************************************
+ *                       Interrupt Service Routines                            *
+ *******************************************************************************/
+
+ISR(TWI_vect)
+{
+	/*
+	 * Only used to wake the CPU up from sleep, disable the interrupt without
+	 * writing one to TWINT as that would start the next bus operation.
+	 */
+	TWCR = (1 << TWEN);
+}
 
 /*******************************************************************************
  *                      Functions Definitions                                  *
@@ -40,11 +54,12 @@ void TWI_start(void)
 	 * Clear the TWINT flag before sending the start bit TWINT=1
 	 * send the start bit by TWSTA=1
 	 * Enable TWI Module TWEN=1
+	 * Enable TWI Interrupt to wake up from sleep TWIE=1
 	 */
-    TWCR = (1 << TWINT) | (1 << TWSTA) | (1 << TWEN);
+    TWCR = (1 << TWINT) | (1 << TWSTA) | (1 << TWEN) | (1 << TWIE);
 
-    /* Wait for TWINT flag set in TWCR Register (start bit is send successfully) */
-    while(BIT_IS_CLEAR(TWCR,TWINT));
+    /* Sleep until TWINT flag set in TWCR Register (start bit is send successfully) */
+    POWER_WAIT_WHILE(BIT_IS_CLEAR(TWCR,TWINT));
 }
 
 void TWI_stop(void)
@@ -64,10 +79,11 @@ void TWI_writeByte(uint8 data)
     /*
 	 * Clear the TWINT flag before sending the data TWINT=1
 	 * Enable TWI Module TWEN=1
+	 * Enable TWI Interrupt to wake up from sleep TWIE=1
 	 */
-    TWCR = (1 << TWINT) | (1 << TWEN);
-    /* Wait for TWINT flag set in TWCR Register(data is send successfully) */
-    while(BIT_IS_CLEAR(TWCR,TWINT));
+    TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWIE);
+    /* Sleep until TWINT flag set in TWCR Register(data is send successfully) */
+    POWER_WAIT_WHILE(BIT_IS_CLEAR(TWCR,TWINT));
 }
 
 uint8 TWI_readByteWithACK(void)
@@ -76,10 +92,11 @@ uint8 TWI_readByteWithACK(void)
 	 * Clear the TWINT flag before reading the data TWINT=1
 	 * Enable sending ACK after reading or receiving data TWEA=1
 	 * Enable TWI Module TWEN=1
+	 * Enable TWI Interrupt to wake up from sleep TWIE=1
 	 */
-    TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWEA);
-    /* Wait for TWINT flag set in TWCR Register (data received successfully) */
-    while(BIT_IS_CLEAR(TWCR,TWINT));
+    TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWEA) | (1 << TWIE);
+    /* Sleep until TWINT flag set in TWCR Register (data received successfully) */
+    POWER_WAIT_WHILE(BIT_IS_CLEAR(TWCR,TWINT));
     /* Read Data */
     return TWDR;
 }
@@ -89,10 +106,11 @@ uint8 TWI_readByteWithNACK(void)
 	/*
 	 * Clear the TWINT flag before reading the data TWINT=1
 	 * Enable TWI Module TWEN=1
+	 * Enable TWI Interrupt to wake up from sleep TWIE=1
 	 */
-    TWCR = (1 << TWINT) | (1 << TWEN);
-    /* Wait for TWINT flag set in TWCR Register (data received successfully) */
-    while(BIT_IS_CLEAR(TWCR,TWINT));
+    TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWIE);
+    /* Sleep until TWINT flag set in TWCR Register (data received successfully) */
+    POWER_WAIT_WHILE(BIT_IS_CLEAR(TWCR,TWINT));
     /* Read Data */
     return TWDR;
 }
@@ -17,6 +17,25 @@
 #include "uart.h"
 #include <avr/io.h>
 #include "common_macros.h"
+#include "power.h"
+
+/*******************************************************************************
+ *                       Interrupt Service Routines                            *
+ *******************************************************************************/
+
+/*
+ * The UART interrupts are only used to wake the CPU up from sleep, the data is
+ * handled by the waiting function so each interrupt disables itself.
+ */
+ISR(USART_RXC_vect)
+{
+	CLEAR_BIT(UCSRB,RXCIE);
+}
+
+ISR(USART_UDRE_vect)
+{
+	CLEAR_BIT(UCSRB,UDRIE);
+}
 
 /*******************************************************************************
  *                      Functions Definitions                                  *
@@ -81,8 +100,9 @@ void UART_init(const UART_ConfigType *uartConfig_ptr)
 void UART_sendByte(const uint8 data)
 {
 	/* UDRE flag is set when the Tx buffer (UDR) is empty and ready for
-	 * transmitting a new byte so wait until this flag is set to one */
-	while(BIT_IS_CLEAR(UCSRA,UDRE));
+	 * transmitting a new byte so sleep until this flag is set to one */
+	SET_BIT(UCSRB,UDRIE);
+	POWER_WAIT_WHILE(BIT_IS_CLEAR(UCSRA,UDRE));
 
 	/* Put the required data in the UDR register and it also clear the UDR slag
 	 * as the UDR register is not empty now */
@@ -97,8 +117,9 @@ void UART_sendByte(const uint8 data)
 
 uint8 UART_recieveByte(void)
 {
-	/* RXC flag is set when the UART receive data so wait until this flag is set to one */
-	while(BIT_IS_CLEAR(UCSRA,RXC));
+	/* RXC flag is set when the UART receive data so sleep until this flag is set to one */
+	SET_BIT(UCSRB,RXCIE);
+	POWER_WAIT_WHILE(BIT_IS_CLEAR(UCSRA,RXC));
 
 	/* Read the received data from the Rx buffer (UDR)
 	 * the RXC flag will be cleared after read the data */
@@ -8,6 +8,8 @@ C_SRCS += \
 ../hmi_mcu.c \
 ../keypad.c \
 ../lcd.c \
+../power.c \
+../prof.c \
 ../timer1.c \
 ../uart.c 
 
@@ -16,6 +18,8 @@ OBJS += \
 ./hmi_mcu.o \
 ./keypad.o \
 ./lcd.o \
+./power.o \
+./prof.o \
 ./timer1.o \
 ./uart.o 
 
@@ -24,6 +28,8 @@ C_DEPS += \
 ./hmi_mcu.d \
 ./keypad.d \
 ./lcd.d \
+./power.d \
+./prof.d \
 ./timer1.d \
 ./uart.d 
 
@@ -12,6 +12,22 @@
 
 #include "gpio.h"
 #include "avr/io.h" /* To use the IO Ports Registers */
+#include <avr/interrupt.h>
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Write the value on the register bits selected by the mask. The interrupts are
+ * disabled only for the read, modify and write of the register, so an interrupt
+ * writing the other bits of the same register can not be undone.
+ */
+static void GPIO_atomicUpdate(volatile uint8 *reg, uint8 mask, uint8 value);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
 
 /*[FUNCTION NAME]	: GPIO_setupPinDirection
  *[DESCRIPTION]		: Setup the direction of the required pin input/output.
@@ -34,50 +50,8 @@ void GPIO_setupPinDirection(uint8 port_num, uint8 pin_num, GPIO_PinDirectionType
 	}
 	else
 	{
-		/* Setup the pin direction as required */
-		switch(port_num)
-		{
-		case PORTA_ID:
-			if(direction == PIN_OUTPUT)
-			{
-				SET_BIT(DDRA,pin_num);
-			}
-			else
-			{
-				CLEAR_BIT(DDRA,pin_num);
-			}
-			break;
-		case PORTB_ID:
-			if(direction == PIN_OUTPUT)
-			{
-				SET_BIT(DDRB,pin_num);
-			}
-			else
-			{
-				CLEAR_BIT(DDRB,pin_num);
-			}
-			break;
-		case PORTC_ID:
-			if(direction == PIN_OUTPUT)
-			{
-				SET_BIT(DDRC,pin_num);
-			}
-			else
-			{
-				CLEAR_BIT(DDRC,pin_num);
-			}
-			break;
-		case PORTD_ID:
-			if(direction == PIN_OUTPUT)
-			{
-				SET_BIT(DDRD,pin_num);
-			}
-			else
-			{
-				CLEAR_BIT(DDRD,pin_num);
-			}
-			break;
-		}
+		/* Setup the pin direction as required, the other pins may be changed by an interrupt */
+		GPIO_atomicUpdate(&GPIO_DDR_REGISTER(port_num),(1<<pin_num),(direction == PIN_OUTPUT) ? 0xFF : 0x00);
 	}
 }
 
@@ -102,50 +76,8 @@ void GPIO_writePin(uint8 port_num, uint8 pin_num, uint8 value)
 	}
 	else
 	{
-		/* Write the pin value as required */
-		switch(port_num)
-		{
-		case PORTA_ID:
-			if(value == LOGIC_HIGH)
-			{
-				SET_BIT(PORTA,pin_num);
-			}
-			else
-			{
-				CLEAR_BIT(PORTA,pin_num);
-			}
-			break;
-		case PORTB_ID:
-			if(value == LOGIC_HIGH)
-			{
-				SET_BIT(PORTB,pin_num);
-			}
-			else
-			{
-				CLEAR_BIT(PORTB,pin_num);
-			}
-			break;
-		case PORTC_ID:
-			if(value == LOGIC_HIGH)
-			{
-				SET_BIT(PORTC,pin_num);
-			}
-			else
-			{
-				CLEAR_BIT(PORTC,pin_num);
-			}
-			break;
-		case PORTD_ID:
-			if(value == LOGIC_HIGH)
-			{
-				SET_BIT(PORTD,pin_num);
-			}
-			else
-			{
-				CLEAR_BIT(PORTD,pin_num);
-			}
-			break;
-		}
+		/* Write the pin value as required, the other pins may be changed by an interrupt */
+		GPIO_atomicUpdate(&GPIO_PORT_REGISTER(port_num),(1<<pin_num),(value == LOGIC_HIGH) ? 0xFF : 0x00);
 	}
 }
 
@@ -339,3 +271,137 @@ uint8 GPIO_readPort(uint8 port_num)
 
 	return value;
 }
+
+/*[FUNCTION NAME]	: GPIO_setupPortDirectionMasked
+ *[DESCRIPTION]		: Setup the direction of the port pins selected by the mask.
+                      The other pins of the port keep their direction.
+                      If the input port number is not correct, The function will not handle the request.
+ *[ARGUMENTS]		: port number and pins mask of type uint8 and port direction
+                      of type GPIO_PortDirectionType
+ *[RETURNS]			: void
+ */
+void GPIO_setupPortDirectionMasked(uint8 port_num, uint8 mask, GPIO_PortDirectionType direction)
+{
+	/*
+	 * Check if the input number is greater than NUM_OF_PORTS value.
+	 * In this case the input is not valid port number
+	 */
+	if(port_num >= NUM_OF_PORTS)
+	{
+		/* Do Nothing */
+	}
+	else
+	{
+		/* Setup the direction of the masked pins only */
+		GPIO_atomicUpdate(&GPIO_DDR_REGISTER(port_num),mask,direction);
+	}
+}
+
+/*[FUNCTION NAME]	: GPIO_writePortMasked
+ *[DESCRIPTION]		: Write the value on the port pins selected by the mask in one port update.
+                      The other pins of the port keep their value.
+                      If the input port number is not correct, The function will not handle the request.
+ *[ARGUMENTS]		: port number, pins mask and value of type uint8
+ *[RETURNS]			: void
+ */
+void GPIO_writePortMasked(uint8 port_num, uint8 mask, uint8 value)
+{
+	/*
+	 * Check if the input number is greater than NUM_OF_PORTS value.
+	 * In this case the input is not valid port number
+	 */
+	if(port_num >= NUM_OF_PORTS)
+	{
+		/* Do Nothing */
+	}
+	else
+	{
+		/* Write the masked pins only */
+		GPIO_atomicUpdate(&GPIO_PORT_REGISTER(port_num),mask,value);
+	}
+}
+
+/*[FUNCTION NAME]	: GPIO_setPortBits
+ *[DESCRIPTION]		: Set the port pins selected by the mask to Logic High, safe against
+                      the interrupts writing the other pins of the port.
+                      If the input port number is not correct, The function will not handle the request.
+ *[ARGUMENTS]		: port number and pins mask of type uint8
+ *[RETURNS]			: void
+ */
+void GPIO_setPortBits(uint8 port_num, uint8 mask)
+{
+	if(port_num < NUM_OF_PORTS)
+	{
+		GPIO_atomicUpdate(&GPIO_PORT_REGISTER(port_num),mask,0xFF);
+	}
+}
+
+/*[FUNCTION NAME]	: GPIO_clearPortBits
+ *[DESCRIPTION]		: Clear the port pins selected by the mask to Logic Low, safe against
+                      the interrupts writing the other pins of the port.
+                      If the input port number is not correct, The function will not handle the request.
+ *[ARGUMENTS]		: port number and pins mask of type uint8
+ *[RETURNS]			: void
+ */
+void GPIO_clearPortBits(uint8 port_num, uint8 mask)
+{
+	if(port_num < NUM_OF_PORTS)
+	{
+		GPIO_atomicUpdate(&GPIO_PORT_REGISTER(port_num),mask,0x00);
+	}
+}
+
+/*[FUNCTION NAME]	: GPIO_togglePortBits
+ *[DESCRIPTION]		: Toggle the port pins selected by the mask, safe against the
+                      interrupts writing the other pins of the port.
+                      If the input port number is not correct, The function will not handle the request.
+ *[ARGUMENTS]		: port number and pins mask of type uint8
+ *[RETURNS]			: void
+ */
+void GPIO_togglePortBits(uint8 port_num, uint8 mask)
+{
+	volatile uint8 *reg;
+	uint8 sreg;
+
+	if(port_num < NUM_OF_PORTS)
+	{
+		reg = &GPIO_PORT_REGISTER(port_num);
+
+		/* The ATmega32 has no toggle by writing PINx, the toggle is a read, modify and write */
+		sreg = SREG;
+		cli();
+		*reg ^= mask;
+		SREG = sreg;
+	}
+}
+
+/*[FUNCTION NAME]	: GPIO_writePortField
+ *[DESCRIPTION]		: Write a value on a field of consecutive port pins, safe against
+                      the interrupts writing the other pins of the port.
+                      If the input port number or the field are not correct, The function will not handle the request.
+ *[ARGUMENTS]		: port number, first pin number, number of pins and the field value of type uint8
+ *[RETURNS]			: void
+ */
+void GPIO_writePortField(uint8 port_num, uint8 first_pin_num, uint8 pins_num, uint8 value)
+{
+	uint8 mask;
+
+	if((port_num < NUM_OF_PORTS) && (pins_num != 0) && ((first_pin_num + pins_num) <= NUM_OF_PINS_PER_PORT))
+	{
+		/* The mask and the shift are ready before the interrupts are disabled */
+		mask = (uint8)((0xFF >> (NUM_OF_PINS_PER_PORT - pins_num)) << first_pin_num);
+		GPIO_atomicUpdate(&GPIO_PORT_REGISTER(port_num),mask,(uint8)(value << first_pin_num));
+	}
+}
+
+static void GPIO_atomicUpdate(volatile uint8 *reg, uint8 mask, uint8 value)
+{
+	uint8 sreg = SREG;
+
+	/* Only the read, modify and write of the register runs with the interrupts disabled */
+	value &= mask;
+	mask = ~mask;
+	cli();
+	*reg = (*reg & mask) | value;
+	SREG = sreg;
+}
@@ -15,6 +15,8 @@
 
 #include"std_types.h"
 #include"common_macros.h"
+#include<avr/io.h>
+#include<avr/interrupt.h>
 
 /*******************************************************************************
  *                                Definitions                                  *
@@ -37,6 +39,102 @@
 #define PIN6_ID                6
 #define PIN7_ID                7
 
+/*
+ * TRUE : the constant port macros below access the registers directly.
+ * FALSE: they call the GPIO functions, to measure what the macros save with the
+ *        profiling builds ("make bench-gpio" in the HOST folder).
+ */
+#ifndef GPIO_CONSTANT_MACROS
+#define GPIO_CONSTANT_MACROS   TRUE
+#endif
+
+/*
+ * Registers of a port selected by its ID. With a constant port ID the selection
+ * is folded by the compiler and, in the optimized builds, the macros below compile
+ * to single instructions (sbi/cbi for a pin write or direction, sbic/sbis for a
+ * pin read). The GPIO functions are kept for the port and pin IDs known only at
+ * run time, the macros do not check the IDs.
+ */
+#define GPIO_PORT_REGISTER(PORT_ID)  (*((PORT_ID) == PORTA_ID ? &PORTA : (PORT_ID) == PORTB_ID ? &PORTB : \
+                                       (PORT_ID) == PORTC_ID ? &PORTC : &PORTD))
+#define GPIO_DDR_REGISTER(PORT_ID)   (*((PORT_ID) == PORTA_ID ? &DDRA : (PORT_ID) == PORTB_ID ? &DDRB : \
+                                       (PORT_ID) == PORTC_ID ? &DDRC : &DDRD))
+#define GPIO_PIN_REGISTER(PORT_ID)   (*((PORT_ID) == PORTA_ID ? &PINA : (PORT_ID) == PORTB_ID ? &PINB : \
+                                       (PORT_ID) == PORTC_ID ? &PINC : &PIND))
+
+/*
+ * Port bits operations safe against the interrupts writing the other pins of the
+ * same port. One constant bit of a constant port is set or cleared with sbi/cbi,
+ * which can not be interrupted, once the build is optimized. Any other update is
+ * a read, modify and write done with the interrupts disabled.
+ */
+#define GPIO_ATOMIC(STATEMENT) \
+	do{ uint8 gpio_sreg = SREG; cli(); STATEMENT; SREG = gpio_sreg; }while(0)
+#define GPIO_IS_ONE_BIT(MASK)        (((MASK) & ((MASK) - 1)) == 0)
+#ifdef __OPTIMIZE__
+#define GPIO_IS_SBI_CBI(PORT_ID,MASK) \
+	(__builtin_constant_p(PORT_ID) && __builtin_constant_p(MASK) && GPIO_IS_ONE_BIT(MASK))
+#else
+#define GPIO_IS_SBI_CBI(PORT_ID,MASK) FALSE
+#endif
+#define GPIO_REGISTER_SET_BITS(REG,PORT_ID,MASK) \
+	do{ if(GPIO_IS_SBI_CBI(PORT_ID,MASK)) (REG) |= (MASK); \
+		else GPIO_ATOMIC((REG) |= (MASK)); }while(0)
+#define GPIO_REGISTER_CLEAR_BITS(REG,PORT_ID,MASK) \
+	do{ if(GPIO_IS_SBI_CBI(PORT_ID,MASK)) (REG) &= ~(MASK); \
+		else GPIO_ATOMIC((REG) &= ~(MASK)); }while(0)
+
+#if (GPIO_CONSTANT_MACROS == TRUE)
+
+/* Constant pin versions of GPIO_setupPinDirection, GPIO_writePin and GPIO_readPin */
+#define GPIO_SETUP_PIN_DIRECTION(PORT_ID,PIN_ID,DIRECTION) \
+	do{ if((DIRECTION) == PIN_OUTPUT) GPIO_REGISTER_SET_BITS(GPIO_DDR_REGISTER(PORT_ID),PORT_ID,(1<<(PIN_ID))); \
+		else GPIO_REGISTER_CLEAR_BITS(GPIO_DDR_REGISTER(PORT_ID),PORT_ID,(1<<(PIN_ID))); }while(0)
+#define GPIO_WRITE_PIN(PORT_ID,PIN_ID,VALUE) \
+	do{ if((VALUE) == LOGIC_HIGH) GPIO_REGISTER_SET_BITS(GPIO_PORT_REGISTER(PORT_ID),PORT_ID,(1<<(PIN_ID))); \
+		else GPIO_REGISTER_CLEAR_BITS(GPIO_PORT_REGISTER(PORT_ID),PORT_ID,(1<<(PIN_ID))); }while(0)
+#define GPIO_READ_PIN(PORT_ID,PIN_ID) \
+	(BIT_IS_SET(GPIO_PIN_REGISTER(PORT_ID),(PIN_ID)) ? LOGIC_HIGH : LOGIC_LOW)
+
+/*
+ * Constant port versions of the GPIO port functions, the masked ones are not
+ * protected against the interrupts, see GPIO_WRITE_PORT_FIELD.
+ */
+#define GPIO_SETUP_PORT_DIRECTION(PORT_ID,DIRECTION) \
+	(GPIO_DDR_REGISTER(PORT_ID) = (DIRECTION))
+#define GPIO_WRITE_PORT(PORT_ID,VALUE) \
+	(GPIO_PORT_REGISTER(PORT_ID) = (VALUE))
+#define GPIO_WRITE_PORT_MASKED(PORT_ID,MASK,VALUE) \
+	(GPIO_PORT_REGISTER(PORT_ID) = (GPIO_PORT_REGISTER(PORT_ID) & ~(MASK)) | ((VALUE) & (MASK)))
+#define GPIO_SETUP_PORT_DIRECTION_MASKED(PORT_ID,MASK,DIRECTION) \
+	(GPIO_DDR_REGISTER(PORT_ID) = (GPIO_DDR_REGISTER(PORT_ID) & ~(MASK)) | ((DIRECTION) & (MASK)))
+
+/* Constant port bits operations, see GPIO_ATOMIC, the port ID and the mask should be constants */
+#define GPIO_SET_PORT_BITS(PORT_ID,MASK) \
+	GPIO_REGISTER_SET_BITS(GPIO_PORT_REGISTER(PORT_ID),PORT_ID,MASK)
+#define GPIO_CLEAR_PORT_BITS(PORT_ID,MASK) \
+	GPIO_REGISTER_CLEAR_BITS(GPIO_PORT_REGISTER(PORT_ID),PORT_ID,MASK)
+#define GPIO_TOGGLE_PORT_BITS(PORT_ID,MASK) \
+	GPIO_ATOMIC(GPIO_PORT_REGISTER(PORT_ID) ^= (MASK))
+#define GPIO_WRITE_PORT_FIELD(PORT_ID,MASK,VALUE) \
+	GPIO_ATOMIC(GPIO_WRITE_PORT_MASKED(PORT_ID,MASK,VALUE))
+
+#else
+
+#define GPIO_SETUP_PIN_DIRECTION(PORT_ID,PIN_ID,DIRECTION)        GPIO_setupPinDirection(PORT_ID,PIN_ID,DIRECTION)
+#define GPIO_WRITE_PIN(PORT_ID,PIN_ID,VALUE)                      GPIO_writePin(PORT_ID,PIN_ID,VALUE)
+#define GPIO_READ_PIN(PORT_ID,PIN_ID)                             GPIO_readPin(PORT_ID,PIN_ID)
+#define GPIO_SETUP_PORT_DIRECTION(PORT_ID,DIRECTION)              GPIO_setupPortDirection(PORT_ID,DIRECTION)
+#define GPIO_WRITE_PORT(PORT_ID,VALUE)                            GPIO_writePort(PORT_ID,VALUE)
+#define GPIO_WRITE_PORT_MASKED(PORT_ID,MASK,VALUE)                GPIO_writePortMasked(PORT_ID,MASK,VALUE)
+#define GPIO_SETUP_PORT_DIRECTION_MASKED(PORT_ID,MASK,DIRECTION)  GPIO_setupPortDirectionMasked(PORT_ID,MASK,DIRECTION)
+#define GPIO_SET_PORT_BITS(PORT_ID,MASK)                          GPIO_setPortBits(PORT_ID,MASK)
+#define GPIO_CLEAR_PORT_BITS(PORT_ID,MASK)                        GPIO_clearPortBits(PORT_ID,MASK)
+#define GPIO_TOGGLE_PORT_BITS(PORT_ID,MASK)                       GPIO_togglePortBits(PORT_ID,MASK)
+#define GPIO_WRITE_PORT_FIELD(PORT_ID,MASK,VALUE)                 GPIO_writePortMasked(PORT_ID,MASK,VALUE)
+
+#endif
+
 /*******************************************************************************
  *                                Enums                                        *
  *******************************************************************************/
@@ -70,6 +168,7 @@ void GPIO_setupPinDirection(uint8 port_num, uint8 pin_num, GPIO_PinDirectionType
  * Write the value Logic High or Logic Low on the required pin.
  * If the input port number or pin number are not correct, The function will not handle the request.
  * If the pin is input, this function will enable/disable the internal pull-up resistor.
+ * The other pins of the port are not changed even if an interrupt writes them meanwhile.
  */
 void GPIO_writePin(uint8 port_num, uint8 pin_num, uint8 value);
 
@@ -105,6 +204,51 @@ void GPIO_writePort(uint8 port_num, uint8 value);
  */
 uint8 GPIO_readPort(uint8 port_num);
 
+/*
+ * Description :
+ * Setup the direction of the port pins selected by the mask, the other pins keep their direction.
+ * If the input port number is not correct, The function will not handle the request.
+ */
+void GPIO_setupPortDirectionMasked(uint8 port_num, uint8 mask, GPIO_PortDirectionType direction);
+
+/*
+ * Description :
+ * Write the value on the port pins selected by the mask in one port update,
+ * the other pins keep their value.
+ * The interrupts are disabled while the port is read, modified and written.
+ * If the input port number is not correct, The function will not handle the request.
+ */
+void GPIO_writePortMasked(uint8 port_num, uint8 mask, uint8 value);
+
+/*
+ * Description :
+ * Set the port pins selected by the mask to Logic High.
+ * If the input port number is not correct, The function will not handle the request.
+ */
+void GPIO_setPortBits(uint8 port_num, uint8 mask);
+
+/*
+ * Description :
+ * Clear the port pins selected by the mask to Logic Low.
+ * If the input port number is not correct, The function will not handle the request.
+ */
+void GPIO_clearPortBits(uint8 port_num, uint8 mask);
+
+/*
+ * Description :
+ * Toggle the port pins selected by the mask.
+ * If the input port number is not correct, The function will not handle the request.
+ */
+void GPIO_togglePortBits(uint8 port_num, uint8 mask);
+
+/*
+ * Description :
+ * Write the value on pins_num consecutive port pins starting at first_pin_num,
+ * the value is given from bit 0.
+ * If the input port number or the field are not correct, The function will not handle the request.
+ */
+void GPIO_writePortField(uint8 port_num, uint8 first_pin_num, uint8 pins_num, uint8 value);
+
 
 
 #endif /* GPIO_H_ */
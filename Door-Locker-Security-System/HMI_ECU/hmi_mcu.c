@@ -14,8 +14,10 @@
 #include "keypad.h"
 #include "uart.h"
 #include "timer1.h"
-#include <util/delay.h>
+#include "power.h"
+#include "prof.h"
 #include <avr/io.h>
+#include <avr/pgmspace.h>
 
 #define HMI_ECU_READY             0x10
 #define CONTROL_ECU_READY         0x20
@@ -25,12 +27,71 @@
 #define FIRST_PASSWORD_DELIVERED  0x80
 #define SECOND_PASSWORD_DELIVERED 0x08
 #define ENTER                     61    /* = */
+#define CLEAR_KEY                 42    /* * (long press) */
 #define OPEN_DOOR                 43   /* + */
 #define CHANGE_PASS               45  /* - */
-#define DOOR_IS_UNLOCKING         15
-#define DOOR_IS_LOCKING           15
-#define MOTOR_HOLD                3
 #define WARNING                   0x3C
+#define WAIT_TIMER_ID             0
+#define DOOR_PROGRESS             0x7E
+#define DOOR_PHASE_UNLOCKING      1
+#define DOOR_PHASE_OPEN           2
+#define DOOR_PHASE_LOCKING        3
+#define DOOR_PHASE_LOCKED         4
+#define DOOR_NO_FAULT             0
+#define DOOR_FAULT_TIMEOUT        1
+#define DOOR_FAULT_OBSTRUCTION    2
+#define MSG_TITLE                 0
+#define MSG_SUBTITLE              1
+#define MSG_UNMATCHED_PASS        2
+#define MSG_TRY_AGAIN             3
+#define MSG_NEW_PASS_SET          4
+#define MSG_ENTER_PASS            5
+#define MSG_REENTER_PASS          6
+#define MSG_SAME_PASS             7
+#define MSG_WRONG_PASS            8
+#define MSG_DOOR_UNLOCKING        9
+#define MSG_DOOR_UNLOCKED         10
+#define MSG_DOOR_LOCKING          11
+#define MSG_DOOR_LOCKED           12
+#define MSG_DOOR_NOT_LOCKED       13
+#define MSG_OBSTRUCTION           14
+#define MSG_NO_END_POSITION       15
+#define MSG_PERCENT               16
+#define MSG_SECONDS_LEFT          17
+#define MSG_OPEN_DOOR_OPTION      18
+#define MSG_CHANGE_PASS_OPTION    19
+#define MSG_WARNING               20
+#define MSG_ENTER_OLD_PASS        21
+#define MSG_OLD_PASS              22
+#define MESSAGES_NUM              23
+
+/* Screen messages, kept in the flash memory so they take no SRAM */
+static const char g_messages[MESSAGES_NUM][LCD_COLS + 1] PROGMEM = {
+		"Door Locker",
+		"Security System!",
+		"Unmatched Pass",
+		"Try again!!",
+		"New Pass is Set!",
+		"PLZ Enter Pass:",
+		"PLZ re-enter the",
+		"same pass:",
+		"WRONG PASS!!",
+		"Door Unlocking",
+		"Door is Unlock!",
+		"Door Locking",
+		"Door is Locked!",
+		"Door not Locked!",
+		"Obstruction!",
+		"No end position!",
+		"%   ",
+		"s left ",
+		"+ : Open Door",
+		"- : Change Pass",
+		"!!!Warning!!!",
+		"PLZ enter the ",
+		"old pass:"
+};
+#define MESSAGE(MSG_ID)           (g_messages[MSG_ID])
 
 
 void Send_Password(uint8 *password, uint8 password_size);
@@ -38,17 +99,17 @@ void Enter_passMessage(void);
 void ReEnter_passMessage(void);
 void Set_Password(void);
 void Get_Password(uint8 *password,uint8 pass_size);
-void Timer1_callBack(void);
+void Erase_Characters(uint8 count);
 void Main_Options(void);
 void Motor_Fun(void);
 void Open_Door(void);
 void Change_Password(void);
 void Warning_Message(void);
 void Change_passMessage(void);
+void Wait_ms(uint16 time_ms);
 
 
 uint8 Current_Password[PASSWORD_SIZE];
-uint8 g_ticks = 0;
 uint8 pressed_key = 0;
 
 
@@ -61,20 +122,34 @@ int main(void)
 	UART_ConfigType uart_configurations = {EIGHT_BITS,EVEN,ONE_BIT,9600};
 	UART_init(&uart_configurations);
 
-	/* Initialize Timer1 Driver to make an interrupt every 1sec */
-	Timer1_ConfigType configurations = {0,8000,F_CPU_1024,CTC};
+#if (TIMER1_TICKLESS_MODE == TRUE)
+	/* Initialize Timer1 Driver to run free and interrupt only at the software timers deadlines */
+	Timer1_ConfigType configurations = {0,0,TIMER1_TIMEBASE_PRESCALER,NORMAL};
+#else
+	/* Initialize Timer1 Driver to make an interrupt every 1sec (every 1msec in the profiling builds) */
+	Timer1_ConfigType configurations = {0,8000,TIMER1_TIMEBASE_PRESCALER,CTC};
+#endif
 	Timer1_init(&configurations);
-	Timer1_setCallBack(Timer1_callBack);
+
+	/* Initialize the Power Management driver to sleep while waiting */
+	POWER_init();
+
+	/* Initialize the profiler (only in the profiling builds) */
+	PROF_INIT();
 
 	/*Initialize the LCD driver*/
 	LCD_init();
 
+	/* Start scanning the keypad in the background */
+	KEYPAD_init();
+
 	/* LCD Initialization completed and ready to communication */
 	UART_sendByte(HMI_ECU_READY);
 
-	LCD_displayStringRowColumn(0,2,"Door Locker");
-	LCD_displayStringRowColumn(1,0,"Security System!");
-	_delay_ms(2500);
+	LCD_displayStringRowColumn_P(0,2,MESSAGE(MSG_TITLE));
+	LCD_displayStringRowColumn_P(1,0,MESSAGE(MSG_SUBTITLE));
+	LCD_flush();
+	Wait_ms(2500);
 
 	/* Call the Set Password Function */
 	Set_Password();
@@ -86,6 +161,15 @@ int main(void)
 		/* Send the pressed key to the CONTROL_ECU */
 		UART_sendByte(pressed_key);
 
+#ifdef PROF_ENABLE
+		if(pressed_key == PROF_DUMP_KEY)
+		{
+			/* Drop the table of the CONTROL_ECU as it comes, then send this one */
+			PROF_SKIP_DUMP();
+			PROF_DUMP();
+		}
+#endif
+
 		/* The LCD will always display main options */
 		Main_Options();
 
@@ -101,11 +185,6 @@ int main(void)
 }
 
 
-void Timer1_callBack(void)
-{
-	g_ticks++;
-}
-
 void Set_Password(void)
 {
 	uint8 entered_password[PASSWORD_SIZE], reentered_password[PASSWORD_SIZE];
@@ -150,15 +229,17 @@ void Set_Password(void)
 		if(pass_state == UNMATCHED_PASSWORD)
 		{
 			LCD_clearScreen();
-			LCD_displayStringRowColumn(0,0,"Unmatched Pass");
-			LCD_displayStringRowColumn(0,1,"Try again!!");
+			LCD_displayStringRowColumn_P(0,0,MESSAGE(MSG_UNMATCHED_PASS));
+			LCD_displayStringRowColumn_P(0,1,MESSAGE(MSG_TRY_AGAIN));
+			LCD_flush();
 
 		}
 	}
 
 	LCD_clearScreen();
-	LCD_displayStringRowColumn(0,0,"New Pass is Set!");
-	_delay_ms(1000);
+	LCD_displayStringRowColumn_P(0,0,MESSAGE(MSG_NEW_PASS_SET));
+	LCD_flush();
+	Wait_ms(1000);
 	LCD_clearScreen();
 	/*If Password MATCHED display main menu one time before while*/
 	Main_Options();
@@ -171,21 +252,23 @@ void Send_Password(uint8 *password, uint8 password_size)
 	for(counter = 0 ; counter < password_size ; counter++)
 	{
 		UART_sendByte(password[counter]);
-		_delay_ms(50);
+		Wait_ms(50);
 	}
 }
 
 void Enter_passMessage(void){
 	LCD_clearScreen();
-	LCD_displayStringRowColumn(0,0,"PLZ Enter Pass:");
+	LCD_displayStringRowColumn_P(0,0,MESSAGE(MSG_ENTER_PASS));
 	LCD_moveCursor(1,0);
+	LCD_flush();
 }
 
 void ReEnter_passMessage(void)
 {
 	LCD_clearScreen();
-	LCD_displayStringRowColumn(0,0,"PLZ re-enter the ");
-	LCD_displayStringRowColumn(1,0,"same pass:");
+	LCD_displayStringRowColumn_P(0,0,MESSAGE(MSG_REENTER_PASS));
+	LCD_displayStringRowColumn_P(1,0,MESSAGE(MSG_SAME_PASS));
+	LCD_flush();
 }
 
 void Open_Door(void)
@@ -225,8 +308,9 @@ void Open_Door(void)
 		{
 			pass_state = UNMATCHED_PASSWORD;
 			LCD_clearScreen();
-			LCD_displayStringRowColumn(0,1,"WRONG PASS!!");
-			_delay_ms(1500);
+			LCD_displayStringRowColumn_P(0,1,MESSAGE(MSG_WRONG_PASS));
+			LCD_flush();
+			Wait_ms(1500);
 		}
 		else if(received_byte  == WARNING){
 			Warning_Message();
@@ -271,8 +355,9 @@ void Change_Password(void)
 		{
 			pass_state = UNMATCHED_PASSWORD;
 			LCD_clearScreen();
-			LCD_displayStringRowColumn(0,1,"WRONG PASS!!");
-			_delay_ms(2000);
+			LCD_displayStringRowColumn_P(0,1,MESSAGE(MSG_WRONG_PASS));
+			LCD_flush();
+			Wait_ms(2000);
 		}
 		else if(received_byte  == WARNING){
 			Warning_Message();
@@ -284,47 +369,115 @@ void Change_Password(void)
 
 void Get_Password(uint8 *password,uint8 pass_size)
 {
-	uint8 key;
+	KEYPAD_EventType event;
 	uint8 i =0;
 
-	for(i=0 ; i<pass_size ; i++){
-		_delay_ms(400);
-		key =  KEYPAD_getPressedKey();
-		LCD_displayCharacter('*');
-		password[i] =  key;
-		_delay_ms(200);
+	/*
+	 * The keys are debounced and buffered by the keypad driver, the keys typed
+	 * while the screen is busy are read here in the same order.
+	 */
+	while(i < pass_size){
+		KEYPAD_waitEvent(&event);
+
+		if((event.kind == KEYPAD_KEY_LONG_PRESSED) && (event.key == CLEAR_KEY))
+		{
+			/* Erase the stars and start the password again */
+			Erase_Characters(i);
+			i = 0;
+		}
+		else if(event.kind == KEYPAD_KEY_PRESSED)
+		{
+			LCD_displayCharacter('*');
+			password[i] =  event.key;
+			i++;
+		}
+
+		/* Show the typed star or the erased entry before waiting for the next key */
+		LCD_flush();
 	}
 
 	while(KEYPAD_getPressedKey() != ENTER);
 }
 
+void Erase_Characters(uint8 count)
+{
+	uint8 i;
+
+	for(i = 0 ; i < count ; i++)
+	{
+		LCD_sendCommand(LCD_CURSOR_SHIFT_LEFT);
+	}
+	for(i = 0 ; i < count ; i++)
+	{
+		LCD_displayCharacter(' ');
+	}
+	for(i = 0 ; i < count ; i++)
+	{
+		LCD_sendCommand(LCD_CURSOR_SHIFT_LEFT);
+	}
+}
+
 void Motor_Fun(void)
 {
-	/*Opening the door in 15sec*/
-	g_ticks=0;
-	LCD_clearScreen();
-	LCD_displayStringRowColumn(0,4,"Door is");
-	LCD_displayStringRowColumn(1,4,"Unlocking!");
-	while (g_ticks < DOOR_IS_UNLOCKING);
+	uint8 phase = 0;
+	uint8 shown_phase = 0;
+	uint8 percent, remaining_time, fault;
 
-	/*Holding the door in 3sec*/
-	g_ticks=0;
-	LCD_clearScreen();
-	LCD_displayString("Door is Unlock!");
-	while (g_ticks < MOTOR_HOLD);
+	/* Follow the door state streamed by the CONTROL_ECU until the door sequence ends */
+	do
+	{
+		/* Wait for the start of the next progress frame */
+		while(UART_recieveByte() != DOOR_PROGRESS);
+		phase = UART_recieveByte();
+		percent = UART_recieveByte();
+		remaining_time = UART_recieveByte();
+		fault = UART_recieveByte();
+
+		/* The screen is cleared only when the phase changes, then only the progress is updated */
+		if(phase != shown_phase)
+		{
+			LCD_clearScreen();
+			switch(phase)
+			{
+			case DOOR_PHASE_UNLOCKING:
+				LCD_displayStringRowColumn_P(0,1,MESSAGE(MSG_DOOR_UNLOCKING));
+				break;
+			case DOOR_PHASE_OPEN:
+				LCD_displayStringRowColumn_P(0,0,MESSAGE(MSG_DOOR_UNLOCKED));
+				break;
+			case DOOR_PHASE_LOCKING:
+				LCD_displayStringRowColumn_P(0,2,MESSAGE(MSG_DOOR_LOCKING));
+				break;
+			case DOOR_PHASE_LOCKED:
+				LCD_displayStringRowColumn_P(0,0,MESSAGE((fault == DOOR_NO_FAULT) ? MSG_DOOR_LOCKED : MSG_DOOR_NOT_LOCKED));
+				break;
+			}
+			shown_phase = phase;
+		}
 
-	/*Closing the door in 15sec*/
-	g_ticks=0;
-	LCD_clearScreen();
-	LCD_displayStringRowColumn(0,4,"Door is");
-	LCD_displayStringRowColumn(1,4,"Locking!");
-	while (g_ticks < DOOR_IS_LOCKING);
+		LCD_moveCursor(1,0);
+		if(fault == DOOR_FAULT_OBSTRUCTION)
+		{
+			LCD_displayString_P(MESSAGE(MSG_OBSTRUCTION));
+		}
+		else if(fault == DOOR_FAULT_TIMEOUT)
+		{
+			LCD_displayString_P(MESSAGE(MSG_NO_END_POSITION));
+		}
+		else if(phase != DOOR_PHASE_LOCKED)
+		{
+			LCD_integerToString(percent);
+			LCD_displayString_P(MESSAGE(MSG_PERCENT));
+			LCD_moveCursor(1,8);
+			LCD_integerToString(remaining_time);
+			LCD_displayString_P(MESSAGE(MSG_SECONDS_LEFT));
+		}
 
-	/*Stop the Motor*/
-	LCD_clearScreen();
-	LCD_displayStringRowColumn(0,4,"Door is");
-	LCD_displayStringRowColumn(1,4,"Locked!");
-	_delay_ms(1000);
+		/* Only the changed digits are sent to the LCD */
+		LCD_flush();
+	}while(phase != DOOR_PHASE_LOCKED);
+
+	Wait_ms(1000);
 	/*The LCD will always display the main system options*/
 	LCD_clearScreen();
 	Main_Options();
@@ -335,16 +488,17 @@ void Main_Options(void)
 	LCD_clearScreen();
 
 	/* Display system main options */
-	LCD_displayStringRowColumn(0,0,"+ : Open Door");
-	LCD_displayStringRowColumn(1,0,"- : Change Pass");
+	LCD_displayStringRowColumn_P(0,0,MESSAGE(MSG_OPEN_DOOR_OPTION));
+	LCD_displayStringRowColumn_P(1,0,MESSAGE(MSG_CHANGE_PASS_OPTION));
+	LCD_flush();
 }
 
 void Warning_Message(void){
-	g_ticks=0;
+	Timer1_startSwTimer(WAIT_TIMER_ID,TIMER1_SECONDS(WARNING));
 	LCD_clearScreen();
-	while(g_ticks < WARNING){
-		LCD_displayStringRowColumn(0,2,"!!!Warning!!!");
-	}
+	LCD_displayStringRowColumn_P(0,2,MESSAGE(MSG_WARNING));
+	LCD_flush();
+	POWER_WAIT_WHILE(!Timer1_isSwTimerExpired(WAIT_TIMER_ID));
 	LCD_clearScreen();
 	/*The LCD will always display the main system options*/
 	Main_Options();
@@ -354,6 +508,14 @@ void Warning_Message(void){
 void Change_passMessage(void)
 {
 	LCD_clearScreen();
-	LCD_displayStringRowColumn(0,0,"PLZ enter the ");
-	LCD_displayStringRowColumn(1,0,"old pass:");
+	LCD_displayStringRowColumn_P(0,0,MESSAGE(MSG_ENTER_OLD_PASS));
+	LCD_displayStringRowColumn_P(1,0,MESSAGE(MSG_OLD_PASS));
+	LCD_flush();
+}
+
+void Wait_ms(uint16 time_ms)
+{
+	/* Sleep until the software timer expires instead of spinning in _delay_ms() */
+	Timer1_startSwTimer(WAIT_TIMER_ID,TIMER1_MILLISECONDS(time_ms));
+	POWER_WAIT_WHILE(!Timer1_isSwTimerExpired(WAIT_TIMER_ID));
 }
@@ -11,160 +11,396 @@
  *******************************************************************************/
 #include "keypad.h"
 #include "gpio.h"
-#include <util/delay.h>
+#include "timer1.h"
+#include "power.h"
+#include "common_macros.h"
+#include "prof.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
 
 /*******************************************************************************
- *                      Functions Prototypes(Private)                          *
+ *                           Port Registers                                    *
+ *******************************************************************************/
+
+#if (KEYPAD_PORT_PARALLEL_SCAN == TRUE)
+
+#if (KEYPAD_ROW_PORT_ID != KEYPAD_COL_PORT_ID)
+#error "The port parallel scan needs the keypad rows and columns on the same port"
+#endif
+
+#if (KEYPAD_ROW_PORT_ID == PORTA_ID)
+#define KEYPAD_PORT_DIR   DDRA
+#define KEYPAD_PORT_OUT   PORTA
+#define KEYPAD_PORT_IN    PINA
+#elif (KEYPAD_ROW_PORT_ID == PORTB_ID)
+#define KEYPAD_PORT_DIR   DDRB
+#define KEYPAD_PORT_OUT   PORTB
+#define KEYPAD_PORT_IN    PINB
+#elif (KEYPAD_ROW_PORT_ID == PORTC_ID)
+#define KEYPAD_PORT_DIR   DDRC
+#define KEYPAD_PORT_OUT   PORTC
+#define KEYPAD_PORT_IN    PINC
+#elif (KEYPAD_ROW_PORT_ID == PORTD_ID)
+#define KEYPAD_PORT_DIR   DDRD
+#define KEYPAD_PORT_OUT   PORTD
+#define KEYPAD_PORT_IN    PIND
+#endif
+
+/* Bits of the rows and the columns in the keypad port */
+#define KEYPAD_ROWS_MASK  ((uint8)(((1 << KEYPAD_NUM_ROWS) - 1) << KEYPAD_FIRST_ROW_PIN_ID))
+#define KEYPAD_COLS_MASK  ((uint8)(((1 << KEYPAD_NUM_COLS) - 1) << KEYPAD_FIRST_COL_PIN_ID))
+
+#endif /* KEYPAD_PORT_PARALLEL_SCAN */
+
+/*******************************************************************************
+ *                           Keys Tables                                       *
  *******************************************************************************/
 
 #ifndef STANDARD_KEYPAD
 
+/* Key value of each switch (row*KEYPAD_NUM_COLS + col) in the proteus keypad shape */
 #if (KEYPAD_NUM_COLS == 3)
+static const uint8 g_keyValues[KEYPAD_NUM_ROWS * KEYPAD_NUM_COLS] PROGMEM = {
+	1,   2, 3,
+	4,   5, 6,
+	7,   8, 9,
+	'*', 0, '#'
+};
+#elif (KEYPAD_NUM_COLS == 4)
+static const uint8 g_keyValues[KEYPAD_NUM_ROWS * KEYPAD_NUM_COLS] PROGMEM = {
+	7,  8, 9,   '%',
+	4,  5, 6,   '*',
+	1,  2, 3,   '-',
+	13, 0, '=', '+'   /* 13 is the ASCII of Enter */
+};
+#endif
+
+/* Key value of the switch number key_index */
+#define KEYPAD_KEY_VALUE(KEY_INDEX)      pgm_read_byte(&g_keyValues[KEY_INDEX])
+
+#else
+
+/* The standard keypad key value is the switch number counted from 1 */
+#define KEYPAD_KEY_VALUE(KEY_INDEX)      ((KEY_INDEX) + 1)
+
+#endif /* STANDARD_KEYPAD */
+
+/* Value of g_heldKey while no key is held */
+#define KEYPAD_NO_KEY     0xFF
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/* Debounced state of the keys, bit (row*KEYPAD_NUM_COLS + col) is set while the key is pressed */
+static volatile uint16 g_keysState = 0;
+
+/* Number of consecutive scans that read each key in the opposite state of its debounced state */
+static volatile uint8 g_keysCount[KEYPAD_NUM_ROWS * KEYPAD_NUM_COLS];
+
+/* Key events FIFO */
+static volatile KEYPAD_EventType g_events[KEYPAD_EVENTS_SIZE];
+static volatile uint8 g_eventsHead = 0;
+static volatile uint8 g_eventsTail = 0;
+
+/* Last pressed key, followed for the long press and the repeat events */
+static volatile uint8 g_heldKey = KEYPAD_NO_KEY;
+static volatile uint16 g_heldScans = 0;
+static volatile boolean g_heldLong = FALSE;
+
+/* Timer1 subscriber id of the scan function while the keypad is scanned */
+static volatile uint8 g_scanTickId = TIMER1_INVALID_SUBSCRIBER;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
 /*
- * Function responsible for mapping the switch number in the keypad to
- * its corresponding functional number in the proteus for 4x3 keypad
+ * Function responsible for the debounce state machine of one key, it pushes an
+ * event when the key is pressed or released.
  */
-static uint8 KEYPAD_4x3_adjustKeyNumber(uint8 button_number);
-#elif (KEYPAD_NUM_COLS == 4)
+static void KEYPAD_debounceKey(uint8 key_index, boolean raw_pressed);
+
+/*
+ * Push an event of a key in the events FIFO, the event is dropped if the FIFO is full.
+ */
+static void KEYPAD_pushEvent(uint8 key_index, KEYPAD_EventKind kind);
+
 /*
- * Function responsible for mapping the switch number in the keypad to
- * its corresponding functional number in the proteus for 4x4 keypad
+ * Give the long press and the repeat events of the last pressed key while it is held.
  */
-static uint8 KEYPAD_4x4_adjustKeyNumber(uint8 button_number);
+static void KEYPAD_checkHeldKey(void);
+
+/*
+ * Scan all the keypad rows, called from the Timer1 compare B interrupt.
+ */
+static void KEYPAD_scan(void);
+
+#if (KEYPAD_WAKE_ON_KEYPRESS == TRUE)
+/*
+ * Stop the scan and drive all the rows low, so any key down pulls the columns
+ * wired-AND low and wakes the scan up through INT2.
+ */
+static void KEYPAD_waitKeyDown(void);
 #endif
 
-#endif /* STANDARD_KEYPAD */
+/*******************************************************************************
+ *                       Interrupt Service Routines                            *
+ *******************************************************************************/
+
+#if (KEYPAD_WAKE_ON_KEYPRESS == TRUE)
+ISR(INT2_vect)
+{
+	/* A key is down, scan the keypad until all the keys are released */
+	CLEAR_BIT(GICR,INT2);
+	g_scanTickId = Timer1_subscribe(TIMER1_COMPB_CHANNEL, KEYPAD_scan, KEYPAD_SCAN_PERIOD_MS);
+}
+#endif
 
 /*******************************************************************************
  *                      Functions Definitions                                  *
  *******************************************************************************/
 
-uint8 KEYPAD_getPressedKey(void)
+void KEYPAD_init(void)
 {
-	uint8 col,row;
-	GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID, PIN_INPUT);
-	GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+1, PIN_INPUT);
-	GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+2, PIN_INPUT);
-	GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+3, PIN_INPUT);
-
-	GPIO_setupPinDirection(KEYPAD_COL_PORT_ID, KEYPAD_FIRST_COL_PIN_ID, PIN_INPUT);
-	GPIO_setupPinDirection(KEYPAD_COL_PORT_ID, KEYPAD_FIRST_COL_PIN_ID+1, PIN_INPUT);
-	GPIO_setupPinDirection(KEYPAD_COL_PORT_ID, KEYPAD_FIRST_COL_PIN_ID+2, PIN_INPUT);
-#if(KEYPAD_NUM_COLS == 4)
-	GPIO_setupPinDirection(KEYPAD_COL_PORT_ID, KEYPAD_FIRST_COL_PIN_ID+3, PIN_INPUT);
+	uint8 pin;
+
+	/* All the rows and the columns are inputs, a row is driven only while it is scanned */
+	for(pin = 0 ; pin < KEYPAD_NUM_ROWS ; pin++)
+	{
+		GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+pin, PIN_INPUT);
+	}
+	for(pin = 0 ; pin < KEYPAD_NUM_COLS ; pin++)
+	{
+		GPIO_setupPinDirection(KEYPAD_COL_PORT_ID, KEYPAD_FIRST_COL_PIN_ID+pin, PIN_INPUT);
+	}
+
+#if (KEYPAD_WAKE_ON_KEYPRESS == TRUE)
+	/* INT2 pin is an input, it is pulled up through the columns pull ups */
+	GPIO_setupPinDirection(KEYPAD_WAKE_PORT_ID, KEYPAD_WAKE_PIN_ID, PIN_INPUT);
+
+	/* INT2 on the falling edge ISC2=0, INT2 must be disabled while changing its sense */
+	CLEAR_BIT(GICR,INT2);
+	CLEAR_BIT(MCUCSR,ISC2);
+
+	KEYPAD_waitKeyDown();
+#else
+	g_scanTickId = Timer1_subscribe(TIMER1_COMPB_CHANNEL, KEYPAD_scan, KEYPAD_SCAN_PERIOD_MS);
 #endif
-	while(1)
+}
+
+boolean KEYPAD_getEvent(KEYPAD_EventType *event)
+{
+	uint8 sreg = SREG;
+	boolean found = FALSE;
+
+	cli();
+	if(g_eventsTail != g_eventsHead)
 	{
-		for(row=0 ; row<KEYPAD_NUM_ROWS ; row++) /* loop for rows */
-		{
-			/*
-			 * Each time setup the direction for all keypad port as input pins,
-			 * except this row will be output pin
-			 */
-			GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID,KEYPAD_FIRST_ROW_PIN_ID+row,PIN_OUTPUT);
-
-			/* Set/Clear the row output pin */
-			GPIO_writePin(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+row, KEYPAD_BUTTON_PRESSED);
-
-			for(col=0 ; col<KEYPAD_NUM_COLS ; col++) /* loop for columns */
-			{
-				/* Check if the switch is pressed in this column */
-				if(GPIO_readPin(KEYPAD_COL_PORT_ID,KEYPAD_FIRST_COL_PIN_ID+col) == KEYPAD_BUTTON_PRESSED)
-				{
-					#if (KEYPAD_NUM_COLS == 3)
-						#ifdef STANDARD_KEYPAD
-							return ((row*KEYPAD_NUM_COLS)+col+1);
-						#else
-							return KEYPAD_4x3_adjustKeyNumber((row*KEYPAD_NUM_COLS)+col+1);
-						#endif
-					#elif (KEYPAD_NUM_COLS == 4)
-						#ifdef STANDARD_KEYPAD
-							return ((row*KEYPAD_NUM_COLS)+col+1);
-						#else
-							return KEYPAD_4x4_adjustKeyNumber((row*KEYPAD_NUM_COLS)+col+1);
-						#endif
-					#endif
-				}
-			}
-			GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID,KEYPAD_FIRST_ROW_PIN_ID+row,PIN_INPUT);
-			_delay_ms(5); /* Add small delay to fix CPU load issue in proteus */
-		}
+		event->key = g_events[g_eventsTail].key;
+		event->kind = g_events[g_eventsTail].kind;
+		event->time_stamp = g_events[g_eventsTail].time_stamp;
+		g_eventsTail = (g_eventsTail + 1) & (KEYPAD_EVENTS_SIZE - 1);
+		found = TRUE;
 	}
+	SREG = sreg;
+
+	return found;
 }
 
-#ifndef STANDARD_KEYPAD
+void KEYPAD_waitEvent(KEYPAD_EventType *event)
+{
+	/* Sleep until the scan pushes a new event */
+	do
+	{
+		POWER_WAIT_WHILE(g_eventsTail == g_eventsHead);
+	}while(!KEYPAD_getEvent(event));
+}
 
-#if (KEYPAD_NUM_COLS == 3)
-/*
- * Description :
- * Update the keypad pressed button value with the correct one in keypad 4x3 shape
- */
-static uint8 KEYPAD_4x3_adjustKeyNumber(uint8 button_number)
+uint8 KEYPAD_getPressedKey(void)
 {
-	uint8 keypad_button = 0;
-	switch(button_number)
-	{
-		case 10: keypad_button = '*'; // ASCII Code of *
-				 break;
-		case 11: keypad_button = 0;
-				 break;
-		case 12: keypad_button = '#'; // ASCII Code of #
-				 break;
-		default: keypad_button = button_number;
-				break;
+	KEYPAD_EventType event;
+
+	do
+	{
+		KEYPAD_waitEvent(&event);
+	}while(event.kind != KEYPAD_KEY_PRESSED);
+
+	return event.key;
+}
+
+static void KEYPAD_debounceKey(uint8 key_index, boolean raw_pressed)
+{
+	if(raw_pressed == (BIT_IS_SET(g_keysState,key_index) ? TRUE : FALSE))
+	{
+		/* Same level as the debounced state, a bounce is over */
+		g_keysCount[key_index] = 0;
+		return;
+	}
+
+	if(++g_keysCount[key_index] < KEYPAD_DEBOUNCE_SCANS)
+	{
+		return;
+	}
+
+	/* The new level is stable, change the key state and report it */
+	g_keysCount[key_index] = 0;
+	g_keysState ^= (uint16)1 << key_index;
+
+	if(raw_pressed)
+	{
+		/* Follow the new key for the long press */
+		g_heldKey = key_index;
+		g_heldScans = 0;
+		g_heldLong = FALSE;
+		KEYPAD_pushEvent(key_index, KEYPAD_KEY_PRESSED);
+	}
+	else
+	{
+		if(key_index == g_heldKey)
+		{
+			g_heldKey = KEYPAD_NO_KEY;
+		}
+		KEYPAD_pushEvent(key_index, KEYPAD_KEY_RELEASED);
 	}
-	return keypad_button;
 }
 
-#elif (KEYPAD_NUM_COLS == 4)
+static void KEYPAD_pushEvent(uint8 key_index, KEYPAD_EventKind kind)
+{
+	uint8 next_head = (g_eventsHead + 1) & (KEYPAD_EVENTS_SIZE - 1);
 
-/*
- * Description :
- * Update the keypad pressed button value with the correct one in keypad 4x4 shape
- */
-static uint8 KEYPAD_4x4_adjustKeyNumber(uint8 button_number)
+	if(next_head != g_eventsTail)
+	{
+		g_events[g_eventsHead].key = KEYPAD_KEY_VALUE(key_index);
+		g_events[g_eventsHead].kind = kind;
+		g_events[g_eventsHead].time_stamp = Timer1_getTimeStamp();
+		g_eventsHead = next_head;
+	}
+}
+
+static void KEYPAD_checkHeldKey(void)
 {
-	uint8 keypad_button = 0;
-	switch(button_number)
-	{
-		case 1: keypad_button = 7;
-				break;
-		case 2: keypad_button = 8;
-				break;
-		case 3: keypad_button = 9;
-				break;
-		case 4: keypad_button = '%'; // ASCII Code of %
-				break;
-		case 5: keypad_button = 4;
-				break;
-		case 6: keypad_button = 5;
-				break;
-		case 7: keypad_button = 6;
-				break;
-		case 8: keypad_button = '*'; /* ASCII Code of '*' */
-				break;
-		case 9: keypad_button = 1;
-				break;
-		case 10: keypad_button = 2;
-				break;
-		case 11: keypad_button = 3;
-				break;
-		case 12: keypad_button = '-'; /* ASCII Code of '-' */
-				break;
-		case 13: keypad_button = 13;  /* ASCII of Enter */
-				break;
-		case 14: keypad_button = 0;
-				break;
-		case 15: keypad_button = '='; /* ASCII Code of '=' */
-				break;
-		case 16: keypad_button = '+'; /* ASCII Code of '+' */
-				break;
-		default: keypad_button = button_number;
-				break;
+	if(g_heldKey == KEYPAD_NO_KEY)
+	{
+		return;
+	}
+
+	g_heldScans++;
+	if(!g_heldLong && (g_heldScans >= (KEYPAD_LONG_PRESS_MS / KEYPAD_SCAN_PERIOD_MS)))
+	{
+		g_heldLong = TRUE;
+		g_heldScans = 0;
+		KEYPAD_pushEvent(g_heldKey, KEYPAD_KEY_LONG_PRESSED);
+	}
+	else if(g_heldLong && (g_heldScans >= (KEYPAD_REPEAT_PERIOD_MS / KEYPAD_SCAN_PERIOD_MS)))
+	{
+		g_heldScans = 0;
+		KEYPAD_pushEvent(g_heldKey, KEYPAD_KEY_REPEATED);
 	}
-	return keypad_button;
 }
 
+static void KEYPAD_scan(void)
+{
+	uint8 col,row;
+	uint8 key_index = 0;
+	boolean any_pressed = FALSE;
+#if (KEYPAD_PORT_PARALLEL_SCAN == TRUE)
+	uint8 pressed_cols;
+#else
+	boolean raw_pressed;
+#endif
+
+	PROF_BEGIN(PROF_ID_KEYPAD_SCAN);
+
+	for(row=0 ; row<KEYPAD_NUM_ROWS ; row++) /* loop for rows */
+	{
+#if (KEYPAD_PORT_PARALLEL_SCAN == TRUE)
+		/* Drive only this row low with one DDR write, the other rows float as inputs */
+		KEYPAD_PORT_OUT &= ~KEYPAD_ROWS_MASK;
+		KEYPAD_PORT_DIR = (KEYPAD_PORT_DIR & ~KEYPAD_ROWS_MASK) | (1 << (KEYPAD_FIRST_ROW_PIN_ID + row));
+
+		/* One cycle for the input synchronizer, then read all the columns at once */
+		__asm__ __volatile__ ("nop");
+		pressed_cols = (uint8)(~KEYPAD_PORT_IN & KEYPAD_COLS_MASK) >> KEYPAD_FIRST_COL_PIN_ID;
+		if(pressed_cols != 0)
+		{
+			any_pressed = TRUE;
+		}
+
+		for(col=0 ; col<KEYPAD_NUM_COLS ; col++) /* loop for columns */
+		{
+			KEYPAD_debounceKey(key_index, BIT_IS_SET(pressed_cols,col) ? TRUE : FALSE);
+			key_index++;
+		}
+#else
+		/*
+		 * Each time setup the direction for all keypad port as input pins,
+		 * except this row will be output pin
+		 */
+		GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID,KEYPAD_FIRST_ROW_PIN_ID+row,PIN_OUTPUT);
+
+		/* Set/Clear the row output pin */
+		GPIO_writePin(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+row, KEYPAD_BUTTON_PRESSED);
+
+		for(col=0 ; col<KEYPAD_NUM_COLS ; col++) /* loop for columns */
+		{
+			/* Check if the switch is pressed in this column */
+			raw_pressed = (GPIO_readPin(KEYPAD_COL_PORT_ID,KEYPAD_FIRST_COL_PIN_ID+col) == KEYPAD_BUTTON_PRESSED);
+			any_pressed |= raw_pressed;
+			KEYPAD_debounceKey(key_index, raw_pressed);
+			key_index++;
+		}
+		GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID,KEYPAD_FIRST_ROW_PIN_ID+row,PIN_INPUT);
 #endif
+	}
 
-#endif /* STANDARD_KEYPAD */
+#if (KEYPAD_PORT_PARALLEL_SCAN == TRUE)
+	/* Release the last row */
+	KEYPAD_PORT_DIR &= ~KEYPAD_ROWS_MASK;
+#endif
+
+	KEYPAD_checkHeldKey();
+
+#if (KEYPAD_WAKE_ON_KEYPRESS == TRUE)
+	/* All the keys are released and no bounce is left, nothing to scan until the next key down */
+	if((any_pressed == FALSE) && (g_keysState == 0))
+	{
+		KEYPAD_waitKeyDown();
+	}
+#else
+	(void)any_pressed;
+#endif
+
+	PROF_END(PROF_ID_KEYPAD_SCAN);
+}
+
+#if (KEYPAD_WAKE_ON_KEYPRESS == TRUE)
+static void KEYPAD_waitKeyDown(void)
+{
+	uint8 sreg = SREG;
+	uint8 row;
+
+	cli();
+	Timer1_unsubscribe(g_scanTickId);
+	g_scanTickId = TIMER1_INVALID_SUBSCRIBER;
+
+	for(row=0 ; row<KEYPAD_NUM_ROWS ; row++)
+	{
+		GPIO_WRITE_PIN(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+row, KEYPAD_BUTTON_PRESSED);
+		GPIO_SETUP_PIN_DIRECTION(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+row, PIN_OUTPUT);
+	}
+
+	/* Forget the edges of the scan then wait for the next key down */
+	GIFR = (1<<INTF2);
+	SET_BIT(GICR,INT2);
+
+	/* A key that went down before INT2 was enabled gave no edge, scan it now */
+	if(GPIO_READ_PIN(KEYPAD_WAKE_PORT_ID, KEYPAD_WAKE_PIN_ID) == KEYPAD_BUTTON_PRESSED)
+	{
+		CLEAR_BIT(GICR,INT2);
+		g_scanTickId = Timer1_subscribe(TIMER1_COMPB_CHANNEL, KEYPAD_scan, KEYPAD_SCAN_PERIOD_MS);
+	}
+	SREG = sreg;
+}
+#endif
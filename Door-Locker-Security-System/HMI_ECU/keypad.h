@@ -34,13 +34,85 @@
 #define KEYPAD_BUTTON_PRESSED            LOGIC_LOW
 #define KEYPAD_BUTTON_RELEASED           LOGIC_HIGH
 
+/*
+ * TRUE : every row is driven with one masked DDR write and all the columns are
+ *        read with one PIN read, the rows and the columns must share one port.
+ * FALSE: the previous scan, every row pin is driven and every column pin is read
+ *        on its own with the GPIO driver functions.
+ * The time of one scan is measured by the PROF_ID_KEYPAD_SCAN probe in the profiling
+ * builds, "make profile" in the HOST folder prints it for the two scans.
+ */
+#ifndef KEYPAD_PORT_PARALLEL_SCAN
+#define KEYPAD_PORT_PARALLEL_SCAN        TRUE
+#endif
+
+/* The keypad is scanned every KEYPAD_SCAN_PERIOD_MS from the Timer1 compare B ticks */
+#define KEYPAD_SCAN_PERIOD_MS            5
+
+/* A key changes its state after the same raw level is read in this number of scans */
+#define KEYPAD_DEBOUNCE_SCANS            4
+
+/* Number of events kept until they are read, it must be a power of 2 */
+#define KEYPAD_EVENTS_SIZE               16
+
+/* A key held for this time gives a long press event, then a repeat event every repeat period */
+#define KEYPAD_LONG_PRESS_MS             800
+#define KEYPAD_REPEAT_PERIOD_MS          200
+
+/*
+ * TRUE : while no key is pressed all the rows are driven low and the scan is
+ *        stopped, the columns are wired-ANDed (one diode per column) to INT2
+ *        so the first key down wakes the scan up again.
+ * FALSE: the keypad is scanned all the time.
+ */
+#define KEYPAD_WAKE_ON_KEYPRESS          TRUE
+
+/* INT2 pin connected to the wired-AND of the columns */
+#define KEYPAD_WAKE_PORT_ID              PORTB_ID
+#define KEYPAD_WAKE_PIN_ID               PIN2_ID
+
+/*******************************************************************************
+ *                                Types Declaration                            *
+ *******************************************************************************/
+typedef enum{
+	KEYPAD_KEY_PRESSED, KEYPAD_KEY_RELEASED, KEYPAD_KEY_LONG_PRESSED, KEYPAD_KEY_REPEATED
+}KEYPAD_EventKind;
+
+typedef struct{
+	uint8 key;
+	KEYPAD_EventKind kind;
+	uint32 time_stamp; /* Timer1 time stamp of the debounced event */
+}KEYPAD_EventType;
+
 /*******************************************************************************
  *                      Functions Prototypes                                   *
  *******************************************************************************/
 
 /*
  * Description :
- * Get the Keypad pressed button
+ * Setup the keypad pins and start scanning the keypad in the background,
+ * Timer1 must be initialized first. In the wake on keypress mode the scan
+ * only runs from the first key down until all the keys are released.
+ */
+void KEYPAD_init(void);
+
+/*
+ * Description :
+ * Get the oldest key event without waiting.
+ * Return FALSE if there is no event.
+ */
+boolean KEYPAD_getEvent(KEYPAD_EventType *event);
+
+/*
+ * Description :
+ * Get the oldest key event, sleep until there is one.
+ */
+void KEYPAD_waitEvent(KEYPAD_EventType *event);
+
+/*
+ * Description :
+ * Get the Keypad pressed button, sleep until a key is pressed if there is
+ * no press event yet. The other events are dropped.
  */
 uint8 KEYPAD_getPressedKey(void);
 
@@ -14,6 +14,139 @@
 #include "common_macros.h" /*For GET_BIT macro*/
 #include "lcd.h"
 #include "gpio.h"
+#include "prof.h"
+#include <avr/pgmspace.h>
+#include <stdlib.h>         /* For itoa */
+#if (LCD_ASYNC_REFRESH == TRUE)
+#include "timer1.h"
+#include "power.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#endif
+
+#if((LCD_DATA_BITS_MODE == 4) && ((LCD_DB5_PIN_ID != LCD_DB4_PIN_ID + 1) || \
+	(LCD_DB6_PIN_ID != LCD_DB4_PIN_ID + 2) || (LCD_DB7_PIN_ID != LCD_DB4_PIN_ID + 3)))
+
+#error "The LCD DB4-DB7 pins should be consecutive pins"
+
+#endif
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/* DDRAM address of the first cell of each row */
+static const uint8 g_rowAddress[4] = {0x00, 0x40, LCD_COLS, 0x40 + LCD_COLS};
+
+/* Writes asked by the application and writes sent on the LCD bus */
+static uint16 g_requestedWrites = 0;
+static volatile uint16 g_busWrites = 0;
+
+/*
+ * DDRAM address the LCD will write next, LCD_UNKNOWN_ADDRESS after a command.
+ * A cursor move to it is not sent, by LCD_sendCommand() in the direct mode and
+ * by the frame drawing in the frame buffer mode.
+ */
+static volatile uint8 g_lcdAddress = 0;
+#define LCD_UNKNOWN_ADDRESS              0xFF
+
+#if (LCD_FRAMEBUFFER == TRUE)
+/* Screen drawn by the application and screen shown on the LCD */
+static volatile uint8 g_frame[LCD_ROWS][LCD_COLS];
+static volatile uint8 g_shown[LCD_ROWS][LCD_COLS];
+
+/* Cursor of the application in the frame buffer */
+static uint8 g_cursorRow = 0;
+static uint8 g_cursorCol = 0;
+#endif
+
+#if (LCD_ASYNC_REFRESH == TRUE)
+/* Work left to the refresh interrupt */
+#define LCD_REFRESH_IDLE                 0
+#define LCD_REFRESH_CLEAR                1
+#define LCD_REFRESH_DRAW                 2
+static volatile uint8 g_refreshState = LCD_REFRESH_IDLE;
+
+/*
+ * Refresh ticks left until the LCD ends the clear command, so the busy flag is
+ * never polled for long inside the interrupt.
+ */
+#define LCD_CLEAR_TICKS                  ((LCD_LONG_EXECUTION_US / (LCD_REFRESH_PERIOD_MS * 1000UL)) + 1)
+static volatile uint8 g_refreshHold = 0;
+
+/* The refresh interrupt reads the busy flag once, a busy LCD is written on the next tick */
+#define LCD_REFRESH_POLL_LIMIT           1
+
+/* Timer1 subscriber id of the refresh function while a frame is being shown */
+static volatile uint8 g_refreshTickId = TIMER1_INVALID_SUBSCRIBER;
+#endif
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Wait until the LCD can take a new write, by polling its busy flag up to the
+ * given number of reads or by nothing when the execution time is waited after
+ * every write. It returns FALSE when the LCD is still busy.
+ */
+static boolean LCD_waitReady(uint16 poll_limit);
+
+/*
+ * Write a command (RS = 0) or a data (RS = 1) byte to the LCD.
+ */
+static void LCD_write(uint8 rs, uint8 value);
+
+/*
+ * Write a command or a data byte to the LCD if it gets ready within the given
+ * number of busy flag reads, it returns FALSE when nothing was written.
+ */
+static boolean LCD_tryWrite(uint8 rs, uint8 value, uint16 poll_limit);
+
+/*
+ * Write a run of data bytes to the LCD, the characters go to consecutive DDRAM
+ * addresses through the LCD address auto increment. RS is set high once for the
+ * whole run only without the busy flag polling.
+ */
+static void LCD_writeData(const uint8 *data, uint8 count);
+
+/*
+ * Clock one byte on the data bus with the E pulses, one pulse in 8-bits mode
+ * and two in 4-bits mode.
+ */
+static void LCD_strobe(uint8 value);
+
+/*
+ * Clock the high nibble of the value on DB4-DB7 in 4-bits mode, or the whole
+ * value in 8-bits mode, with one E pulse.
+ */
+static void LCD_pulse(uint8 value);
+
+#if (LCD_FRAMEBUFFER == FALSE)
+/*
+ * Display a run of characters at the LCD address.
+ */
+static void LCD_displayRun(const uint8 *data, uint8 count);
+#endif
+
+#if (LCD_FRAMEBUFFER == TRUE)
+/*
+ * Count or send the writes needed to show the frame buffer on the LCD.
+ */
+static uint8 LCD_drawFrame(boolean cleared, boolean send);
+
+/*
+ * Check whether a cell of the frame buffer differs from the LCD.
+ */
+static boolean LCD_isCellChanged(uint8 row, uint8 col, boolean cleared);
+#endif
+
+#if (LCD_ASYNC_REFRESH == TRUE)
+/*
+ * Send the next write of the flushed frame, called from the Timer1 compare B interrupt.
+ */
+static void LCD_refresh(void);
+#endif
 
 /*******************************************************************************
  *                      Functions Definitions                                  *
@@ -27,37 +160,74 @@
  */
 void LCD_init(void)
 {
-	/* Configure the direction of RS and E pins as output pins */
+#if (LCD_FRAMEBUFFER == TRUE)
+	uint8 row,col;
+#endif
+
+	/* Configure the direction of RS, RW and E pins as output pins, RW = 0 for the writes */
 	GPIO_setupPinDirection(LCD_RS_PORT_ID,LCD_RS_PIN_ID,PIN_OUTPUT);
 	GPIO_setupPinDirection(LCD_E_PORT_ID,LCD_E_PIN_ID,PIN_OUTPUT);
+	GPIO_writePin(LCD_RW_PORT_ID,LCD_RW_PIN_ID,LOGIC_LOW);
+	GPIO_setupPinDirection(LCD_RW_PORT_ID,LCD_RW_PIN_ID,PIN_OUTPUT);
 
 	_delay_ms(20);   /* LCD Power ON delay > 15ms */
 
 #if(LCD_DATA_BITS_MODE == 4)
-	/* Configure 4 pins in the data port as output pins */
-	GPIO_setupPinDirectio(LCD_DATA_PORT_ID,LCD_DB4_PIN_ID,PIN_OUTPUT);
-	GPIO_setupPinDirectio(LCD_DATA_PORT_ID,LCD_DB5_PIN_ID,PIN_OUTPUT);
-	GPIO_setupPinDirectio(LCD_DATA_PORT_ID,LCD_DB6_PIN_ID,PIN_OUTPUT);
-	GPIO_setupPinDirectio(LCD_DATA_PORT_ID,LCD_DB7_PIN_ID,PIN_OUTPUT);
-
-	/* Send for 4 bit initialization of LCD */
-	LCD_sendCommand(LCD_TWO_LINES_FOUR_BITS_MODE_INT1);
-	LCD_sendCommand(LCD_TWO_LINES_FOUR_BITS_MODE_INT2);
-
-	/* Use 2-lines LCD + 4-bits Data Mode + 5*7 dot display Mode */
-	LCD_sendCommand(LCD_TWO_LINES_FOUR_BITS_MODE);
-
+	/* Configure 4 pins in the data port as output pins, the other pins are not changed */
+	GPIO_setupPortDirectionMasked(LCD_DATA_PORT_ID,LCD_DATA_PINS_MASK,PORT_OUTPUT);
 #elif(LCD_DATA_BITS_MODE == 8)
 	/* Configure the data port as output port */
 	GPIO_setupPortDirection(LCD_DATA_PORT_ID,PORT_OUTPUT);
+#endif
 
-	/* Use 2-lines LCD + 4-bits Data Mode + 5*7 dot display Mode */
-	LCD_sendCommand(LCD_TWO_LINES_EIGHT_BITS_MODE);
+	/*
+	 * Initialization by instruction: the LCD interface mode is unknown until the
+	 * function sets are latched, so they are sent one E pulse at a time with the
+	 * datasheet waits and the busy flag is not read before.
+	 */
+	GPIO_WRITE_PIN(LCD_RS_PORT_ID,LCD_RS_PIN_ID,LOGIC_LOW);
+	LCD_pulse(LCD_FUNCTION_SET_RESET);
+	_delay_ms(5);    /* > 4.1ms */
+	LCD_pulse(LCD_FUNCTION_SET_RESET);
+	_delay_us(150);  /* > 100us */
+	LCD_pulse(LCD_FUNCTION_SET_RESET);
+	_delay_us(LCD_EXECUTION_US);
 
-#endif
-	LCD_sendCommand(LCD_CURSOR_OFF); /* Cursor OFF */
-	LCD_sendCommand(LCD_CLEAR_COMMAND); /* Clear LCD at the beginning */
+#if(LCD_DATA_BITS_MODE == 4)
+	/* Switch to the 4-bits interface, this function set is still one pulse */
+	LCD_pulse(LCD_FUNCTION_SET_FOUR_BITS);
+	_delay_us(LCD_EXECUTION_US);
 
+	/* Use 2-lines LCD + 4-bits Data Mode + 5*7 dot display Mode */
+	LCD_strobe(LCD_TWO_LINES_FOUR_BITS_MODE);
+#elif(LCD_DATA_BITS_MODE == 8)
+	/* Use 2-lines LCD + 8-bits Data Mode + 5*7 dot display Mode */
+	LCD_strobe(LCD_TWO_LINES_EIGHT_BITS_MODE);
+#endif
+	_delay_us(LCD_EXECUTION_US);
+
+	/*
+	 * The interface is set, the busy flag can be polled from now on. The init
+	 * commands go straight to the bus, LCD_sendCommand would wait for the
+	 * refresh which is only subscribed at the end.
+	 */
+	LCD_write(LOGIC_LOW,LCD_CURSOR_OFF); /* Cursor OFF */
+	LCD_write(LOGIC_LOW,LCD_CLEAR_COMMAND); /* Clear LCD at the beginning */
+
+#if (LCD_FRAMEBUFFER == TRUE)
+	/* The LCD and the frame buffer both start blank */
+	for(row = 0 ; row < LCD_ROWS ; row++)
+	{
+		for(col = 0 ; col < LCD_COLS ; col++)
+		{
+			g_frame[row][col] = ' ';
+			g_shown[row][col] = ' ';
+		}
+	}
+	g_cursorRow = 0;
+	g_cursorCol = 0;
+	g_lcdAddress = 0;
+#endif
 }
 
 /*[FUNCTION NAME]	: LCD_sendCommand
@@ -67,38 +237,81 @@ void LCD_init(void)
  */
 void LCD_sendCommand(uint8 cmd)
 {
-	GPIO_writePin(LCD_RS_PORT_ID,LCD_RS_PIN_ID,LOGIC_LOW); /* Instruction mode -> RS = 0 */
-	_delay_ms(1);
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_HIGH); /* Enable LCD E = 1 */
-	_delay_ms(1);
+#if (LCD_FRAMEBUFFER == TRUE)
+	uint8 row,col;
 
-#if(LCD_DATA_BITS_MODE == 4)
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB4_PIN_ID,GET_BIT(cmd,4));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB5_PIN_ID,GET_BIT(cmd,5));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB6_PIN_ID,GET_BIT(cmd,6));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB7_PIN_ID,GET_BIT(cmd,7));
-
-	_delay_ms(1); /* Delay for processing Tdsw = 100ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD -> E = 0 */
-	_delay_ms(1);/* Dealy for processing Th = 13ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_HIGH); /* Enable LCD E = 1 */
-	_delay_ms(1);/* Delay for processing Tpw - Tdws  = 190ns */
-
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB4_PIN_ID,GET_BIT(cmd,0));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB5_PIN_ID,GET_BIT(cmd,1));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB6_PIN_ID,GET_BIT(cmd,2));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB7_PIN_ID,GET_BIT(cmd,3));
-
-	_delay_ms(1); /* delay for processing Tdsw = 100ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0 */
-	_delay_ms(1); /* delay for processing Th = 13ns */
+	g_requestedWrites++;
 
-#elif(LCD_DATA_BITS_MODE == 8)
-	GPIO_writePort(LCD_DATA_PORT_ID,cmd); /* Write the required command to the data bus D0 --> D7 */
-	_delay_ms(1); /* delay for processing Tdsw = 100ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0 */
-	_delay_ms(1); /* delay for processing Th = 13ns */
+	/* The commands that only change the screen content or the cursor are applied on the frame buffer */
+	if(cmd == LCD_CLEAR_COMMAND)
+	{
+		for(row = 0 ; row < LCD_ROWS ; row++)
+		{
+			for(col = 0 ; col < LCD_COLS ; col++)
+			{
+				g_frame[row][col] = ' ';
+			}
+		}
+		g_cursorRow = 0;
+		g_cursorCol = 0;
+	}
+	else if(cmd & LCD_SET_CURSOR_LOCATION)
+	{
+		cmd &= ~LCD_SET_CURSOR_LOCATION;
+		for(row = 0 ; row < LCD_ROWS ; row++)
+		{
+			if((cmd >= g_rowAddress[row]) && (cmd < g_rowAddress[row] + LCD_COLS))
+			{
+				g_cursorRow = row;
+				g_cursorCol = cmd - g_rowAddress[row];
+				return;
+			}
+		}
+		/* Out of the visible screen */
+		g_cursorCol = LCD_COLS;
+	}
+	else if(cmd == LCD_CURSOR_SHIFT_LEFT)
+	{
+		if(g_cursorCol > 0)
+		{
+			g_cursorCol--;
+		}
+	}
+	else
+	{
+		/* Any other command acts on the LCD itself, show the frame first */
+		LCD_flush();
+		LCD_waitRefresh();
+		LCD_write(LOGIC_LOW,cmd);
+		g_lcdAddress = LCD_UNKNOWN_ADDRESS;
+	}
+#else
+	g_requestedWrites++;
+
+	/*
+	 * The LCD is already at the required address, this check is for the direct mode
+	 * only, the frame buffer mode does it while drawing the frame.
+	 */
+	if((g_lcdAddress != LCD_UNKNOWN_ADDRESS) && (cmd == (g_lcdAddress | LCD_SET_CURSOR_LOCATION)))
+	{
+		return;
+	}
+
+	LCD_write(LOGIC_LOW,cmd); /* Instruction mode -> RS = 0 */
 
+	/* Follow the LCD address after the command */
+	if(cmd & LCD_SET_CURSOR_LOCATION)
+	{
+		g_lcdAddress = cmd & ~LCD_SET_CURSOR_LOCATION;
+	}
+	else if(cmd == LCD_CLEAR_COMMAND)
+	{
+		g_lcdAddress = 0;
+	}
+	else
+	{
+		g_lcdAddress = LCD_UNKNOWN_ADDRESS;
+	}
 #endif
 }
 
@@ -109,39 +322,20 @@ void LCD_sendCommand(uint8 cmd)
  */
 void LCD_displayCharacter(uint8 data)
 {
-	GPIO_writePin(LCD_RS_PORT_ID,LCD_RS_PIN_ID,LOGIC_HIGH); /* Data mode -> RS = 1 */
-	_delay_ms(1);/* Dealy for processing Tas = 50ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_HIGH); /* Enable LCD E = 1 */
-	_delay_ms(1);/* Dealy for processing Tpw - Tdws = 190ns */
-
-#if(LCD_DATA_BITS_MODE == 4)
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB4_PIN_ID,GET_BIT(data,4));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB5_PIN_ID,GET_BIT(data,5));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB6_PIN_ID,GET_BIT(data,6));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB7_PIN_ID,GET_BIT(data,7));
-
-	_delay_ms(1); /* Delay for processing Tdsw = 100ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD -> E = 0 */
-	_delay_ms(1);/* Dealy for processing Th = 13ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_HIGH); /* Enable LCD E = 1 */
-	_delay_ms(1);/* Delay for processing Tpw - Tdws  = 190ns */
-
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB4_PIN_ID,GET_BIT(data,0));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB5_PIN_ID,GET_BIT(data,1));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB6_PIN_ID,GET_BIT(data,2));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB7_PIN_ID,GET_BIT(data,3));
-
-	_delay_ms(1); /* delay for processing Tdsw = 100ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0 */
-	_delay_ms(1); /* delay for processing Th = 13ns */
-
-#elif(LCD_DATA_BITS_MODE == 8)
-	GPIO_writePort(LCD_DATA_PORT_ID,data); /* Write the required command to the data bus D0 --> D7 */
-	_delay_ms(1); /* delay for processing Tdsw = 100ns */
-
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0 */
-	_delay_ms(1); /* delay for processing Th = 13ns */
-
+	g_requestedWrites++;
+#if (LCD_FRAMEBUFFER == TRUE)
+	/* The characters out of the visible screen are dropped */
+	if(g_cursorCol < LCD_COLS)
+	{
+		g_frame[g_cursorRow][g_cursorCol] = data;
+		g_cursorCol++;
+	}
+#else
+	LCD_write(LOGIC_HIGH,data); /* Data mode -> RS = 1 */
+	if(g_lcdAddress != LCD_UNKNOWN_ADDRESS)
+	{
+		g_lcdAddress++;
+	}
 #endif
 }
 
@@ -153,11 +347,23 @@ void LCD_displayCharacter(uint8 data)
 void LCD_displayString(const char *str)
 {
 	uint8 i = 0;
+
+	PROF_BEGIN(PROF_ID_LCD_DISPLAY_STRING);
+#if (LCD_FRAMEBUFFER == TRUE)
 	while(str[i] != '\0')
 	{
 		LCD_displayCharacter(str[i]);
 		i++;
 	}
+#else
+	/* The whole string is one run of data writes */
+	while(str[i] != '\0')
+	{
+		i++;
+	}
+	LCD_displayRun((const uint8 *)str,i);
+#endif
+	PROF_END(PROF_ID_LCD_DISPLAY_STRING);
 }
 
 /*[FUNCTION NAME]	: LCD_moveCursor
@@ -170,21 +376,8 @@ void LCD_moveCursor(uint8 row,uint8 col)
 	uint8 lcd_memory_address;
 
 	/* Calculate the required address in the LCD DDRAM */
-	switch(row)
-	{
-	case 0:
-		lcd_memory_address = col;
-		break;
-	case 1:
-		lcd_memory_address = col + 0x40;
-		break;
-	case 2:
-		lcd_memory_address = col + 0x10;
-		break;
-	case 3:
-		lcd_memory_address = col + 0x50;
-		break;
-	}
+	lcd_memory_address = g_rowAddress[row & 0x03] + col;
+
 	/* Move the LCD cursor to this specific address */
 	LCD_sendCommand(lcd_memory_address | LCD_SET_CURSOR_LOCATION);
 
@@ -202,6 +395,56 @@ void LCD_displayStringRowColumn(uint8 row,uint8 col, const char *str)
 	LCD_displayString(str);  /* Display String */
 }
 
+/*[FUNCTION NAME]	: LCD_displayString_P
+ *[DESCRIPTION]		: Display the required string kept in the flash memory on the screen
+ *[ARGUMENTS]		: pointer to a string in the program memory (PROGMEM)
+ *[RETURNS]			: void
+ */
+void LCD_displayString_P(const char *str)
+{
+	char character;
+#if (LCD_FRAMEBUFFER == FALSE)
+	uint8 run[LCD_COLS];
+	uint8 count = 0;
+#endif
+
+	PROF_BEGIN(PROF_ID_LCD_DISPLAY_STRING);
+	character = pgm_read_byte(str);
+	while(character != '\0')
+	{
+#if (LCD_FRAMEBUFFER == TRUE)
+		LCD_displayCharacter(character);
+#else
+		/* Copy the string to RAM one row at a time and write it as one run */
+		run[count] = character;
+		count++;
+		if(count == LCD_COLS)
+		{
+			LCD_displayRun(run,count);
+			count = 0;
+		}
+#endif
+		str++;
+		character = pgm_read_byte(str);
+	}
+#if (LCD_FRAMEBUFFER == FALSE)
+	LCD_displayRun(run,count);
+#endif
+	PROF_END(PROF_ID_LCD_DISPLAY_STRING);
+}
+
+/*[FUNCTION NAME]	: LCD_displayStringRowColumn_P
+ *[DESCRIPTION]		: Display the required flash string in a specified row and column index on the screen
+ *[ARGUMENTS]		: 1.row number and column number of type uint8
+                      2.pointer to a string in the program memory (PROGMEM)
+ *[RETURNS]			: void
+ */
+void LCD_displayStringRowColumn_P(uint8 row,uint8 col, const char *str)
+{
+	LCD_moveCursor(row,col); /* Go to the required LCD position */
+	LCD_displayString_P(str);  /* Display String */
+}
+
 /*[FUNCTION NAME]	: LCD_integerToString
  *[DESCRIPTION]		: Display the required decimal value on the screen
  *[ARGUMENTS]		: data of type int
@@ -225,4 +468,435 @@ void LCD_clearScreen(void)
 	LCD_sendCommand(LCD_CLEAR_COMMAND); /* Send clear display command */
 }
 
+/*[FUNCTION NAME]	: LCD_flush
+ *[DESCRIPTION]		: Send the changed cells of the frame buffer to the LCD, in the asynchronous mode
+ *                    the refresh is subscribed to Timer1 until the frame is shown and the frame is
+ *                    drawn right away when no Timer1 slot is free
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: void
+ */
+void LCD_flush(void)
+{
+#if (LCD_FRAMEBUFFER == TRUE)
+	boolean clear;
+#if (LCD_ASYNC_REFRESH == TRUE)
+	uint8 sreg = SREG;
+	boolean refreshed;
+#endif
+
+	PROF_BEGIN(PROF_ID_LCD_FLUSH);
 
+	/*
+	 * When most of the screen changes the clear command and the visible
+	 * characters of the new screen cost less writes than the changed cells.
+	 */
+	clear = (LCD_drawFrame(TRUE,FALSE) < LCD_drawFrame(FALSE,FALSE));
+
+#if (LCD_ASYNC_REFRESH == TRUE)
+	/* The refresh interrupt reads the frame buffer cell by cell until it is all shown */
+	cli();
+	if(g_refreshTickId == TIMER1_INVALID_SUBSCRIBER)
+	{
+		g_refreshTickId = Timer1_subscribe(TIMER1_COMPB_CHANNEL, LCD_refresh, LCD_REFRESH_PERIOD_MS);
+	}
+	refreshed = (g_refreshTickId != TIMER1_INVALID_SUBSCRIBER);
+	if(refreshed)
+	{
+		g_refreshState = clear ? LCD_REFRESH_CLEAR : LCD_REFRESH_DRAW;
+	}
+	SREG = sreg;
+
+	if(!refreshed)
+#endif
+	{
+		/* Without the refresh interrupt the frame is drawn right away */
+		if(clear)
+		{
+			LCD_write(LOGIC_LOW,LCD_CLEAR_COMMAND);
+			g_lcdAddress = 0;
+			LCD_drawFrame(TRUE,TRUE);
+		}
+		else
+		{
+			LCD_drawFrame(FALSE,TRUE);
+		}
+	}
+
+	PROF_END(PROF_ID_LCD_FLUSH);
+#endif
+}
+
+/*[FUNCTION NAME]	: LCD_waitRefresh
+ *[DESCRIPTION]		: Wait until the LCD shows the last flushed frame
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: void
+ */
+void LCD_waitRefresh(void)
+{
+#if (LCD_ASYNC_REFRESH == TRUE)
+	/* Sleep between the refresh ticks */
+	POWER_WAIT_WHILE((g_refreshState != LCD_REFRESH_IDLE) || (g_refreshHold != 0));
+#endif
+}
+
+/*[FUNCTION NAME]	: LCD_getStatistics
+ *[DESCRIPTION]		: Get the number of writes asked by the application and sent on the LCD bus
+ *[ARGUMENTS]		: pointers to the number of writes of type uint16
+ *[RETURNS]			: void
+ */
+void LCD_getStatistics(uint16 *requested_writes, uint16 *bus_writes)
+{
+#if (LCD_ASYNC_REFRESH == TRUE)
+	uint8 sreg = SREG;
+
+	/* The bus writes are counted in the refresh interrupt */
+	cli();
+#endif
+	*requested_writes = g_requestedWrites;
+	*bus_writes = g_busWrites;
+#if (LCD_ASYNC_REFRESH == TRUE)
+	SREG = sreg;
+#endif
+}
+
+/*[FUNCTION NAME]	: LCD_resetStatistics
+ *[DESCRIPTION]		: Restart counting the LCD writes
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: void
+ */
+void LCD_resetStatistics(void)
+{
+#if (LCD_ASYNC_REFRESH == TRUE)
+	uint8 sreg = SREG;
+
+	cli();
+#endif
+	g_requestedWrites = 0;
+	g_busWrites = 0;
+#if (LCD_ASYNC_REFRESH == TRUE)
+	SREG = sreg;
+#endif
+}
+
+#if (LCD_FRAMEBUFFER == TRUE)
+/*[FUNCTION NAME]	: LCD_isCellChanged
+ *[DESCRIPTION]		: Check whether a cell of the frame buffer differs from the LCD
+ *[ARGUMENTS]		: row and column of the cell of type uint8
+ *					  cleared: TRUE if the LCD is blank, FALSE if it shows the last flushed frame
+ *[RETURNS]			: TRUE if the cell should be written
+ */
+static boolean LCD_isCellChanged(uint8 row, uint8 col, boolean cleared)
+{
+	uint8 shown = cleared ? ' ' : g_shown[row][col];
+
+	return (g_frame[row][col] != shown);
+}
+
+/*[FUNCTION NAME]	: LCD_drawFrame
+ *[DESCRIPTION]		: Count or send the writes needed to show the frame buffer on the LCD
+ *[ARGUMENTS]		: cleared: TRUE if the LCD is blank, FALSE if it shows the last flushed frame
+ *					  send: TRUE to send the writes, FALSE to only count them
+ *[RETURNS]			: the number of writes on the LCD bus
+ */
+static uint8 LCD_drawFrame(boolean cleared, boolean send)
+{
+	uint8 row,col,i;
+	uint8 address;
+	uint8 count;
+	uint8 run[LCD_COLS];
+	uint8 lcd_address = g_lcdAddress;
+	uint8 writes = 0;
+
+	if(cleared)
+	{
+		lcd_address = 0;
+		if(send)
+		{
+			for(row = 0 ; row < LCD_ROWS ; row++)
+			{
+				for(col = 0 ; col < LCD_COLS ; col++)
+				{
+					g_shown[row][col] = ' ';
+				}
+			}
+		}
+	}
+
+	for(row = 0 ; row < LCD_ROWS ; row++)
+	{
+		col = 0;
+		while(col < LCD_COLS)
+		{
+			/*
+			 * Collect the run of changed cells starting at this column, one unchanged
+			 * cell between two changed ones is written again as it costs the same
+			 * write as an address command and keeps the run going.
+			 */
+			count = 0;
+			while(((col + count) < LCD_COLS) &&
+					(LCD_isCellChanged(row,col + count,cleared) ||
+					((count != 0) && ((col + count + 1) < LCD_COLS) && LCD_isCellChanged(row,col + count + 1,cleared))))
+			{
+				run[count] = g_frame[row][col + count];
+				count++;
+			}
+
+			if(count == 0)
+			{
+				col++;
+			}
+			else
+			{
+				/* The LCD address moves on by itself after a write, set it only after a gap */
+				address = g_rowAddress[row] + col;
+				if(address != lcd_address)
+				{
+					writes++;
+					if(send)
+					{
+						LCD_write(LOGIC_LOW,address | LCD_SET_CURSOR_LOCATION);
+					}
+				}
+				writes += count;
+				if(send)
+				{
+					LCD_writeData(run,count);
+					for(i = 0 ; i < count ; i++)
+					{
+						g_shown[row][col + i] = run[i];
+					}
+				}
+				lcd_address = address + count;
+				col += count;
+			}
+		}
+	}
+
+	if(send)
+	{
+		g_lcdAddress = lcd_address;
+	}
+	return writes;
+}
+#endif
+
+#if (LCD_ASYNC_REFRESH == TRUE)
+static void LCD_refresh(void)
+{
+	uint8 row,col;
+	uint8 address;
+	uint8 data;
+
+	/* Give the LCD the execution time of the clear command */
+	if(g_refreshHold != 0)
+	{
+		g_refreshHold--;
+		return;
+	}
+
+	if(g_refreshState == LCD_REFRESH_CLEAR)
+	{
+		if(!LCD_tryWrite(LOGIC_LOW,LCD_CLEAR_COMMAND,LCD_REFRESH_POLL_LIMIT))
+		{
+			return;
+		}
+		for(row = 0 ; row < LCD_ROWS ; row++)
+		{
+			for(col = 0 ; col < LCD_COLS ; col++)
+			{
+				g_shown[row][col] = ' ';
+			}
+		}
+		g_lcdAddress = 0;
+		g_refreshHold = LCD_CLEAR_TICKS;
+		g_refreshState = LCD_REFRESH_DRAW;
+		return;
+	}
+
+	if(g_refreshState == LCD_REFRESH_DRAW)
+	{
+		/* Send one write for the first changed cell, the address first if the LCD is not there */
+		for(row = 0 ; row < LCD_ROWS ; row++)
+		{
+			for(col = 0 ; col < LCD_COLS ; col++)
+			{
+				data = g_frame[row][col];
+				if(data != g_shown[row][col])
+				{
+					address = g_rowAddress[row] + col;
+					if(address != g_lcdAddress)
+					{
+						if(LCD_tryWrite(LOGIC_LOW,address | LCD_SET_CURSOR_LOCATION,LCD_REFRESH_POLL_LIMIT))
+						{
+							g_lcdAddress = address;
+						}
+					}
+					else
+					{
+						if(LCD_tryWrite(LOGIC_HIGH,data,LCD_REFRESH_POLL_LIMIT))
+						{
+							g_shown[row][col] = data;
+							g_lcdAddress = address + 1;
+						}
+					}
+					return;
+				}
+			}
+		}
+
+		/* All the frame is shown, stop waking the CPU until the next flush */
+		g_refreshState = LCD_REFRESH_IDLE;
+		Timer1_unsubscribe(g_refreshTickId);
+		g_refreshTickId = TIMER1_INVALID_SUBSCRIBER;
+	}
+}
+#endif
+
+static boolean LCD_waitReady(uint16 poll_limit)
+{
+#if (LCD_BUSY_FLAG_POLLING == TRUE)
+	uint16 polls = 0;
+	uint8 busy;
+
+	/* Release the data bus to the LCD and select the instruction register read */
+#if(LCD_DATA_BITS_MODE == 4)
+	GPIO_SETUP_PORT_DIRECTION_MASKED(LCD_DATA_PORT_ID,LCD_DATA_PINS_MASK,PORT_INPUT);
+#elif(LCD_DATA_BITS_MODE == 8)
+	GPIO_SETUP_PORT_DIRECTION(LCD_DATA_PORT_ID,PORT_INPUT);
+#endif
+	GPIO_WRITE_PIN(LCD_RS_PORT_ID,LCD_RS_PIN_ID,LOGIC_LOW);
+	GPIO_WRITE_PIN(LCD_RW_PORT_ID,LCD_RW_PIN_ID,LOGIC_HIGH);
+
+	do
+	{
+		GPIO_WRITE_PIN(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_HIGH); /* Enable LCD E = 1 */
+		_delay_us(1); /* Delay for the data output Tddr = 160ns */
+		busy = GPIO_READ_PIN(LCD_DATA_PORT_ID,LCD_BUSY_FLAG_PIN_ID);
+		GPIO_WRITE_PIN(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E = 0 */
+#if(LCD_DATA_BITS_MODE == 4)
+		/* Clock out the low nibble (address counter) too */
+		_delay_us(1);
+		GPIO_WRITE_PIN(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_HIGH);
+		_delay_us(1);
+		GPIO_WRITE_PIN(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW);
+#endif
+		_delay_us(1); /* Enable cycle time Tcycle = 500ns */
+		polls++;
+	}while((busy == LOGIC_HIGH) && (polls < poll_limit));
+
+	/* Take the data bus back for the write */
+	GPIO_WRITE_PIN(LCD_RW_PORT_ID,LCD_RW_PIN_ID,LOGIC_LOW);
+#if(LCD_DATA_BITS_MODE == 4)
+	GPIO_SETUP_PORT_DIRECTION_MASKED(LCD_DATA_PORT_ID,LCD_DATA_PINS_MASK,PORT_OUTPUT);
+#elif(LCD_DATA_BITS_MODE == 8)
+	GPIO_SETUP_PORT_DIRECTION(LCD_DATA_PORT_ID,PORT_OUTPUT);
+#endif
+	return (busy == LOGIC_LOW);
+#else
+	return TRUE;
+#endif
+}
+
+static void LCD_write(uint8 rs, uint8 value)
+{
+	/* A missing LCD is given up after LCD_BUSY_POLL_LIMIT reads */
+	LCD_tryWrite(rs,value,LCD_BUSY_POLL_LIMIT);
+}
+
+static boolean LCD_tryWrite(uint8 rs, uint8 value, uint16 poll_limit)
+{
+	boolean ready;
+
+	PROF_BEGIN(PROF_ID_LCD_WRITE);
+	ready = LCD_waitReady(poll_limit);
+	if(ready)
+	{
+		g_busWrites++;
+		GPIO_WRITE_PIN(LCD_RS_PORT_ID,LCD_RS_PIN_ID,rs); /* Tas = 40ns is covered by the call */
+		LCD_strobe(value);
+
+#if (LCD_BUSY_FLAG_POLLING == FALSE)
+		/* Wait for the LCD to execute the write, the clear and the return home commands are the slow ones */
+		if((rs == LOGIC_LOW) && (value <= (LCD_GO_TO_HOME | 1)))
+		{
+			_delay_us(LCD_LONG_EXECUTION_US);
+		}
+		else
+		{
+			_delay_us(LCD_EXECUTION_US);
+		}
+#endif
+	}
+	PROF_END(PROF_ID_LCD_WRITE);
+	return ready;
+}
+
+static void LCD_writeData(const uint8 *data, uint8 count)
+{
+	uint8 i;
+
+	g_busWrites += count;
+
+#if (LCD_BUSY_FLAG_POLLING == TRUE)
+	/*
+	 * The busy flag is read with RS = 0 before each character, so RS is switched
+	 * for every character and the run only saves the address commands.
+	 */
+	for(i = 0 ; i < count ; i++)
+	{
+		PROF_BEGIN(PROF_ID_LCD_WRITE);
+		LCD_waitReady(LCD_BUSY_POLL_LIMIT);
+		GPIO_WRITE_PIN(LCD_RS_PORT_ID,LCD_RS_PIN_ID,LOGIC_HIGH);
+		LCD_strobe(data[i]);
+		PROF_END(PROF_ID_LCD_WRITE);
+	}
+#else
+	/* RS stays high for all the run, each character waits its execution time */
+	GPIO_WRITE_PIN(LCD_RS_PORT_ID,LCD_RS_PIN_ID,LOGIC_HIGH);
+	for(i = 0 ; i < count ; i++)
+	{
+		PROF_BEGIN(PROF_ID_LCD_WRITE);
+		LCD_strobe(data[i]);
+		_delay_us(LCD_EXECUTION_US);
+		PROF_END(PROF_ID_LCD_WRITE);
+	}
+#endif
+}
+
+static void LCD_strobe(uint8 value)
+{
+#if(LCD_DATA_BITS_MODE == 4)
+	LCD_pulse(value);       /* High nibble */
+	_delay_us(1);           /* Enable cycle time Tcycle = 500ns */
+	LCD_pulse(value << 4);  /* Low nibble */
+#elif(LCD_DATA_BITS_MODE == 8)
+	LCD_pulse(value);
+#endif
+}
+
+static void LCD_pulse(uint8 value)
+{
+	GPIO_WRITE_PIN(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_HIGH); /* Enable LCD E = 1 */
+
+#if(LCD_DATA_BITS_MODE == 4)
+	/* High nibble on DB4-DB7 in one port update */
+	GPIO_WRITE_PORT_FIELD(LCD_DATA_PORT_ID,LCD_DATA_PINS_MASK,LCD_NIBBLE(value >> 4));
+#elif(LCD_DATA_BITS_MODE == 8)
+	GPIO_WRITE_PORT(LCD_DATA_PORT_ID,value); /* Write the required value to the data bus D0 --> D7 */
+#endif
+
+	_delay_us(1); /* Delay for processing Tdsw = 80ns and Tpw = 230ns */
+	GPIO_WRITE_PIN(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E = 0 */
+}
+
+#if (LCD_FRAMEBUFFER == FALSE)
+static void LCD_displayRun(const uint8 *data, uint8 count)
+{
+	g_requestedWrites += count;
+	LCD_writeData(data,count);
+	if(g_lcdAddress != LCD_UNKNOWN_ADDRESS)
+	{
+		g_lcdAddress += count;
+	}
+}
+#endif
@@ -19,8 +19,11 @@
  *                                Definitions                                  *
  *******************************************************************************/
 
-/* LCD Data bits mode configuration, its value should be 4 or 8*/
-#define LCD_DATA_BITS_MODE 8
+/*
+ * LCD Data bits mode configuration, its value should be 4 or 8.
+ * In 4-bits mode only DB4-DB7 are wired and PC0-PC3 are free for other uses.
+ */
+#define LCD_DATA_BITS_MODE 4
 
 #if((LCD_DATA_BITS_MODE != 4) && (LCD_DATA_BITS_MODE != 8))
 
@@ -28,6 +31,32 @@
 
 #endif
 
+/* LCD size */
+#define LCD_ROWS                         2
+#define LCD_COLS                         16
+
+/*
+ * TRUE : the display functions write into a RAM shadow of the screen and
+ *        LCD_flush() sends only the cells that changed since the last flush.
+ * FALSE: every display function writes to the LCD at once.
+ */
+#define LCD_FRAMEBUFFER                  TRUE
+
+/*
+ * TRUE : LCD_flush() only marks the frame buffer to be shown, a Timer1 compare B
+ *        subscriber sends one write per LCD_REFRESH_PERIOD_MS in the background
+ *        until the frame is shown.
+ * FALSE: LCD_flush() sends the writes before it returns.
+ */
+#define LCD_ASYNC_REFRESH                TRUE
+#define LCD_REFRESH_PERIOD_MS            1
+
+#if((LCD_ASYNC_REFRESH == TRUE) && (LCD_FRAMEBUFFER == FALSE))
+
+#error "The asynchronous refresh needs the LCD frame buffer"
+
+#endif
+
 /* LCD HW Ports and Pins IDs */
 #define LCD_RS_PORT_ID                   PORTD_ID
 #define LCD_RS_PIN_ID                    PIN2_ID
@@ -35,6 +64,9 @@
 #define LCD_E_PORT_ID                    PORTD_ID
 #define LCD_E_PIN_ID                     PIN3_ID
 
+#define LCD_RW_PORT_ID                   PORTD_ID
+#define LCD_RW_PIN_ID                    PIN4_ID
+
 #define LCD_DATA_PORT_ID                 PORTC_ID
 
 #if(LCD_DATA_BITS_MODE == 4)
@@ -44,6 +76,10 @@
 #define LCD_DB6_PIN_ID                   PIN6_ID
 #define LCD_DB7_PIN_ID                   PIN7_ID
 
+/* DB4-DB7 on four consecutive pins, a nibble is written with one port update */
+#define LCD_DATA_PINS_MASK               (0x0F << LCD_DB4_PIN_ID)
+#define LCD_NIBBLE(VALUE)                (((VALUE) & 0x0F) << LCD_DB4_PIN_ID)
+
 /*#elif(LCD_DATA_BITS_MODE == 8)
 
 #define LCD_DB0_PIN_ID                   PIN0_ID
@@ -57,16 +93,42 @@
 
 #endif
 
+/* Data pin of the busy flag */
+#if(LCD_DATA_BITS_MODE == 4)
+#define LCD_BUSY_FLAG_PIN_ID             LCD_DB7_PIN_ID
+#else
+#define LCD_BUSY_FLAG_PIN_ID             PIN7_ID
+#endif
+
+/*
+ * TRUE : wait for the LCD by reading its busy flag through the RW pin before every write.
+ * FALSE: RW may be tied to ground, wait the datasheet execution times after every write.
+ * The time of one write on the LCD bus is measured by the PROF_ID_LCD_WRITE probe in
+ * the profiling builds, the writes per second are F_CPU / avg. The refresh interrupt
+ * sends one write per LCD_REFRESH_PERIOD_MS whatever this time.
+ * The busy flag is read with RS = 0, so RS stays high for a whole run of characters
+ * only with FALSE, TRUE switches it for every character.
+ */
+#define LCD_BUSY_FLAG_POLLING            TRUE
+
+/* Datasheet execution times (fosc = 270kHz) of the clear/home commands and of the other writes */
+#define LCD_LONG_EXECUTION_US            1530
+#define LCD_EXECUTION_US                 43
+
+/* The busy flag stops being polled after this number of reads, in case the LCD is not connected */
+#define LCD_BUSY_POLL_LIMIT              1000
+
 /* LCD Commands */
 #define LCD_CLEAR_COMMAND                    0x01
 #define LCD_GO_TO_HOME                       0x02
 #define LCD_TWO_LINES_EIGHT_BITS_MODE        0x38
 #define LCD_TWO_LINES_FOUR_BITS_MODE         0x28
-#define LCD_TWO_LINES_FOUR_BITS_MODE_INIT1   0x33
-#define LCD_TWO_LINES_FOUR_BITS_MODE_INIT2   0x32
+#define LCD_FUNCTION_SET_RESET               0x30
+#define LCD_FUNCTION_SET_FOUR_BITS           0x20
 #define LCD_CURSOR_OFF                       0x0C
 #define LCD_CURSOR_ON                        0x0E
 #define LCD_SET_CURSOR_LOCATION              0x80
+#define LCD_CURSOR_SHIFT_LEFT                0x10
 
 /*******************************************************************************
  *                      Functions Prototypes                                   *
@@ -110,6 +172,19 @@ void LCD_moveCursor(uint8 row,uint8 col);
  */
 void LCD_displayStringRowColumn(uint8 row,uint8 col,const char *Str);
 
+/*
+ * Description :
+ * Display the required string kept in the flash memory (PROGMEM) on the screen
+ */
+void LCD_displayString_P(const char *Str);
+
+/*
+ * Description :
+ * Display the required string kept in the flash memory (PROGMEM) in a specified
+ * row and column index on the screen
+ */
+void LCD_displayStringRowColumn_P(uint8 row,uint8 col,const char *Str);
+
 /*
  * Description :
  * Display the required decimal value on the screen
@@ -122,4 +197,33 @@ void LCD_integerToString(int data);
  */
 void LCD_clearScreen(void);
 
+/*
+ * Description :
+ * Send the cells changed since the last flush to the LCD, one address command
+ * only where the changed cells are not contiguous.
+ * With the asynchronous refresh it returns at once and the cells are sent by the
+ * Timer1 interrupt, the cells are sent at once when no Timer1 slot is free.
+ * It does nothing if the frame buffer is not used.
+ */
+void LCD_flush(void);
+
+/*
+ * Description :
+ * Wait until the LCD shows the last flushed frame.
+ */
+void LCD_waitRefresh(void);
+
+/*
+ * Description :
+ * Get the number of writes asked by the application (what would be sent
+ * without the frame buffer) and the number of writes sent on the LCD bus.
+ */
+void LCD_getStatistics(uint16 *requested_writes, uint16 *bus_writes);
+
+/*
+ * Description :
+ * Restart counting the LCD writes.
+ */
+void LCD_resetStatistics(void);
+
 #endif /* LCD_H_ */
@@ -0,0 +1,87 @@
+ /******************************************************************************
+ *
+ * Module: POWER
+ *
+ * File Name: power.c
+ *
+ * Description: Source file for the AVR power management driver
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                      Used Header Files                                      *
+ *******************************************************************************/
+#include "power.h"
+#include "timer1.h"
+
+/*******************************************************************************
+ *                                Global Variables                             *
+ *******************************************************************************/
+
+/* Timer1 time stamp of the last statistics reset */
+static uint32 g_statisticsStart = 0;
+
+/* Timer1 counts spent in sleep since the last statistics reset */
+static uint32 g_sleepCounts = 0;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*[FUNCTION NAME]	: POWER_init
+ *[DESCRIPTION]		: Select the sleep mode and reset the sleep statistics
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: void
+ */
+void POWER_init(void)
+{
+	set_sleep_mode(POWER_SLEEP_MODE);
+	POWER_resetStatistics();
+}
+
+/*[FUNCTION NAME]	: POWER_sleep
+ *[DESCRIPTION]		: Sleep until any enabled interrupt wakes the CPU up
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: void
+ */
+void POWER_sleep(void)
+{
+	uint32 sleep_start = Timer1_getTimeStamp();
+
+	sleep_enable();
+	/* The instruction after sei() is always executed before any pending interrupt */
+	sei();
+	sleep_cpu();
+	sleep_disable();
+
+	g_sleepCounts += Timer1_getTimeStamp() - sleep_start;
+}
+
+/*[FUNCTION NAME]	: POWER_resetStatistics
+ *[DESCRIPTION]		: Restart measuring the time spent in sleep
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: void
+ */
+void POWER_resetStatistics(void)
+{
+	g_statisticsStart = Timer1_getTimeStamp();
+	g_sleepCounts = 0;
+}
+
+/*[FUNCTION NAME]	: POWER_getSleepPercentage
+ *[DESCRIPTION]		: Calculate the percentage of the time spent in sleep since the last reset
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: percentage of type uint8
+ */
+uint8 POWER_getSleepPercentage(void)
+{
+	uint32 elapsed = Timer1_getTimeStamp() - g_statisticsStart;
+
+	if(elapsed == 0)
+	{
+		return 0;
+	}
+	return (uint8)(((uint64)g_sleepCounts * 100) / elapsed);
+}
@@ -0,0 +1,80 @@
+ /******************************************************************************
+ *
+ * Module: POWER
+ *
+ * File Name: power.h
+ *
+ * Description: Header file for the AVR power management driver
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+#ifndef POWER_H_
+#define POWER_H_
+
+/*******************************************************************************
+ *                      Used Header Files                                      *
+ *******************************************************************************/
+#include "std_types.h"
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Sleep mode used while waiting for an event.
+ * Only the idle mode keeps Timer1, the UART and the TWI clocked, the power-save
+ * mode stops all of them and can only be woken up by an asynchronous Timer2.
+ */
+#define POWER_SLEEP_MODE                 SLEEP_MODE_IDLE
+
+/*
+ * Description :
+ * Sleep as long as the condition is true, the condition is checked with the
+ * interrupts disabled so a wake up event can't be lost between the check and
+ * the sleep instruction. The interrupts are enabled when the wait is over.
+ */
+#define POWER_WAIT_WHILE(CONDITION) \
+	do{ \
+		cli(); \
+		while(CONDITION) \
+		{ \
+			POWER_sleep(); \
+			cli(); \
+		} \
+		sei(); \
+	}while(0)
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Select the sleep mode and reset the sleep statistics.
+ */
+void POWER_init(void);
+
+/*
+ * Description :
+ * Put the CPU in sleep until any enabled interrupt wakes it up.
+ * It must be called with the interrupts disabled and it returns with the interrupts enabled.
+ */
+void POWER_sleep(void);
+
+/*
+ * Description :
+ * Restart measuring the time spent in sleep.
+ */
+void POWER_resetStatistics(void);
+
+/*
+ * Description :
+ * Return the percentage of the time spent in sleep since the last reset.
+ */
+uint8 POWER_getSleepPercentage(void);
+
+#endif /* POWER_H_ */
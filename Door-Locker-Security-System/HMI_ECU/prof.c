@@ -0,0 +1,174 @@
+ /******************************************************************************
+ *
+ * Module: PROFILER
+ *
+ * File Name: prof.c
+ *
+ * Description: Source file for the execution time profiler
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+#include "prof.h"
+
+#ifdef PROF_ENABLE
+
+#include "timer1.h"
+#include "power.h"
+#include "uart.h"
+
+/*******************************************************************************
+ *                      Structs, Enums, and Types                              *
+ *******************************************************************************/
+
+typedef struct{
+	uint32 start;
+	uint32 min;
+	uint32 max;
+	uint64 total;
+	uint32 count;
+}PROF_ProbeType;
+
+/*******************************************************************************
+ *                                Global Variables                             *
+ *******************************************************************************/
+
+/* Statistics of all the probes */
+static PROF_ProbeType g_probes[PROF_IDS_NUM];
+
+/* Cycles taken by the time stamp reading itself, subtracted from every measurement */
+static uint32 g_overhead = 0;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Send the decimal representation of a number through the UART.
+ */
+static void PROF_sendNumber(uint32 number);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*[FUNCTION NAME]	: PROF_init
+ *[DESCRIPTION]		: Clear the profiling table and measure the overhead of one probe pair
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: void
+ */
+void PROF_init(void)
+{
+	uint8 id;
+	uint32 start;
+
+	for(id = 0 ; id < PROF_IDS_NUM ; id++)
+	{
+		g_probes[id].min = 0xFFFFFFFFUL;
+		g_probes[id].max = 0;
+		g_probes[id].total = 0;
+		g_probes[id].count = 0;
+	}
+
+	start = Timer1_getTimeStamp();
+	g_overhead = Timer1_getTimeStamp() - start;
+}
+
+/*[FUNCTION NAME]	: PROF_begin
+ *[DESCRIPTION]		: Record the start time of the required probe
+ *[ARGUMENTS]		: probe id of type PROF_IdType
+ *[RETURNS]			: void
+ */
+void PROF_begin(PROF_IdType id)
+{
+	g_probes[id].start = Timer1_getTimeStamp();
+}
+
+/*[FUNCTION NAME]	: PROF_end
+ *[DESCRIPTION]		: Add the time elapsed since PROF_begin() to the probe statistics
+ *[ARGUMENTS]		: probe id of type PROF_IdType
+ *[RETURNS]			: void
+ */
+void PROF_end(PROF_IdType id)
+{
+	uint32 elapsed = Timer1_getTimeStamp() - g_probes[id].start;
+
+	elapsed = (elapsed > g_overhead) ? (elapsed - g_overhead) : 0;
+
+	if(elapsed < g_probes[id].min)
+	{
+		g_probes[id].min = elapsed;
+	}
+	if(elapsed > g_probes[id].max)
+	{
+		g_probes[id].max = elapsed;
+	}
+	g_probes[id].total += elapsed;
+	g_probes[id].count++;
+}
+
+/*[FUNCTION NAME]	: PROF_dump
+ *[DESCRIPTION]		: Send one line per probe "P<id> n=<count> min=<> max=<> avg=<>" in CPU cycles,
+ *                    then the "sleep=<>%" time spent in sleep since POWER_init(), framed so the
+ *                    other ECU can drop the table
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: void
+ */
+void PROF_dump(void)
+{
+	uint8 id;
+
+	UART_sendByte(PROF_FRAME_START);
+	for(id = 0 ; id < PROF_IDS_NUM ; id++)
+	{
+		UART_sendByte('P');
+		PROF_sendNumber(id);
+		UART_sendString((const uint8 *)" n=");
+		PROF_sendNumber(g_probes[id].count);
+		if(g_probes[id].count != 0)
+		{
+			UART_sendString((const uint8 *)" min=");
+			PROF_sendNumber(g_probes[id].min);
+			UART_sendString((const uint8 *)" max=");
+			PROF_sendNumber(g_probes[id].max);
+			UART_sendString((const uint8 *)" avg=");
+			PROF_sendNumber((uint32)(g_probes[id].total / g_probes[id].count));
+		}
+		UART_sendString((const uint8 *)"\r\n");
+	}
+	UART_sendString((const uint8 *)"sleep=");
+	PROF_sendNumber(POWER_getSleepPercentage());
+	UART_sendString((const uint8 *)"%\r\n");
+	UART_sendByte(PROF_FRAME_END);
+}
+
+/*[FUNCTION NAME]	: PROF_skipDump
+ *[DESCRIPTION]		: Receive and drop the profiling table sent by the other ECU
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: void
+ */
+void PROF_skipDump(void)
+{
+	/* The table is read as it comes so none of its bytes is left in the UART for the application */
+	while(UART_recieveByte() != PROF_FRAME_END);
+}
+
+static void PROF_sendNumber(uint32 number)
+{
+	uint8 digits[10];
+	uint8 i = 0;
+
+	do
+	{
+		digits[i++] = '0' + (number % 10);
+		number /= 10;
+	}while(number != 0);
+
+	while(i > 0)
+	{
+		UART_sendByte(digits[--i]);
+	}
+}
+
+#endif /* PROF_ENABLE */
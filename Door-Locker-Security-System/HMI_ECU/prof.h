@@ -0,0 +1,102 @@
+ /******************************************************************************
+ *
+ * Module: PROFILER
+ *
+ * File Name: prof.h
+ *
+ * Description: Header file for the execution time profiler
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+#ifndef PROF_H_
+#define PROF_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * The profiler is only built when PROF_ENABLE is defined on the compiler command
+ * line (-DPROF_ENABLE), the Timer1 time base then runs at F_CPU/1 so every probe
+ * is measured in CPU cycles. In the other builds all the probes compile to nothing.
+ */
+
+/*
+ * Key pressed on the HMI_ECU to send the profiling tables, the HMI_ECU forwards it
+ * to the CONTROL_ECU like any key. The CONTROL_ECU sends its table first then the
+ * HMI_ECU, each ECU drops the table of the other one from the UART link.
+ */
+#define PROF_DUMP_KEY                    '%'
+
+/* A table is sent between these two bytes, its text never holds them */
+#define PROF_FRAME_START                 0x02
+#define PROF_FRAME_END                   0x03
+
+/*******************************************************************************
+ *                                Enums                                        *
+ *******************************************************************************/
+
+typedef enum
+{
+	PROF_ID_TIMER1_CALLBACK,PROF_ID_LCD_DISPLAY_STRING,PROF_ID_LCD_WRITE,PROF_ID_KEYPAD_SCAN,PROF_ID_LCD_FLUSH,PROF_IDS_NUM
+}PROF_IdType;
+
+#ifdef PROF_ENABLE
+
+#define PROF_INIT()                      PROF_init()
+#define PROF_BEGIN(ID)                   PROF_begin(ID)
+#define PROF_END(ID)                     PROF_end(ID)
+#define PROF_DUMP()                      PROF_dump()
+#define PROF_SKIP_DUMP()                 PROF_skipDump()
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Clear the profiling table and measure the overhead of one probe pair.
+ * Timer1 must be initialized first.
+ */
+void PROF_init(void);
+
+/*
+ * Description :
+ * Record the start time of the required probe.
+ */
+void PROF_begin(PROF_IdType id);
+
+/*
+ * Description :
+ * Add the time elapsed since PROF_begin() to the min/max/avg/count of the required probe.
+ */
+void PROF_end(PROF_IdType id);
+
+/*
+ * Description :
+ * Send the profiling table as text lines through the UART, framed by
+ * PROF_FRAME_START and PROF_FRAME_END.
+ */
+void PROF_dump(void);
+
+/*
+ * Description :
+ * Receive and drop the profiling table sent by the other ECU.
+ */
+void PROF_skipDump(void);
+
+#else
+
+#define PROF_INIT()
+#define PROF_BEGIN(ID)
+#define PROF_END(ID)
+#define PROF_DUMP()
+#define PROF_SKIP_DUMP()
+
+#endif /* PROF_ENABLE */
+
+#endif /* PROF_H_ */
@@ -18,6 +18,51 @@
  *******************************************************************************/
 #include "std_types.h"
 
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * In tickless mode Timer1 must be initialized in NORMAL mode, it interrupts only
+ * on overflow (every 65536 counts) and at the nearest software timer deadline
+ * instead of every compare match period. Without it the compare B interrupt
+ * wakes the CPU at the software timer deadlines while it has no subscribers.
+ */
+#define TIMER1_TICKLESS_MODE        FALSE
+
+/* Number of the available software timers, at most 8 */
+#define TIMER1_SW_TIMERS_NUM        2
+
+/*
+ * Prescaler of the Timer1 time base, the profiling builds run it at F_CPU/1 so
+ * the time stamps count CPU cycles (the 32-bit time stamp then wraps every 9 minutes).
+ */
+#ifdef PROF_ENABLE
+#define TIMER1_TIMEBASE_PRESCALER   F_CPU_
+#define TIMER1_TIMEBASE_DIVISION    1UL
+#else
+#define TIMER1_TIMEBASE_PRESCALER   F_CPU_1024
+#define TIMER1_TIMEBASE_DIVISION    1024UL
+#endif
+
+/* Timer1 counts per second with the time base prescaler */
+#define TIMER1_COUNTS_PER_SECOND    (F_CPU / TIMER1_TIMEBASE_DIVISION)
+
+/* Convert a time in seconds to Timer1 counts */
+#define TIMER1_SECONDS(SECONDS)     ((uint32)(SECONDS) * TIMER1_COUNTS_PER_SECOND)
+
+/* Convert a time in milliseconds to Timer1 counts (rounded) */
+#define TIMER1_MILLISECONDS(MS)     ((((uint32)(MS) * TIMER1_COUNTS_PER_SECOND) + 500) / 1000)
+
+/* Maximum number of call back functions sharing the Timer1 interrupts */
+#define TIMER1_MAX_SUBSCRIBERS      4
+
+/* Returned when no subscriber slot is free */
+#define TIMER1_INVALID_SUBSCRIBER   0xFF
+
+/* Period of the compare B channel in Timer1 counts, the fast tick of all subscribers (1ms) */
+#define TIMER1_COMPB_PERIOD         TIMER1_MILLISECONDS(1)
+
 /*******************************************************************************
  *                      Structs, Enums, and Types                              *
  *******************************************************************************/
@@ -30,6 +75,17 @@ typedef enum{
 	NORMAL, CTC = 4
 }Timer1_Mode;
 
+typedef enum{
+	TIMER1_COMPA_CHANNEL, TIMER1_COMPB_CHANNEL, TIMER1_OVF_CHANNEL
+}Timer1_Channel;
+
+typedef struct{
+	void(*volatile callBackPtr)(void);
+	Timer1_Channel channel;
+	uint8 divider;
+	uint8 count;
+}Timer1_SubscriberType;
+
 typedef struct{
 	uint16 initial_value;
 	uint16 compare_value;
@@ -49,8 +105,39 @@ void Timer1_init(const Timer1_ConfigType * Config_Ptr);
  * */
 void Timer1_deInit(void);
 
-/* Description: Function to set the Call Back function address
+/* Description: Function to set the Call Back function address, it is called
+ * every compare A match in CTC mode or every overflow in NORMAL mode.
  * */
 void Timer1_setCallBack(void(*a_ptr)(void));
 
+/* Description: Function to subscribe a call back function to a Timer1 interrupt
+ * channel, it is called once every divider interrupts of the channel.
+ * Timer1 must be initialized first, return the subscriber id or TIMER1_INVALID_SUBSCRIBER
+ * if no slot is free or the channel never interrupts in the configured mode (compare A
+ * out of CTC mode, overflow in CTC mode).
+ * */
+uint8 Timer1_subscribe(Timer1_Channel channel, void(*a_ptr)(void), uint8 divider);
+
+/* Description: Function to remove a subscriber from the Timer1 interrupts
+ * */
+void Timer1_unsubscribe(uint8 subscriber_id);
+
+/* Description: Function to get the number of Timer1 counts elapsed since
+ * Timer1_init(), it is safe to be called with the interrupts enabled or disabled.
+ * */
+uint32 Timer1_getTimeStamp(void);
+
+/* Description: Function to start a software timer that expires after the given
+ * number of Timer1 counts, restarting a running timer moves its deadline.
+ * */
+void Timer1_startSwTimer(uint8 timer_id, uint32 timeout);
+
+/* Description: Function to stop a software timer before it expires.
+ * */
+void Timer1_stopSwTimer(uint8 timer_id);
+
+/* Description: Function to check whether a software timer has expired or is stopped.
+ * */
+boolean Timer1_isSwTimerExpired(uint8 timer_id);
+
 #endif /* TIMER1_H_ */
@@ -0,0 +1,29 @@
+ /******************************************************************************
+ *
+ * Module: HOST
+ *
+ * File Name: interrupt.h
+ *
+ * Description: Interrupt handling for the host build, replacing the
+ *              <avr/interrupt.h> of avr-libc
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+#ifndef HOST_AVR_INTERRUPT_H_
+#define HOST_AVR_INTERRUPT_H_
+
+#include <avr/io.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* The interrupt service routines are called by the emulator through their vector names */
+#define ISR(VECTOR, ...)   void VECTOR(void); void VECTOR(void)
+
+#define sei()              HOST_sei()
+#define cli()              HOST_cli()
+
+#endif /* HOST_AVR_INTERRUPT_H_ */
@@ -0,0 +1,292 @@
+ /******************************************************************************
+ *
+ * Module: HOST
+ *
+ * File Name: io.h
+ *
+ * Description: ATmega32 registers and bits for the host build, replacing the
+ *              <avr/io.h> of avr-libc
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+#ifndef HOST_AVR_IO_H_
+#define HOST_AVR_IO_H_
+
+#include <stdint.h>
+#include "host.h"
+
+/*******************************************************************************
+ *                                Registers                                    *
+ *******************************************************************************/
+
+#define TWBR      HOST_REGISTER8(HOST_ADDRESS_TWBR)
+#define TWSR      HOST_REGISTER8(HOST_ADDRESS_TWSR)
+#define TWAR      HOST_REGISTER8(HOST_ADDRESS_TWAR)
+#define TWDR      HOST_REGISTER8(HOST_ADDRESS_TWDR)
+#define ADC       HOST_REGISTER16(HOST_ADDRESS_ADC)
+#define ADCW      ADC
+#define ADCL      HOST_REGISTER8(HOST_ADDRESS_ADC)
+#define ADCH      HOST_REGISTER8(HOST_ADDRESS_ADC + 1)
+#define ADCSRA    HOST_REGISTER8(HOST_ADDRESS_ADCSRA)
+#define ADMUX     HOST_REGISTER8(HOST_ADDRESS_ADMUX)
+#define UBRRL     HOST_REGISTER8(HOST_ADDRESS_UBRRL)
+#define UCSRB     HOST_REGISTER8(HOST_ADDRESS_UCSRB)
+#define UCSRA     HOST_REGISTER8(HOST_ADDRESS_UCSRA)
+#define UDR       HOST_MARKED_REGISTER(HOST_ADDRESS_UDR)
+#define PIND      HOST_REGISTER8(HOST_ADDRESS_PIND)
+#define DDRD      HOST_REGISTER8(HOST_ADDRESS_DDRD)
+#define PORTD     HOST_REGISTER8(HOST_ADDRESS_PORTD)
+#define PINC      HOST_REGISTER8(HOST_ADDRESS_PINC)
+#define DDRC      HOST_REGISTER8(HOST_ADDRESS_DDRC)
+#define PORTC     HOST_REGISTER8(HOST_ADDRESS_PORTC)
+#define PINB      HOST_REGISTER8(HOST_ADDRESS_PINB)
+#define DDRB      HOST_REGISTER8(HOST_ADDRESS_DDRB)
+#define PORTB     HOST_REGISTER8(HOST_ADDRESS_PORTB)
+#define PINA      HOST_REGISTER8(HOST_ADDRESS_PINA)
+#define DDRA      HOST_REGISTER8(HOST_ADDRESS_DDRA)
+#define PORTA     HOST_REGISTER8(HOST_ADDRESS_PORTA)
+#define UCSRC     HOST_REGISTER8(HOST_ADDRESS_UCSRC)
+#define UBRRH     HOST_REGISTER8(HOST_ADDRESS_UCSRC)
+#define ASSR      HOST_REGISTER8(HOST_ADDRESS_ASSR)
+#define OCR2      HOST_REGISTER8(HOST_ADDRESS_OCR2)
+#define TCNT2     HOST_REGISTER8(HOST_ADDRESS_TCNT2)
+#define TCCR2     HOST_REGISTER8(HOST_ADDRESS_TCCR2)
+#define ICR1      HOST_REGISTER16(HOST_ADDRESS_ICR1)
+#define OCR1B     HOST_REGISTER16(HOST_ADDRESS_OCR1B)
+#define OCR1A     HOST_REGISTER16(HOST_ADDRESS_OCR1A)
+#define TCNT1     HOST_REGISTER16(HOST_ADDRESS_TCNT1)
+#define TCCR1B    HOST_REGISTER8(HOST_ADDRESS_TCCR1B)
+#define TCCR1A    HOST_REGISTER8(HOST_ADDRESS_TCCR1A)
+#define SFIOR     HOST_REGISTER8(HOST_ADDRESS_SFIOR)
+#define TCNT0     HOST_REGISTER8(HOST_ADDRESS_TCNT0)
+#define TCCR0     HOST_REGISTER8(HOST_ADDRESS_TCCR0)
+#define MCUCSR    HOST_REGISTER8(HOST_ADDRESS_MCUCSR)
+#define MCUCR     HOST_REGISTER8(HOST_ADDRESS_MCUCR)
+#define TWCR      HOST_MARKED_REGISTER(HOST_ADDRESS_TWCR)
+#define TIFR      HOST_MARKED_REGISTER(HOST_ADDRESS_TIFR)
+#define TIMSK     HOST_REGISTER8(HOST_ADDRESS_TIMSK)
+#define GIFR      HOST_MARKED_REGISTER(HOST_ADDRESS_GIFR)
+#define GICR      HOST_REGISTER8(HOST_ADDRESS_GICR)
+#define OCR0      HOST_REGISTER8(HOST_ADDRESS_OCR0)
+#define SREG      HOST_REGISTER8(HOST_ADDRESS_SREG)
+
+/*******************************************************************************
+ *                                Register Bits                                *
+ *******************************************************************************/
+
+/* TWCR */
+#define TWINT     7
+#define TWEA      6
+#define TWSTA     5
+#define TWSTO     4
+#define TWWC      3
+#define TWEN      2
+#define TWIE      0
+
+/* TWSR */
+#define TWPS1     1
+#define TWPS0     0
+
+/* ADMUX */
+#define REFS1     7
+#define REFS0     6
+#define ADLAR     5
+
+/* ADCSRA */
+#define ADEN      7
+#define ADSC      6
+#define ADATE     5
+#define ADIF      4
+#define ADIE      3
+#define ADPS2     2
+#define ADPS1     1
+#define ADPS0     0
+
+/* UCSRA */
+#define RXC       7
+#define TXC       6
+#define UDRE      5
+#define FE        4
+#define DOR       3
+#define PE        2
+#define U2X       1
+#define MPCM      0
+
+/* UCSRB */
+#define RXCIE     7
+#define TXCIE     6
+#define UDRIE     5
+#define RXEN      4
+#define TXEN      3
+#define UCSZ2     2
+#define RXB8      1
+#define TXB8      0
+
+/* UCSRC */
+#define URSEL     7
+#define UMSEL     6
+#define UPM1      5
+#define UPM0      4
+#define USBS      3
+#define UCSZ1     2
+#define UCSZ0     1
+#define UCPOL     0
+
+/* TCCR2 */
+#define FOC2      7
+#define WGM20     6
+#define COM21     5
+#define COM20     4
+#define WGM21     3
+#define CS22      2
+#define CS21      1
+#define CS20      0
+
+/* ASSR */
+#define AS2       3
+
+/* TCCR1A */
+#define COM1A1    7
+#define COM1A0    6
+#define COM1B1    5
+#define COM1B0    4
+#define FOC1A     3
+#define FOC1B     2
+#define WGM11     1
+#define WGM10     0
+
+/* TCCR1B */
+#define ICNC1     7
+#define ICES1     6
+#define WGM13     4
+#define WGM12     3
+#define CS12      2
+#define CS11      1
+#define CS10      0
+
+/* SFIOR */
+#define ADTS2     7
+#define ADTS1     6
+#define ADTS0     5
+#define PUD       2
+#define PSR2      1
+#define PSR10     0
+
+/* TCCR0 */
+#define FOC0      7
+#define WGM00     6
+#define COM01     5
+#define COM00     4
+#define WGM01     3
+#define CS02      2
+#define CS01      1
+#define CS00      0
+
+/* MCUCSR */
+#define JTD       7
+#define ISC2      6
+
+/* MCUCR */
+#define SE        7
+#define SM2       6
+#define SM1       5
+#define SM0       4
+#define ISC11     3
+#define ISC10     2
+#define ISC01     1
+#define ISC00     0
+
+/* TIMSK */
+#define OCIE2     7
+#define TOIE2     6
+#define TICIE1    5
+#define OCIE1A    4
+#define OCIE1B    3
+#define TOIE1     2
+#define OCIE0     1
+#define TOIE0     0
+
+/* TIFR */
+#define OCF2      7
+#define TOV2      6
+#define ICF1      5
+#define OCF1A     4
+#define OCF1B     3
+#define TOV1      2
+#define OCF0      1
+#define TOV0      0
+
+/* GICR */
+#define INT1      7
+#define INT0      6
+#define INT2      5
+
+/* GIFR */
+#define INTF1     7
+#define INTF0     6
+#define INTF2     5
+
+/* Pins */
+#define PA7 7
+#define PA6 6
+#define PA5 5
+#define PA4 4
+#define PA3 3
+#define PA2 2
+#define PA1 1
+#define PA0 0
+#define PB7 7
+#define PB6 6
+#define PB5 5
+#define PB4 4
+#define PB3 3
+#define PB2 2
+#define PB1 1
+#define PB0 0
+#define PC7 7
+#define PC6 6
+#define PC5 5
+#define PC4 4
+#define PC3 3
+#define PC2 2
+#define PC1 1
+#define PC0 0
+#define PD7 7
+#define PD6 6
+#define PD5 5
+#define PD4 4
+#define PD3 3
+#define PD2 2
+#define PD1 1
+#define PD0 0
+
+/*******************************************************************************
+ *                                Vectors                                      *
+ *******************************************************************************/
+
+#define INT0_vect          __vector_1
+#define INT1_vect          __vector_2
+#define INT2_vect          __vector_3
+#define TIMER2_COMP_vect   __vector_4
+#define TIMER2_OVF_vect    __vector_5
+#define TIMER1_CAPT_vect   __vector_6
+#define TIMER1_COMPA_vect  __vector_7
+#define TIMER1_COMPB_vect  __vector_8
+#define TIMER1_OVF_vect    __vector_9
+#define TIMER0_COMP_vect   __vector_10
+#define TIMER0_OVF_vect    __vector_11
+#define SPI_STC_vect       __vector_12
+#define USART_RXC_vect     __vector_13
+#define USART_UDRE_vect    __vector_14
+#define USART_TXC_vect     __vector_15
+#define ADC_vect           __vector_16
+#define EE_RDY_vect        __vector_17
+#define ANA_COMP_vect      __vector_18
+#define TWI_vect           __vector_19
+#define SPM_RDY_vect       __vector_20
+
+#define _BV(BIT)           (1 << (BIT))
+
+#endif /* HOST_AVR_IO_H_ */
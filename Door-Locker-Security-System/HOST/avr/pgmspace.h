@@ -0,0 +1,31 @@
+ /******************************************************************************
+ *
+ * Module: HOST
+ *
+ * File Name: pgmspace.h
+ *
+ * Description: Program memory access for the host build, replacing the
+ *              <avr/pgmspace.h> of avr-libc
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+#ifndef HOST_AVR_PGMSPACE_H_
+#define HOST_AVR_PGMSPACE_H_
+
+#include <stdint.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* The host has one address space, the flash data is kept in ordinary constants */
+#define PROGMEM
+#define PSTR(STRING)            (STRING)
+#define pgm_read_byte(ADDRESS)  (*(const uint8_t *)(ADDRESS))
+#define pgm_read_word(ADDRESS)  (*(const uint16_t *)(ADDRESS))
+#define pgm_read_dword(ADDRESS) (*(const uint32_t *)(ADDRESS))
+#define pgm_read_ptr(ADDRESS)   (*(void * const *)(ADDRESS))
+
+#endif /* HOST_AVR_PGMSPACE_H_ */
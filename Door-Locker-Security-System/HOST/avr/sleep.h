@@ -0,0 +1,38 @@
+ /******************************************************************************
+ *
+ * Module: HOST
+ *
+ * File Name: sleep.h
+ *
+ * Description: Sleep modes for the host build, replacing the <avr/sleep.h> of
+ *              avr-libc
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+#ifndef HOST_AVR_SLEEP_H_
+#define HOST_AVR_SLEEP_H_
+
+#include <avr/io.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* All the sleep modes are emulated as the idle mode, every peripheral keeps running */
+#define SLEEP_MODE_IDLE         0
+#define SLEEP_MODE_ADC          (1 << SM0)
+#define SLEEP_MODE_PWR_DOWN     (1 << SM1)
+#define SLEEP_MODE_PWR_SAVE     ((1 << SM0) | (1 << SM1))
+#define SLEEP_MODE_STANDBY      ((1 << SM1) | (1 << SM2))
+#define SLEEP_MODE_EXT_STANDBY  ((1 << SM0) | (1 << SM1) | (1 << SM2))
+
+#define set_sleep_mode(MODE) \
+	(MCUCR = (MCUCR & ~((1 << SM0) | (1 << SM1) | (1 << SM2))) | (MODE))
+#define sleep_enable()          (MCUCR |= (1 << SE))
+#define sleep_disable()         (MCUCR &= ~(1 << SE))
+#define sleep_cpu()             HOST_sleep()
+#define sleep_mode()            do{ sleep_enable(); sleep_cpu(); sleep_disable(); }while(0)
+
+#endif /* HOST_AVR_SLEEP_H_ */
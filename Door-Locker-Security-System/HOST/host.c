@@ -0,0 +1,775 @@
+ /******************************************************************************
+ *
+ * Module: HOST
+ *
+ * File Name: host.c
+ *
+ * Description: Source file for the CPU of the host (Linux) ATmega32, the register
+ *              accesses, the interrupts and the virtual time
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                      Used Header Files                                      *
+ *******************************************************************************/
+
+#define _GNU_SOURCE
+#include "host_models.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Cycles taken by a register access, an interrupt entry and a return from interrupt */
+#define HOST_ACCESS_CYCLES           1
+#define HOST_INTERRUPT_CYCLES        4
+#define HOST_RETI_CYCLES             4
+
+/* Virtual time limit when HOST_TIME_LIMIT_MS is not set */
+#define HOST_DEFAULT_TIME_LIMIT_MS   10000
+
+#define HOST_MARKED_NUM              4
+#define HOST_NOT_MARKED              0xFF
+
+#define HOST_SREG_I                  7
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+uint8 HOST_io[HOST_IO_SIZE] __attribute__((aligned(2)));
+
+/* Register values known by the peripherals, a difference is a firmware write */
+static uint8 g_shadow[HOST_IO_SIZE];
+
+/* Marked copies of UDR, TWCR, GIFR and TIFR given to the firmware */
+static volatile uint16 g_marked[HOST_MARKED_NUM];
+static const uint8 g_markedAddresses[HOST_MARKED_NUM] =
+	{HOST_ADDRESS_UDR, HOST_ADDRESS_TWCR, HOST_ADDRESS_GIFR, HOST_ADDRESS_TIFR};
+
+/* Marked register accessed last, its read is seen on the next access */
+static uint8 g_lastMarked = HOST_NOT_MARKED;
+
+static const HOST_ModelType * const g_models[] =
+{
+	&HOST_cpuModel, &HOST_gpioModel, &HOST_timerModel, &HOST_uartModel, &HOST_adcModel, &HOST_twiModel
+};
+#define HOST_MODELS_NUM              (sizeof(g_models) / sizeof(g_models[0]))
+
+/* Peripheral owning each register and the interrupt source of each vector */
+static const HOST_ModelType *g_owners[HOST_IO_SIZE];
+static const HOST_InterruptType *g_sources[HOST_VECTORS_NUM];
+
+/* Interrupt service routines defined by the firmware, the missing ones stay NULL */
+#define HOST_DECLARE_VECTOR(NUM)     extern void __vector_##NUM(void) __attribute__((weak))
+HOST_DECLARE_VECTOR(1);  HOST_DECLARE_VECTOR(2);  HOST_DECLARE_VECTOR(3);  HOST_DECLARE_VECTOR(4);
+HOST_DECLARE_VECTOR(5);  HOST_DECLARE_VECTOR(6);  HOST_DECLARE_VECTOR(7);  HOST_DECLARE_VECTOR(8);
+HOST_DECLARE_VECTOR(9);  HOST_DECLARE_VECTOR(10); HOST_DECLARE_VECTOR(11); HOST_DECLARE_VECTOR(12);
+HOST_DECLARE_VECTOR(13); HOST_DECLARE_VECTOR(14); HOST_DECLARE_VECTOR(15); HOST_DECLARE_VECTOR(16);
+HOST_DECLARE_VECTOR(17); HOST_DECLARE_VECTOR(18); HOST_DECLARE_VECTOR(19); HOST_DECLARE_VECTOR(20);
+
+static void (* const g_vectors[HOST_VECTORS_NUM])(void) =
+{
+	NULL_PTR, __vector_1, __vector_2, __vector_3, __vector_4, __vector_5, __vector_6, __vector_7,
+	__vector_8, __vector_9, __vector_10, __vector_11, __vector_12, __vector_13, __vector_14,
+	__vector_15, __vector_16, __vector_17, __vector_18, __vector_19, __vector_20
+};
+
+static const char * const g_vectorNames[HOST_VECTORS_NUM] =
+{
+	"RESET", "INT0", "INT1", "INT2", "TIMER2_COMP", "TIMER2_OVF", "TIMER1_CAPT", "TIMER1_COMPA",
+	"TIMER1_COMPB", "TIMER1_OVF", "TIMER0_COMP", "TIMER0_OVF", "SPI_STC", "USART_RXC", "USART_UDRE",
+	"USART_TXC", "ADC", "EE_RDY", "ANA_COMP", "TWI", "SPM_RDY"
+};
+
+/* Connected devices */
+static const HOST_DeviceType *g_devices[HOST_DEVICES_MAX];
+static uint8 g_devicesNum = 0;
+
+/* Virtual time in CPU cycles, its limit and the call back called at the limit */
+static uint64 g_time = 0;
+static uint64 g_timeLimit = HOST_MS_TO_CYCLES(HOST_DEFAULT_TIME_LIMIT_MS);
+static void (*g_limitCallBack)(void) = NULL_PTR;
+
+/* The CPU sleeps or busy waits until the end time, only the interrupts run meanwhile */
+static boolean g_waiting = FALSE;
+static uint64 g_waitEnd = 0;
+
+/* Run statistics */
+static uint64 g_accesses = 0;
+static uint64 g_sleepCycles = 0;
+static uint32 g_interrupts[HOST_VECTORS_NUM];
+
+/* Name printed before the messages */
+static const char *g_name = "host";
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Reset the registers and the peripherals, read the run settings from the environment.
+ */
+static void HOST_init(void) __attribute__((constructor));
+
+/*
+ * Give the register writes and the marked register read made by the firmware
+ * since the previous access to the peripherals owning the registers.
+ */
+static void HOST_commit(void);
+
+/*
+ * Return the nearest event of the peripherals and the devices.
+ */
+static uint64 HOST_nextEvent(void);
+
+/*
+ * Move the virtual time to the given time and let the peripherals and the devices
+ * make their changes due up to it, the emulation stops at the time limit.
+ */
+static void HOST_step(uint64 time);
+
+/*
+ * Advance the virtual time up to the target, serving the interrupts at every event.
+ */
+static void HOST_run(uint64 target);
+
+/*
+ * Return the highest priority interrupt whose flag and enable bit are set.
+ */
+static const HOST_InterruptType *HOST_pendingInterrupt(void);
+
+/*
+ * Call the service routines of the pending interrupts while the global interrupt flag is set.
+ */
+static void HOST_serveInterrupts(void);
+
+/*
+ * Return the index of a marked register or HOST_NOT_MARKED.
+ */
+static uint8 HOST_markedIndex(uint8 address);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*[FUNCTION NAME]	: HOST_access
+ *[DESCRIPTION]		: Give the pending firmware writes to the peripherals, advance the
+ *                    virtual time by one access and serve the pending interrupts,
+ *                    then return the location of the accessed register
+ *[ARGUMENTS]		: register data memory address of type uint8
+ *[RETURNS]			: pointer to the register value
+ */
+volatile void *HOST_access(uint8 address)
+{
+	uint8 index;
+
+	HOST_commit();
+	HOST_run(g_time + HOST_ACCESS_CYCLES);
+	g_accesses++;
+
+	index = HOST_markedIndex(address);
+	if(index == HOST_NOT_MARKED)
+	{
+		return &HOST_io[address];
+	}
+	g_lastMarked = index;
+	g_marked[index] = HOST_MARKER | HOST_io[address];
+	return &g_marked[index];
+}
+
+/*[FUNCTION NAME]	: HOST_cli
+ *[DESCRIPTION]		: Disable the interrupts globally
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: void
+ */
+void HOST_cli(void)
+{
+	HOST_commit();
+	HOST_run(g_time + HOST_ACCESS_CYCLES);
+	HOST_setRegister(HOST_ADDRESS_SREG, HOST_io[HOST_ADDRESS_SREG] & ~(1 << HOST_SREG_I));
+}
+
+/*[FUNCTION NAME]	: HOST_sei
+ *[DESCRIPTION]		: Enable the interrupts globally, a pending interrupt is served on the next access
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: void
+ */
+void HOST_sei(void)
+{
+	HOST_commit();
+	HOST_run(g_time + HOST_ACCESS_CYCLES);
+	HOST_setRegister(HOST_ADDRESS_SREG, HOST_io[HOST_ADDRESS_SREG] | (1 << HOST_SREG_I));
+}
+
+/*[FUNCTION NAME]	: HOST_sleep
+ *[DESCRIPTION]		: Jump from event to event until an enabled interrupt wakes the CPU up
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: void
+ */
+void HOST_sleep(void)
+{
+	uint64 sleep_start;
+	uint64 next;
+
+	HOST_commit();
+	HOST_run(g_time + HOST_ACCESS_CYCLES);
+
+	/* The sleep instruction does nothing until the sleep is enabled */
+	if(BIT_IS_CLEAR(HOST_io[HOST_ADDRESS_MCUCR],SE))
+	{
+		return;
+	}
+	if(BIT_IS_CLEAR(HOST_io[HOST_ADDRESS_SREG],HOST_SREG_I))
+	{
+		HOST_fatal("sleep with the interrupts disabled, the CPU never wakes up");
+	}
+
+	sleep_start = g_time;
+	g_waiting = TRUE;
+	g_waitEnd = HOST_NEVER;
+	while(HOST_pendingInterrupt() == NULL_PTR)
+	{
+		next = HOST_nextEvent();
+		if(next == HOST_NEVER)
+		{
+			/* In a co-simulation the other ECU can still wake the CPU up */
+			if(g_limitCallBack == NULL_PTR)
+			{
+				HOST_log("sleep without any wake up source");
+			}
+			next = g_timeLimit;
+		}
+		HOST_step(next);
+	}
+	g_waiting = FALSE;
+	g_sleepCycles += g_time - sleep_start;
+
+	HOST_serveInterrupts();
+}
+
+/*[FUNCTION NAME]	: HOST_delay
+ *[DESCRIPTION]		: Busy wait of the given cycles, the interrupts are served meanwhile
+ *[ARGUMENTS]		: number of CPU cycles of type uint64
+ *[RETURNS]			: void
+ */
+void HOST_delay(uint64 cycles)
+{
+	HOST_commit();
+	g_waiting = TRUE;
+	g_waitEnd = g_time + cycles;
+	HOST_run(g_waitEnd);
+	g_waiting = FALSE;
+}
+
+/*[FUNCTION NAME]	: HOST_getTime
+ *[DESCRIPTION]		: Return the virtual time
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: CPU cycles since the reset of type uint64
+ */
+uint64 HOST_getTime(void)
+{
+	return g_time;
+}
+
+/*[FUNCTION NAME]	: HOST_getWakeTime
+ *[DESCRIPTION]		: Return the earliest time the firmware can run again, the end of the
+ *                    current sleep or busy wait or the next event waking it up before
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: virtual time of type uint64
+ */
+uint64 HOST_getWakeTime(void)
+{
+	uint64 wake_time;
+
+	if(!g_waiting ||
+			(BIT_IS_SET(HOST_io[HOST_ADDRESS_SREG],HOST_SREG_I) && (HOST_pendingInterrupt() != NULL_PTR)))
+	{
+		return g_time;
+	}
+	wake_time = HOST_nextEvent();
+	if(g_waitEnd < wake_time)
+	{
+		wake_time = g_waitEnd;
+	}
+	return (wake_time > g_time) ? wake_time : g_time;
+}
+
+/*[FUNCTION NAME]	: HOST_setTimeLimit
+ *[DESCRIPTION]		: Set the virtual time limit and the call back called when it is reached
+ *[ARGUMENTS]		: virtual time of type uint64 and pointer to the call back function,
+ *                    NULL_PTR to exit at the limit
+ *[RETURNS]			: void
+ */
+void HOST_setTimeLimit(uint64 time, void (*a_ptr)(void))
+{
+	g_timeLimit = time;
+	g_limitCallBack = a_ptr;
+}
+
+/*[FUNCTION NAME]	: HOST_setName
+ *[DESCRIPTION]		: Set the name printed before the messages
+ *[ARGUMENTS]		: pointer to the name string
+ *[RETURNS]			: void
+ */
+void HOST_setName(const char *name)
+{
+	g_name = name;
+}
+
+/*[FUNCTION NAME]	: HOST_getRegister
+ *[DESCRIPTION]		: Read a register without a firmware access
+ *[ARGUMENTS]		: register data memory address of type uint8
+ *[RETURNS]			: register value of type uint8
+ */
+uint8 HOST_getRegister(uint8 address)
+{
+	return HOST_io[address];
+}
+
+/*[FUNCTION NAME]	: HOST_setRegister
+ *[DESCRIPTION]		: Write a register without showing the write to its peripheral,
+ *                    used by the peripherals to update their registers
+ *[ARGUMENTS]		: register data memory address and value of type uint8
+ *[RETURNS]			: void
+ */
+void HOST_setRegister(uint8 address, uint8 value)
+{
+	uint8 index = HOST_markedIndex(address);
+
+	HOST_io[address] = value;
+	g_shadow[address] = value;
+	if(index != HOST_NOT_MARKED)
+	{
+		g_marked[index] = HOST_MARKER | value;
+	}
+}
+
+/*[FUNCTION NAME]	: HOST_addDevice
+ *[DESCRIPTION]		: Connect a device to the MCU pins
+ *[ARGUMENTS]		: pointer to the device call backs of type HOST_DeviceType
+ *[RETURNS]			: void
+ */
+void HOST_addDevice(const HOST_DeviceType *device)
+{
+	if(g_devicesNum >= HOST_DEVICES_MAX)
+	{
+		HOST_fatal("more than %d devices", HOST_DEVICES_MAX);
+	}
+	g_devices[g_devicesNum++] = device;
+}
+
+/*[FUNCTION NAME]	: HOST_devicesAdvance
+ *[DESCRIPTION]		: Let the devices make their changes due up to the virtual time now
+ *[ARGUMENTS]		: virtual time of type uint64
+ *[RETURNS]			: void
+ */
+void HOST_devicesAdvance(uint64 now)
+{
+	uint8 id;
+
+	for(id = 0 ; id < g_devicesNum ; id++)
+	{
+		if(g_devices[id]->advance != NULL_PTR)
+		{
+			g_devices[id]->advance(now);
+		}
+	}
+}
+
+/*[FUNCTION NAME]	: HOST_devicesNextEvent
+ *[DESCRIPTION]		: Return the nearest change the devices make by themselves
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: virtual time of type uint64
+ */
+uint64 HOST_devicesNextEvent(void)
+{
+	uint64 nearest = HOST_NEVER;
+	uint64 next;
+	uint8 id;
+
+	for(id = 0 ; id < g_devicesNum ; id++)
+	{
+		if(g_devices[id]->nextEvent != NULL_PTR)
+		{
+			next = g_devices[id]->nextEvent();
+			if(next < nearest)
+			{
+				nearest = next;
+			}
+		}
+	}
+	return nearest;
+}
+
+/*[FUNCTION NAME]	: HOST_devicesPortChanged
+ *[DESCRIPTION]		: Tell the devices that a port output level or direction changed
+ *[ARGUMENTS]		: port ID of type uint8
+ *[RETURNS]			: void
+ */
+void HOST_devicesPortChanged(uint8 port_id)
+{
+	uint8 id;
+
+	for(id = 0 ; id < g_devicesNum ; id++)
+	{
+		if(g_devices[id]->portChanged != NULL_PTR)
+		{
+			g_devices[id]->portChanged(port_id);
+		}
+	}
+}
+
+/*[FUNCTION NAME]	: HOST_log
+ *[DESCRIPTION]		: Print a message prefixed with the virtual time on stderr
+ *[ARGUMENTS]		: printf format and arguments
+ *[RETURNS]			: void
+ */
+void HOST_log(const char *format, ...)
+{
+	va_list arguments;
+
+	fprintf(stderr, "[%s %10.3f ms] ", g_name, (double)g_time / HOST_CYCLES_PER_MS);
+	va_start(arguments, format);
+	vfprintf(stderr, format, arguments);
+	va_end(arguments);
+	fputc('\n', stderr);
+}
+
+/*[FUNCTION NAME]	: HOST_fatal
+ *[DESCRIPTION]		: Print the message and stop the emulation with a failure status
+ *[ARGUMENTS]		: printf format and arguments
+ *[RETURNS]			: void
+ */
+void HOST_fatal(const char *format, ...)
+{
+	va_list arguments;
+
+	fprintf(stderr, "[%s %10.3f ms] error: ", g_name, (double)g_time / HOST_CYCLES_PER_MS);
+	va_start(arguments, format);
+	vfprintf(stderr, format, arguments);
+	va_end(arguments);
+	fputc('\n', stderr);
+	HOST_exit(EXIT_FAILURE);
+	exit(EXIT_FAILURE);
+}
+
+/*[FUNCTION NAME]	: HOST_report
+ *[DESCRIPTION]		: Print the summary of the run on stderr
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: void
+ */
+void HOST_report(void)
+{
+	uint8 id;
+
+	fprintf(stderr, "[%s] stopped at %.3f ms, %llu register accesses, %.1f%% of the time in sleep\n",
+			g_name, (double)g_time / HOST_CYCLES_PER_MS, (unsigned long long)g_accesses,
+			(g_time == 0) ? 0.0 : (100.0 * (double)g_sleepCycles / (double)g_time));
+	for(id = 1 ; id < HOST_VECTORS_NUM ; id++)
+	{
+		if(g_interrupts[id] != 0)
+		{
+			fprintf(stderr, "[%s]   %-12s %lu interrupts\n", g_name, g_vectorNames[id], (unsigned long)g_interrupts[id]);
+		}
+	}
+	for(id = 0 ; id < HOST_MODELS_NUM ; id++)
+	{
+		if(g_models[id]->report != NULL_PTR)
+		{
+			g_models[id]->report();
+		}
+	}
+}
+
+/*[FUNCTION NAME]	: HOST_exit
+ *[DESCRIPTION]		: Print the summary of the run on stderr and exit
+ *[ARGUMENTS]		: exit status of type int
+ *[RETURNS]			: void
+ */
+void HOST_exit(int status)
+{
+	fflush(stdout);
+	HOST_report();
+	exit(status);
+}
+
+/*[FUNCTION NAME]	: itoa
+ *[DESCRIPTION]		: Convert the integer to a string in the given base like the avr-libc itoa()
+ *[ARGUMENTS]		: integer value, output string and base of type int
+ *[RETURNS]			: the output string
+ */
+char *itoa(int value, char *string, int radix)
+{
+	char digits[8 * sizeof(int) + 1];
+	unsigned int magnitude = (unsigned int)value;
+	uint8 length = 0;
+	uint8 index = 0;
+
+	/* Only the decimal numbers are signed */
+	if((radix == 10) && (value < 0))
+	{
+		string[index++] = '-';
+		magnitude = 0U - magnitude;
+	}
+	do
+	{
+		digits[length++] = "0123456789abcdefghijklmnopqrstuvwxyz"[magnitude % (unsigned int)radix];
+		magnitude /= (unsigned int)radix;
+	}while(magnitude != 0);
+
+	while(length > 0)
+	{
+		string[index++] = digits[--length];
+	}
+	string[index] = '\0';
+	return string;
+}
+
+static void HOST_init(void)
+{
+	const char *setting;
+	uint8 id;
+	uint8 index;
+
+	g_name = program_invocation_short_name;
+
+	setting = getenv("HOST_TIME_LIMIT_MS");
+	if(setting != NULL_PTR)
+	{
+		g_timeLimit = HOST_MS_TO_CYCLES(strtoull(setting, NULL_PTR, 10));
+	}
+
+	for(id = 0 ; id < HOST_MODELS_NUM ; id++)
+	{
+		if(g_models[id]->registers != NULL_PTR)
+		{
+			for(index = 0 ; g_models[id]->registers[index] != HOST_NO_ADDRESS ; index++)
+			{
+				g_owners[g_models[id]->registers[index]] = g_models[id];
+			}
+		}
+		for(index = 0 ; index < g_models[id]->interrupts_num ; index++)
+		{
+			g_sources[g_models[id]->interrupts[index].vector] = &g_models[id]->interrupts[index];
+		}
+		if(g_models[id]->reset != NULL_PTR)
+		{
+			g_models[id]->reset();
+		}
+	}
+
+	HOST_uartUseStdio();
+	setting = getenv("HOST_EEPROM_FILE");
+	if(setting != NULL_PTR)
+	{
+		HOST_eepromUseFile(setting);
+	}
+}
+
+static void HOST_commit(void)
+{
+	const HOST_ModelType *owner;
+	uint8 old_value;
+	uint8 address;
+	uint8 index;
+
+	/* A write to a marked register clears the marker */
+	for(index = 0 ; index < HOST_MARKED_NUM ; index++)
+	{
+		if(!(g_marked[index] & HOST_MARKER))
+		{
+			address = g_markedAddresses[index];
+			old_value = HOST_io[address];
+			HOST_setRegister(address, (uint8)g_marked[index]);
+			if(g_lastMarked == index)
+			{
+				g_lastMarked = HOST_NOT_MARKED;
+			}
+			owner = g_owners[address];
+			if((owner != NULL_PTR) && (owner->write != NULL_PTR))
+			{
+				owner->write(address, old_value);
+			}
+		}
+	}
+
+	/* The last accessed marked register kept its marker, it was read */
+	if(g_lastMarked != HOST_NOT_MARKED)
+	{
+		address = g_markedAddresses[g_lastMarked];
+		g_lastMarked = HOST_NOT_MARKED;
+		owner = g_owners[address];
+		if((owner != NULL_PTR) && (owner->read != NULL_PTR))
+		{
+			owner->read(address);
+		}
+	}
+
+	if(memcmp(HOST_io, g_shadow, sizeof(HOST_io)) == 0)
+	{
+		return;
+	}
+	for(address = 0 ; address < HOST_IO_SIZE ; address++)
+	{
+		if(HOST_io[address] != g_shadow[address])
+		{
+			old_value = g_shadow[address];
+			g_shadow[address] = HOST_io[address];
+			owner = g_owners[address];
+			if((owner != NULL_PTR) && (owner->write != NULL_PTR))
+			{
+				owner->write(address, old_value);
+			}
+		}
+	}
+}
+
+static uint64 HOST_nextEvent(void)
+{
+	uint64 nearest = HOST_devicesNextEvent();
+	uint64 next;
+	uint8 id;
+
+	for(id = 0 ; id < HOST_MODELS_NUM ; id++)
+	{
+		if(g_models[id]->nextEvent != NULL_PTR)
+		{
+			next = g_models[id]->nextEvent();
+			if(next < nearest)
+			{
+				nearest = next;
+			}
+		}
+	}
+	return nearest;
+}
+
+static void HOST_step(uint64 time)
+{
+	uint8 id;
+
+	if(time > g_timeLimit)
+	{
+		time = g_timeLimit;
+	}
+	if(time > g_time)
+	{
+		g_time = time;
+	}
+
+	for(id = 0 ; id < HOST_MODELS_NUM ; id++)
+	{
+		if(g_models[id]->advance != NULL_PTR)
+		{
+			g_models[id]->advance(g_time);
+		}
+	}
+	HOST_devicesAdvance(g_time);
+
+	while(g_time >= g_timeLimit)
+	{
+		if(g_limitCallBack == NULL_PTR)
+		{
+			HOST_exit(EXIT_SUCCESS);
+		}
+		g_limitCallBack();
+	}
+}
+
+static void HOST_run(uint64 target)
+{
+	uint64 next;
+
+	do
+	{
+		next = HOST_nextEvent();
+		if(next > target)
+		{
+			next = target;
+		}
+		else if(next <= g_time)
+		{
+			/* An event due now is already made, never stay at the same time */
+			next = g_time + 1;
+		}
+		HOST_step(next);
+		HOST_serveInterrupts();
+	}while(g_time < target);
+}
+
+static const HOST_InterruptType *HOST_pendingInterrupt(void)
+{
+	uint8 vector;
+
+	/* The lower vector has the higher priority */
+	for(vector = 1 ; vector < HOST_VECTORS_NUM ; vector++)
+	{
+		if((g_sources[vector] != NULL_PTR) && g_sources[vector]->isPending())
+		{
+			return g_sources[vector];
+		}
+	}
+	return NULL_PTR;
+}
+
+static void HOST_serveInterrupts(void)
+{
+	const HOST_InterruptType *source;
+	boolean waiting = g_waiting;
+
+	while(BIT_IS_SET(HOST_io[HOST_ADDRESS_SREG],HOST_SREG_I) && ((source = HOST_pendingInterrupt()) != NULL_PTR))
+	{
+		if(g_vectors[source->vector] == NULL_PTR)
+		{
+			HOST_fatal("%s interrupt is enabled without an interrupt service routine", g_vectorNames[source->vector]);
+		}
+		if(source->acknowledge != NULL_PTR)
+		{
+			source->acknowledge();
+		}
+		g_interrupts[source->vector]++;
+
+		/* The global interrupt flag is cleared in the routine and set again by reti */
+		HOST_setRegister(HOST_ADDRESS_SREG, HOST_io[HOST_ADDRESS_SREG] & ~(1 << HOST_SREG_I));
+		g_waiting = FALSE;
+		HOST_step(g_time + HOST_INTERRUPT_CYCLES);
+		g_vectors[source->vector]();
+		HOST_commit();
+		HOST_setRegister(HOST_ADDRESS_SREG, HOST_io[HOST_ADDRESS_SREG] | (1 << HOST_SREG_I));
+		HOST_step(g_time + HOST_RETI_CYCLES);
+		g_waiting = waiting;
+	}
+}
+
+static uint8 HOST_markedIndex(uint8 address)
+{
+	uint8 index;
+
+	for(index = 0 ; index < HOST_MARKED_NUM ; index++)
+	{
+		if(g_markedAddresses[index] == address)
+		{
+			return index;
+		}
+	}
+	return HOST_NOT_MARKED;
+}
+
+/*******************************************************************************
+ *                      CPU Registers                                          *
+ *******************************************************************************/
+
+static const uint8 g_cpuRegisters[] = {HOST_ADDRESS_SREG, HOST_NO_ADDRESS};
+
+const HOST_ModelType HOST_cpuModel =
+{
+	"CPU", g_cpuRegisters, NULL_PTR, 0, NULL_PTR, NULL_PTR, NULL_PTR, NULL_PTR, NULL_PTR, NULL_PTR
+};
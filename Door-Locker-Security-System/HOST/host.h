@@ -0,0 +1,343 @@
+ /******************************************************************************
+ *
+ * Module: HOST
+ *
+ * File Name: host.h
+ *
+ * Description: Header file for the host (Linux) implementation of the ATmega32
+ *              used to build the ECUs as native executables
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+#ifndef HOST_H_
+#define HOST_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * The I/O registers are kept in an array indexed by their ATmega32 data memory
+ * address. The firmware reaches every register through HOST_access(), which
+ * gives the emulated peripherals the register writes made since the previous
+ * access, advances the virtual time and serves the pending interrupts.
+ */
+#define HOST_IO_SIZE                 0x60
+
+/* Data memory addresses of the emulated registers */
+#define HOST_ADDRESS_TWBR            0x20
+#define HOST_ADDRESS_TWSR            0x21
+#define HOST_ADDRESS_TWAR            0x22
+#define HOST_ADDRESS_TWDR            0x23
+#define HOST_ADDRESS_ADC             0x24 /* ADCL, ADCH at 0x25 */
+#define HOST_ADDRESS_ADCSRA          0x26
+#define HOST_ADDRESS_ADMUX           0x27
+#define HOST_ADDRESS_UBRRL           0x29
+#define HOST_ADDRESS_UCSRB           0x2A
+#define HOST_ADDRESS_UCSRA           0x2B
+#define HOST_ADDRESS_UDR             0x2C
+#define HOST_ADDRESS_PIND            0x30
+#define HOST_ADDRESS_DDRD            0x31
+#define HOST_ADDRESS_PORTD           0x32
+#define HOST_ADDRESS_PINC            0x33
+#define HOST_ADDRESS_DDRC            0x34
+#define HOST_ADDRESS_PORTC           0x35
+#define HOST_ADDRESS_PINB            0x36
+#define HOST_ADDRESS_DDRB            0x37
+#define HOST_ADDRESS_PORTB           0x38
+#define HOST_ADDRESS_PINA            0x39
+#define HOST_ADDRESS_DDRA            0x3A
+#define HOST_ADDRESS_PORTA           0x3B
+#define HOST_ADDRESS_UCSRC           0x40 /* Shared with UBRRH, selected by URSEL */
+#define HOST_ADDRESS_ASSR            0x42
+#define HOST_ADDRESS_OCR2            0x43
+#define HOST_ADDRESS_TCNT2           0x44
+#define HOST_ADDRESS_TCCR2           0x45
+#define HOST_ADDRESS_ICR1            0x46
+#define HOST_ADDRESS_OCR1B           0x48
+#define HOST_ADDRESS_OCR1A           0x4A
+#define HOST_ADDRESS_TCNT1           0x4C
+#define HOST_ADDRESS_TCCR1B          0x4E
+#define HOST_ADDRESS_TCCR1A          0x4F
+#define HOST_ADDRESS_SFIOR           0x50
+#define HOST_ADDRESS_TCNT0           0x52
+#define HOST_ADDRESS_TCCR0           0x53
+#define HOST_ADDRESS_MCUCSR          0x54
+#define HOST_ADDRESS_MCUCR           0x55
+#define HOST_ADDRESS_TWCR            0x56
+#define HOST_ADDRESS_TIFR            0x58
+#define HOST_ADDRESS_TIMSK           0x59
+#define HOST_ADDRESS_GIFR            0x5A
+#define HOST_ADDRESS_GICR            0x5B
+#define HOST_ADDRESS_OCR0            0x5C
+#define HOST_ADDRESS_SREG            0x5F
+
+/* Register access used by the <avr/io.h> of the host build */
+#define HOST_REGISTER8(ADDRESS)      (*(volatile uint8 *)HOST_access(ADDRESS))
+#define HOST_REGISTER16(ADDRESS)     (*(volatile uint16 *)HOST_access(ADDRESS))
+
+/*
+ * UDR, TWCR, GIFR and TIFR have side effects on read or on writing one to a flag,
+ * which a plain memory copy can't show. They are accessed through a 16-bit copy
+ * holding this marker above the register value: a write always clears it and a
+ * read leaves it, so both are seen on the next access.
+ */
+#define HOST_MARKED_REGISTER(ADDRESS) HOST_REGISTER16(ADDRESS)
+#define HOST_MARKER                  0x100
+
+/* ATmega32 interrupt vector numbers */
+#define HOST_VECTOR_INT0             1
+#define HOST_VECTOR_INT1             2
+#define HOST_VECTOR_INT2             3
+#define HOST_VECTOR_TIMER2_COMP      4
+#define HOST_VECTOR_TIMER2_OVF       5
+#define HOST_VECTOR_TIMER1_CAPT      6
+#define HOST_VECTOR_TIMER1_COMPA     7
+#define HOST_VECTOR_TIMER1_COMPB     8
+#define HOST_VECTOR_TIMER1_OVF       9
+#define HOST_VECTOR_TIMER0_COMP      10
+#define HOST_VECTOR_TIMER0_OVF       11
+#define HOST_VECTOR_SPI_STC          12
+#define HOST_VECTOR_USART_RXC        13
+#define HOST_VECTOR_USART_UDRE       14
+#define HOST_VECTOR_USART_TXC        15
+#define HOST_VECTOR_ADC              16
+#define HOST_VECTOR_EE_RDY           17
+#define HOST_VECTOR_ANA_COMP         18
+#define HOST_VECTOR_TWI              19
+#define HOST_VECTOR_SPM_RDY          20
+#define HOST_VECTORS_NUM             21
+
+/* Virtual time value used for an event that never happens */
+#define HOST_NEVER                   0xFFFFFFFFFFFFFFFFULL
+
+/* Virtual time conversions, the time is counted in CPU cycles */
+#define HOST_CYCLES_PER_MS           (F_CPU / 1000UL)
+#define HOST_MS_TO_CYCLES(MS)        ((uint64)(MS) * HOST_CYCLES_PER_MS)
+
+/* Bus conditions given to the TWI monitor */
+#define HOST_TWI_BUS_START           0
+#define HOST_TWI_BUS_STOP            1
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+/*
+ * Device connected to the pins of the emulated MCU, like a keypad or a motor.
+ * All the call backs are optional.
+ */
+typedef struct
+{
+	/* The output level or the direction of a pin of the port has changed */
+	void (*portChanged)(uint8 port_id);
+	/* Virtual time of the next change the device makes by itself */
+	uint64 (*nextEvent)(void);
+	/* Make the changes due up to the virtual time now */
+	void (*advance)(uint64 now);
+}HOST_DeviceType;
+
+/* Device on the TWI bus, only the master transmitter/receiver modes are emulated */
+typedef struct
+{
+	uint8 address;          /* 7-bit slave address */
+	uint8 address_mask;     /* Address bits compared, the others are passed to start */
+	/* Addressed with SLA+R/W, returns TRUE to acknowledge */
+	boolean (*start)(uint8 address, boolean read);
+	/* Byte written by the master, returns TRUE to acknowledge */
+	boolean (*write)(uint8 data);
+	/* Byte read by the master */
+	uint8 (*read)(void);
+	/* Stop condition */
+	void (*stop)(void);
+}HOST_TwiDeviceType;
+
+/*
+ * Entry points of an ECU linked with the emulated MCU in one relocatable object,
+ * used to run the two ECUs in one co-simulation process (see sim.c). Each ECU
+ * object keeps its own copy of the firmware and of the MCU, only its HOST_ecu
+ * table stays global under the name <ECU>_host.
+ */
+typedef struct
+{
+	int (*main)(void);
+	void (*setName)(const char *name);
+	void (*setTimeLimit)(uint64 time, void (*a_ptr)(void));
+	uint64 (*getTime)(void);
+	uint64 (*getWakeTime)(void);
+	void (*addDevice)(const HOST_DeviceType *device);
+	void (*drivePin)(uint8 port_id, uint8 pin_id, uint8 value);
+	void (*releasePin)(uint8 port_id, uint8 pin_id);
+	uint8 (*getPortOutput)(uint8 port_id);
+	uint8 (*getPortDirection)(uint8 port_id);
+	uint8 (*getRegister)(uint8 address);
+	void (*setAnalogInput)(uint8 channel, uint16 value);
+	void (*uartReceive)(uint8 data);
+	void (*uartConnect)(void (*a_ptr)(uint8 data));
+	uint64 (*uartGetFrameCycles)(void);
+	void (*twiAttach)(const HOST_TwiDeviceType *device);
+	void (*twiMonitor)(void (*a_ptr)(uint8 condition));
+	void (*report)(void);
+}HOST_EcuType;
+
+/*******************************************************************************
+ *                           External Variables                                *
+ *******************************************************************************/
+
+extern const HOST_EcuType HOST_ecu;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Return the location of the register the firmware is going to read or write.
+ * The register writes made since the previous access are given to the emulated
+ * peripherals first, then the virtual time advances by one cycle and the
+ * pending interrupts are served if the global interrupt flag is set.
+ */
+volatile void *HOST_access(uint8 address);
+
+/*
+ * Description :
+ * The cli()/sei() instructions. As on the AVR, an interrupt pending when sei()
+ * is executed is served after the next instruction (the next register access).
+ */
+void HOST_cli(void);
+void HOST_sei(void);
+
+/*
+ * Description :
+ * The sleep instruction, the virtual time jumps to the next event of the
+ * emulated peripherals and devices until an enabled interrupt is served.
+ */
+void HOST_sleep(void);
+
+/*
+ * Description :
+ * Busy wait of the given CPU cycles, the interrupts are served meanwhile.
+ */
+void HOST_delay(uint64 cycles);
+
+/*
+ * Description :
+ * Return the virtual time in CPU cycles since the reset.
+ */
+uint64 HOST_getTime(void);
+
+/*
+ * Description :
+ * Return the earliest virtual time the firmware can run again. While the CPU
+ * sleeps or busy waits in _delay_ms(), only the peripheral and device events
+ * wake it up before the end of the wait. While the firmware runs, it is now.
+ */
+uint64 HOST_getWakeTime(void);
+
+/*
+ * Description :
+ * Set the virtual time limit of the run. When it is reached the call back is
+ * called and the run goes on after the call back raised the limit, without a
+ * call back the summary is printed and the program exits.
+ */
+void HOST_setTimeLimit(uint64 time, void (*a_ptr)(void));
+
+/*
+ * Description :
+ * Set the name printed before the messages, the program name by default.
+ */
+void HOST_setName(const char *name);
+
+/*
+ * Description :
+ * Read or write a register from a device or a test without going through the
+ * firmware access path, the peripherals don't see these writes.
+ */
+uint8 HOST_getRegister(uint8 address);
+void HOST_setRegister(uint8 address, uint8 value);
+
+/*
+ * Description :
+ * Connect a device to the MCU pins, up to HOST_DEVICES_MAX devices.
+ */
+void HOST_addDevice(const HOST_DeviceType *device);
+
+/*
+ * Description :
+ * Drive an input pin from outside the MCU or release it. A released pin reads
+ * high with the internal pull-up enabled and low otherwise.
+ */
+void HOST_drivePin(uint8 port_id, uint8 pin_id, uint8 value);
+void HOST_releasePin(uint8 port_id, uint8 pin_id);
+
+/*
+ * Description :
+ * Return the level the MCU drives on the pins of the port, the input pins read 0.
+ */
+uint8 HOST_getPortOutput(uint8 port_id);
+
+/*
+ * Description :
+ * Return the direction register of the port.
+ */
+uint8 HOST_getPortDirection(uint8 port_id);
+
+/*
+ * Description :
+ * Set the voltage on an ADC channel as a 10-bit conversion result.
+ */
+void HOST_setAnalogInput(uint8 channel, uint16 value);
+
+/*
+ * Description :
+ * Deliver a byte at the end of its frame to the UART receiver. A byte received
+ * while the receive buffer is full is lost and the data overrun flag is set.
+ */
+void HOST_uartReceive(uint8 data);
+
+/*
+ * Description :
+ * Give every transmitted byte to the call back at the virtual time its frame
+ * starts, the frame ends HOST_uartGetFrameCycles() later. Without a call back
+ * the bytes are logged and written to a redirected stdout at the end of their
+ * frame, and a redirected stdin is received.
+ */
+void HOST_uartConnect(void (*a_ptr)(uint8 data));
+
+/*
+ * Description :
+ * Return the duration of one UART frame in CPU cycles with the current settings.
+ */
+uint64 HOST_uartGetFrameCycles(void);
+
+/*
+ * Description :
+ * Connect a device to the TWI bus, up to HOST_TWI_DEVICES_MAX devices.
+ */
+void HOST_twiAttach(const HOST_TwiDeviceType *device);
+
+/*
+ * Description :
+ * Call the function at every START (HOST_TWI_BUS_START) and STOP (HOST_TWI_BUS_STOP)
+ * condition the TWI master puts on the bus.
+ */
+void HOST_twiMonitor(void (*a_ptr)(uint8 condition));
+
+/*
+ * Description :
+ * Print the summary of the run on stderr: the virtual time, the interrupts
+ * served and the statistics of the peripherals.
+ */
+void HOST_report(void);
+
+/*
+ * Description :
+ * Print the summary of the run on stderr and exit with the status.
+ */
+void HOST_exit(int status);
+
+#endif /* HOST_H_ */
@@ -0,0 +1,210 @@
+ /******************************************************************************
+ *
+ * Module: HOST
+ *
+ * File Name: host_adc.c
+ *
+ * Description: Source file for the emulated ATmega32 ADC
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                      Used Header Files                                      *
+ *******************************************************************************/
+
+#include "host_models.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define HOST_ADC_CHANNELS_NUM        8
+#define HOST_ADC_MAX_VALUE           0x3FF
+
+/* ADC clock cycles of the first conversion after enabling the ADC and of the next ones */
+#define HOST_ADC_FIRST_CONVERSION    25
+#define HOST_ADC_CONVERSION          13
+
+/*
+ * The conversion complete flag ADIF is kept here and always reads zero, so a
+ * read, modify and write of ADCSRA writing one to ADIF is seen as a change.
+ * Only the free running auto trigger source is emulated.
+ */
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+static uint16 g_inputs[HOST_ADC_CHANNELS_NUM];
+
+static boolean g_converting;
+static boolean g_firstConversion = TRUE;
+static uint64 g_conversionEndTime;
+static boolean g_conversionComplete;
+
+/* Statistics */
+static uint32 g_conversions;
+
+static const uint8 g_adcRegisters[] =
+{
+	HOST_ADDRESS_ADC, HOST_ADDRESS_ADC + 1, HOST_ADDRESS_ADCSRA, HOST_ADDRESS_ADMUX, HOST_NO_ADDRESS
+};
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Return the CPU cycles of one conversion with the current prescaler.
+ */
+static uint64 HOST_adcConversionCycles(boolean first);
+
+/*
+ * Interrupt call backs.
+ */
+static boolean HOST_adcIsPending(void);
+static void HOST_adcAcknowledge(void);
+
+/*
+ * Peripheral call backs.
+ */
+static void HOST_adcWrite(uint8 address, uint8 old_value);
+static uint64 HOST_adcNextEvent(void);
+static void HOST_adcAdvance(uint64 now);
+static void HOST_adcReport(void);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*[FUNCTION NAME]	: HOST_setAnalogInput
+ *[DESCRIPTION]		: Set the input of an ADC channel as a 10-bit conversion result
+ *[ARGUMENTS]		: channel of type uint8 and value of type uint16
+ *[RETURNS]			: void
+ */
+void HOST_setAnalogInput(uint8 channel, uint16 value)
+{
+	if(channel < HOST_ADC_CHANNELS_NUM)
+	{
+		g_inputs[channel] = (value > HOST_ADC_MAX_VALUE) ? HOST_ADC_MAX_VALUE : value;
+	}
+}
+
+static uint64 HOST_adcConversionCycles(boolean first)
+{
+	uint8 prescaler_select = HOST_io[HOST_ADDRESS_ADCSRA] & 0x07;
+	uint64 prescaler = (prescaler_select == 0) ? 2 : ((uint64)1 << prescaler_select);
+
+	return prescaler * (first ? HOST_ADC_FIRST_CONVERSION : HOST_ADC_CONVERSION);
+}
+
+static boolean HOST_adcIsPending(void)
+{
+	return g_conversionComplete && BIT_IS_SET(HOST_io[HOST_ADDRESS_ADCSRA],ADIE);
+}
+
+static void HOST_adcAcknowledge(void)
+{
+	g_conversionComplete = FALSE;
+}
+
+static void HOST_adcWrite(uint8 address, uint8 old_value)
+{
+	uint8 value = HOST_io[address];
+
+	if(address != HOST_ADDRESS_ADCSRA)
+	{
+		/* ADMUX is used as written, the result registers are read only */
+		if(address != HOST_ADDRESS_ADMUX)
+		{
+			HOST_setRegister(address, old_value);
+		}
+		return;
+	}
+
+	if(BIT_IS_SET(value,ADIF))
+	{
+		g_conversionComplete = FALSE;
+		CLEAR_BIT(value,ADIF);
+	}
+	if(BIT_IS_CLEAR(value,ADEN))
+	{
+		/* Disabling the ADC stops the conversion */
+		g_converting = FALSE;
+		g_firstConversion = TRUE;
+		CLEAR_BIT(value,ADSC);
+	}
+	else if(BIT_IS_SET(value,ADSC) && !g_converting)
+	{
+		g_converting = TRUE;
+		g_conversionEndTime = HOST_getTime() + HOST_adcConversionCycles(g_firstConversion);
+		g_firstConversion = FALSE;
+	}
+	else if(g_converting)
+	{
+		/* Writing zero to ADSC has no effect */
+		SET_BIT(value,ADSC);
+	}
+	HOST_setRegister(address, value);
+}
+
+static uint64 HOST_adcNextEvent(void)
+{
+	return g_converting ? g_conversionEndTime : HOST_NEVER;
+}
+
+static void HOST_adcAdvance(uint64 now)
+{
+	uint8 control;
+	uint16 result;
+
+	while(g_converting && (g_conversionEndTime <= now))
+	{
+		control = HOST_io[HOST_ADDRESS_ADCSRA];
+		result = g_inputs[HOST_io[HOST_ADDRESS_ADMUX] & 0x07];
+		if(BIT_IS_SET(HOST_io[HOST_ADDRESS_ADMUX],ADLAR))
+		{
+			result <<= 6;
+		}
+		HOST_setRegister(HOST_ADDRESS_ADC, (uint8)result);
+		HOST_setRegister(HOST_ADDRESS_ADC + 1, (uint8)(result >> 8));
+		g_conversionComplete = TRUE;
+		g_conversions++;
+
+		/* The free running mode starts the next conversion at once */
+		if(BIT_IS_SET(control,ADATE) && ((HOST_io[HOST_ADDRESS_SFIOR] & 0xE0) == 0))
+		{
+			g_conversionEndTime += HOST_adcConversionCycles(FALSE);
+		}
+		else
+		{
+			g_converting = FALSE;
+			HOST_setRegister(HOST_ADDRESS_ADCSRA, control & ~(1 << ADSC));
+		}
+	}
+}
+
+static void HOST_adcReport(void)
+{
+	if(g_conversions != 0)
+	{
+		HOST_log("ADC %lu conversions", (unsigned long)g_conversions);
+	}
+}
+
+/*******************************************************************************
+ *                      Peripheral Description                                 *
+ *******************************************************************************/
+
+static const HOST_InterruptType g_adcInterrupts[] =
+{
+	{HOST_VECTOR_ADC, HOST_adcIsPending, HOST_adcAcknowledge}
+};
+
+const HOST_ModelType HOST_adcModel =
+{
+	"ADC", g_adcRegisters, g_adcInterrupts, 1, NULL_PTR, HOST_adcWrite,
+	NULL_PTR, HOST_adcNextEvent, HOST_adcAdvance, HOST_adcReport
+};
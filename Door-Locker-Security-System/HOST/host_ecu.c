@@ -0,0 +1,37 @@
+ /******************************************************************************
+ *
+ * Module: HOST
+ *
+ * File Name: host_ecu.c
+ *
+ * Description: Source file for the entry points table of the host ECU, used by
+ *              the co-simulation of the two ECUs
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                      Used Header Files                                      *
+ *******************************************************************************/
+
+#include "host.h"
+
+/*******************************************************************************
+ *                           External Functions                                *
+ *******************************************************************************/
+
+/* The firmware main function */
+extern int main(void);
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+const HOST_EcuType HOST_ecu =
+{
+	main, HOST_setName, HOST_setTimeLimit, HOST_getTime, HOST_getWakeTime, HOST_addDevice,
+	HOST_drivePin, HOST_releasePin, HOST_getPortOutput, HOST_getPortDirection, HOST_getRegister,
+	HOST_setAnalogInput, HOST_uartReceive, HOST_uartConnect, HOST_uartGetFrameCycles,
+	HOST_twiAttach, HOST_twiMonitor, HOST_report
+};
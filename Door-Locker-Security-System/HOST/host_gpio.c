@@ -0,0 +1,302 @@
+ /******************************************************************************
+ *
+ * Module: HOST
+ *
+ * File Name: host_gpio.c
+ *
+ * Description: Source file for the emulated ATmega32 ports and external interrupts
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                      Used Header Files                                      *
+ *******************************************************************************/
+
+#include "host_models.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define HOST_PORTS_NUM               4
+
+/* The PINx, DDRx and PORTx registers of a port follow each other */
+#define HOST_PIN_ADDRESS(PORT_ID)    (HOST_ADDRESS_PINA - (3 * (PORT_ID)))
+#define HOST_DDR_ADDRESS(PORT_ID)    (HOST_PIN_ADDRESS(PORT_ID) + 1)
+#define HOST_PORT_ADDRESS(PORT_ID)   (HOST_PIN_ADDRESS(PORT_ID) + 2)
+#define HOST_PORT_OF(ADDRESS)        ((HOST_ADDRESS_PINA - (ADDRESS) + 2) / 3)
+
+/* Pins of the external interrupts */
+#define HOST_INT0_PORT               3
+#define HOST_INT0_PIN                2
+#define HOST_INT1_PORT               3
+#define HOST_INT1_PIN                3
+#define HOST_INT2_PORT               1
+#define HOST_INT2_PIN                2
+
+/* External interrupt sense control */
+#define HOST_SENSE_LOW_LEVEL         0
+#define HOST_SENSE_ANY_CHANGE        1
+#define HOST_SENSE_FALLING_EDGE      2
+#define HOST_SENSE_RISING_EDGE       3
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/* Input pins driven by the devices and their levels */
+static uint8 g_drivenPins[HOST_PORTS_NUM];
+static uint8 g_drivenLevels[HOST_PORTS_NUM];
+
+/* Pin levels of INT0, INT1 and INT2 in bits 0, 1 and 2 at the last update */
+static uint8 g_interruptLevels = 0;
+
+static const uint8 g_gpioRegisters[] =
+{
+	HOST_ADDRESS_PINA, HOST_ADDRESS_DDRA, HOST_ADDRESS_PORTA, HOST_ADDRESS_PINB, HOST_ADDRESS_DDRB,
+	HOST_ADDRESS_PORTB, HOST_ADDRESS_PINC, HOST_ADDRESS_DDRC, HOST_ADDRESS_PORTC, HOST_ADDRESS_PIND,
+	HOST_ADDRESS_DDRD, HOST_ADDRESS_PORTD, HOST_ADDRESS_SFIOR, HOST_ADDRESS_GIFR, HOST_ADDRESS_GICR,
+	HOST_ADDRESS_MCUCR, HOST_ADDRESS_MCUCSR, HOST_NO_ADDRESS
+};
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Calculate the PINx registers from the outputs, the pull-ups and the driven
+ * inputs, then set the flags of the external interrupts on their edges.
+ */
+static void HOST_gpioUpdate(void);
+
+/*
+ * Return the sense control of the external interrupt 0, 1 or 2.
+ */
+static uint8 HOST_gpioSense(uint8 int_id);
+
+/*
+ * Interrupt call backs of the external interrupts.
+ */
+static boolean HOST_int0IsPending(void);
+static boolean HOST_int1IsPending(void);
+static boolean HOST_int2IsPending(void);
+static void HOST_int0Acknowledge(void);
+static void HOST_int1Acknowledge(void);
+static void HOST_int2Acknowledge(void);
+
+/*
+ * Peripheral call backs.
+ */
+static void HOST_gpioReset(void);
+static void HOST_gpioWrite(uint8 address, uint8 old_value);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*[FUNCTION NAME]	: HOST_drivePin
+ *[DESCRIPTION]		: Drive an input pin from outside the MCU
+ *[ARGUMENTS]		: port ID, pin ID and level of type uint8
+ *[RETURNS]			: void
+ */
+void HOST_drivePin(uint8 port_id, uint8 pin_id, uint8 value)
+{
+	SET_BIT(g_drivenPins[port_id],pin_id);
+	if(value == LOGIC_HIGH)
+	{
+		SET_BIT(g_drivenLevels[port_id],pin_id);
+	}
+	else
+	{
+		CLEAR_BIT(g_drivenLevels[port_id],pin_id);
+	}
+	HOST_gpioUpdate();
+}
+
+/*[FUNCTION NAME]	: HOST_releasePin
+ *[DESCRIPTION]		: Stop driving an input pin from outside the MCU
+ *[ARGUMENTS]		: port ID and pin ID of type uint8
+ *[RETURNS]			: void
+ */
+void HOST_releasePin(uint8 port_id, uint8 pin_id)
+{
+	CLEAR_BIT(g_drivenPins[port_id],pin_id);
+	HOST_gpioUpdate();
+}
+
+/*[FUNCTION NAME]	: HOST_getPortOutput
+ *[DESCRIPTION]		: Return the levels driven by the MCU on the output pins of the port
+ *[ARGUMENTS]		: port ID of type uint8
+ *[RETURNS]			: levels of type uint8, the input pins read 0
+ */
+uint8 HOST_getPortOutput(uint8 port_id)
+{
+	return HOST_io[HOST_PORT_ADDRESS(port_id)] & HOST_io[HOST_DDR_ADDRESS(port_id)];
+}
+
+/*[FUNCTION NAME]	: HOST_getPortDirection
+ *[DESCRIPTION]		: Return the direction register of the port
+ *[ARGUMENTS]		: port ID of type uint8
+ *[RETURNS]			: direction bits of type uint8, 1 for an output pin
+ */
+uint8 HOST_getPortDirection(uint8 port_id)
+{
+	return HOST_io[HOST_DDR_ADDRESS(port_id)];
+}
+
+static void HOST_gpioUpdate(void)
+{
+	uint8 port_id;
+	uint8 pull_ups;
+	uint8 inputs;
+	uint8 levels;
+	uint8 changed;
+	uint8 int_id;
+	uint8 sense;
+	uint8 flag;
+	static const uint8 int_flags[3] = {INTF0, INTF1, INTF2};
+
+	for(port_id = 0 ; port_id < HOST_PORTS_NUM ; port_id++)
+	{
+		/* A released input reads high with the pull-up and low without it */
+		pull_ups = BIT_IS_SET(HOST_io[HOST_ADDRESS_SFIOR],PUD) ? 0 : HOST_io[HOST_PORT_ADDRESS(port_id)];
+		inputs = (g_drivenPins[port_id] & g_drivenLevels[port_id]) | (~g_drivenPins[port_id] & pull_ups);
+		HOST_setRegister(HOST_PIN_ADDRESS(port_id),
+				(uint8)((HOST_getPortOutput(port_id)) | (~HOST_io[HOST_DDR_ADDRESS(port_id)] & inputs)));
+	}
+
+	levels = (GET_BIT(HOST_io[HOST_PIN_ADDRESS(HOST_INT0_PORT)],HOST_INT0_PIN) << 0) |
+			(GET_BIT(HOST_io[HOST_PIN_ADDRESS(HOST_INT1_PORT)],HOST_INT1_PIN) << 1) |
+			(GET_BIT(HOST_io[HOST_PIN_ADDRESS(HOST_INT2_PORT)],HOST_INT2_PIN) << 2);
+	changed = levels ^ g_interruptLevels;
+	g_interruptLevels = levels;
+
+	/* The flags are set on the selected edges even with the interrupts disabled */
+	for(int_id = 0 ; int_id < 3 ; int_id++)
+	{
+		if(BIT_IS_SET(changed,int_id))
+		{
+			sense = HOST_gpioSense(int_id);
+			flag = ((sense == HOST_SENSE_ANY_CHANGE) ||
+					((sense == HOST_SENSE_RISING_EDGE) && BIT_IS_SET(levels,int_id)) ||
+					((sense == HOST_SENSE_FALLING_EDGE) && BIT_IS_CLEAR(levels,int_id)));
+			if(flag)
+			{
+				HOST_setRegister(HOST_ADDRESS_GIFR, HOST_io[HOST_ADDRESS_GIFR] | (1 << int_flags[int_id]));
+			}
+		}
+	}
+}
+
+static uint8 HOST_gpioSense(uint8 int_id)
+{
+	switch(int_id)
+	{
+	case 0:
+		return HOST_io[HOST_ADDRESS_MCUCR] & 0x03;
+	case 1:
+		return (HOST_io[HOST_ADDRESS_MCUCR] >> ISC10) & 0x03;
+	default:
+		/* INT2 is edge triggered only, ISC2 selects the rising edge */
+		return BIT_IS_SET(HOST_io[HOST_ADDRESS_MCUCSR],ISC2) ? HOST_SENSE_RISING_EDGE : HOST_SENSE_FALLING_EDGE;
+	}
+}
+
+static boolean HOST_int0IsPending(void)
+{
+	return BIT_IS_SET(HOST_io[HOST_ADDRESS_GICR],INT0) &&
+			(BIT_IS_SET(HOST_io[HOST_ADDRESS_GIFR],INTF0) ||
+			((HOST_gpioSense(0) == HOST_SENSE_LOW_LEVEL) && BIT_IS_CLEAR(g_interruptLevels,0)));
+}
+
+static boolean HOST_int1IsPending(void)
+{
+	return BIT_IS_SET(HOST_io[HOST_ADDRESS_GICR],INT1) &&
+			(BIT_IS_SET(HOST_io[HOST_ADDRESS_GIFR],INTF1) ||
+			((HOST_gpioSense(1) == HOST_SENSE_LOW_LEVEL) && BIT_IS_CLEAR(g_interruptLevels,1)));
+}
+
+static boolean HOST_int2IsPending(void)
+{
+	return BIT_IS_SET(HOST_io[HOST_ADDRESS_GICR],INT2) && BIT_IS_SET(HOST_io[HOST_ADDRESS_GIFR],INTF2);
+}
+
+static void HOST_int0Acknowledge(void)
+{
+	HOST_setRegister(HOST_ADDRESS_GIFR, HOST_io[HOST_ADDRESS_GIFR] & ~(1 << INTF0));
+}
+
+static void HOST_int1Acknowledge(void)
+{
+	HOST_setRegister(HOST_ADDRESS_GIFR, HOST_io[HOST_ADDRESS_GIFR] & ~(1 << INTF1));
+}
+
+static void HOST_int2Acknowledge(void)
+{
+	HOST_setRegister(HOST_ADDRESS_GIFR, HOST_io[HOST_ADDRESS_GIFR] & ~(1 << INTF2));
+}
+
+static void HOST_gpioReset(void)
+{
+	uint8 port_id;
+
+	for(port_id = 0 ; port_id < HOST_PORTS_NUM ; port_id++)
+	{
+		g_drivenPins[port_id] = 0;
+		g_drivenLevels[port_id] = 0;
+	}
+	g_interruptLevels = 0;
+	HOST_gpioUpdate();
+}
+
+static void HOST_gpioWrite(uint8 address, uint8 old_value)
+{
+	uint8 port_id;
+
+	switch(address)
+	{
+	case HOST_ADDRESS_GIFR:
+		/* The flags are cleared by writing one to them */
+		HOST_setRegister(address, old_value & ~HOST_io[address]);
+		break;
+	case HOST_ADDRESS_PINA:
+	case HOST_ADDRESS_PINB:
+	case HOST_ADDRESS_PINC:
+	case HOST_ADDRESS_PIND:
+		/* Read only */
+		HOST_setRegister(address, old_value);
+		break;
+	case HOST_ADDRESS_SFIOR:
+		HOST_gpioUpdate();
+		break;
+	case HOST_ADDRESS_GICR:
+	case HOST_ADDRESS_MCUCR:
+	case HOST_ADDRESS_MCUCSR:
+		/* Used when the pins change */
+		break;
+	default:
+		port_id = HOST_PORT_OF(address);
+		HOST_gpioUpdate();
+		HOST_devicesPortChanged(port_id);
+		break;
+	}
+}
+
+/*******************************************************************************
+ *                      Peripheral Description                                 *
+ *******************************************************************************/
+
+static const HOST_InterruptType g_gpioInterrupts[] =
+{
+	{HOST_VECTOR_INT0, HOST_int0IsPending, HOST_int0Acknowledge},
+	{HOST_VECTOR_INT1, HOST_int1IsPending, HOST_int1Acknowledge},
+	{HOST_VECTOR_INT2, HOST_int2IsPending, HOST_int2Acknowledge}
+};
+
+const HOST_ModelType HOST_gpioModel =
+{
+	"GPIO", g_gpioRegisters, g_gpioInterrupts, 3, HOST_gpioReset, HOST_gpioWrite,
+	NULL_PTR, NULL_PTR, NULL_PTR, NULL_PTR
+};
@@ -0,0 +1,127 @@
+ /******************************************************************************
+ *
+ * Module: HOST
+ *
+ * File Name: host_models.h
+ *
+ * Description: Private header shared by the emulated ATmega32 peripherals
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+#ifndef HOST_MODELS_H_
+#define HOST_MODELS_H_
+
+#include "host.h"
+#include "common_macros.h"
+#include <avr/io.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define HOST_DEVICES_MAX             8
+#define HOST_TWI_DEVICES_MAX         4
+
+/* Value of HOST_ModelType.registers entries after the last register */
+#define HOST_NO_ADDRESS              0
+
+/* Address of the 8-bit or 16-bit register value in the register array */
+#define HOST_IO8(ADDRESS)            (HOST_io[ADDRESS])
+#define HOST_IO16(ADDRESS)           (*(uint16 *)&HOST_io[ADDRESS])
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+/* Interrupt request of an emulated peripheral */
+typedef struct
+{
+	uint8 vector;
+	/* The interrupt flag and its enable bit are set */
+	boolean (*isPending)(void);
+	/* The interrupt is served, clear the flags cleared by the hardware */
+	void (*acknowledge)(void);
+}HOST_InterruptType;
+
+/* Emulated peripheral, all the call backs are optional */
+typedef struct
+{
+	const char *name;
+	/* Registers owned by the peripheral, ended by HOST_NO_ADDRESS */
+	const uint8 *registers;
+	const HOST_InterruptType *interrupts;
+	uint8 interrupts_num;
+	/* Reset values of the registers and the peripheral state */
+	void (*reset)(void);
+	/* The firmware wrote the register, its value before the write is given */
+	void (*write)(uint8 address, uint8 old_value);
+	/* The firmware read a marked register */
+	void (*read)(uint8 address);
+	/* Virtual time of the next change the peripheral makes by itself */
+	uint64 (*nextEvent)(void);
+	/* Make the changes due up to the virtual time now */
+	void (*advance)(uint64 now);
+	/* Print the peripheral statistics at exit */
+	void (*report)(void);
+}HOST_ModelType;
+
+/*******************************************************************************
+ *                           External Variables                                *
+ *******************************************************************************/
+
+/* Register values as the firmware sees them */
+extern uint8 HOST_io[HOST_IO_SIZE];
+
+/* Emulated peripherals */
+extern const HOST_ModelType HOST_cpuModel;
+extern const HOST_ModelType HOST_gpioModel;
+extern const HOST_ModelType HOST_timerModel;
+extern const HOST_ModelType HOST_uartModel;
+extern const HOST_ModelType HOST_adcModel;
+extern const HOST_ModelType HOST_twiModel;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Print a message prefixed with the virtual time on stderr.
+ */
+void HOST_log(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+/*
+ * Description :
+ * Print the message and stop the emulation with a failure status.
+ */
+void HOST_fatal(const char *format, ...) __attribute__((format(printf, 1, 2), noreturn));
+
+/*
+ * Description :
+ * Call the advance and nextEvent call backs of the connected devices.
+ */
+void HOST_devicesAdvance(uint64 now);
+uint64 HOST_devicesNextEvent(void);
+
+/*
+ * Description :
+ * Tell the devices that the output level or the direction of a port changed.
+ */
+void HOST_devicesPortChanged(uint8 port_id);
+
+/*
+ * Description :
+ * Start receiving the redirected stdin, used when no UART peer is connected.
+ */
+void HOST_uartUseStdio(void);
+
+/*
+ * Description :
+ * Load the external EEPROM contents from the file and save them back on every
+ * write cycle, used when HOST_EEPROM_FILE is set.
+ */
+void HOST_eepromUseFile(const char *path);
+
+#endif /* HOST_MODELS_H_ */
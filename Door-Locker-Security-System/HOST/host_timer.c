@@ -0,0 +1,436 @@
+ /******************************************************************************
+ *
+ * Module: HOST
+ *
+ * File Name: host_timer.c
+ *
+ * Description: Source file for the emulated ATmega32 timers 0, 1 and 2
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                      Used Header Files                                      *
+ *******************************************************************************/
+
+#include "host_models.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define HOST_TIMERS_NUM              3
+#define HOST_TIMER0                  0
+#define HOST_TIMER1                  1
+#define HOST_TIMER2                  2
+
+/*
+ * Only the counting, the compare matches and the overflow flags are emulated.
+ * The PWM modes count up to the maximum like the normal mode (the phase correct
+ * mode doesn't count down) and the output compare pins are not driven, the
+ * devices read the timer registers instead. The external clock and the
+ * asynchronous Timer2 are not emulated.
+ */
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+typedef struct
+{
+	uint8 counter_address;
+	uint8 compare_a_address;
+	uint8 compare_b_address;     /* HOST_NO_ADDRESS when the timer has one compare unit */
+	uint16 max;
+	/* Bits of the timer in TIFR, the same bits enable the interrupts in TIMSK */
+	uint8 overflow_flag;
+	uint8 compare_a_flag;
+	uint8 compare_b_flag;
+	/* Clock prescaler of each clock select value, 0 when the timer is stopped */
+	uint16 prescalers[8];
+}HOST_TimerType;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+static const HOST_TimerType g_timers[HOST_TIMERS_NUM] =
+{
+	{HOST_ADDRESS_TCNT0, HOST_ADDRESS_OCR0, HOST_NO_ADDRESS, 0xFF, TOV0, OCF0, OCF0,
+			{0, 1, 8, 64, 256, 1024, 0, 0}},
+	{HOST_ADDRESS_TCNT1, HOST_ADDRESS_OCR1A, HOST_ADDRESS_OCR1B, 0xFFFF, TOV1, OCF1A, OCF1B,
+			{0, 1, 8, 64, 256, 1024, 0, 0}},
+	{HOST_ADDRESS_TCNT2, HOST_ADDRESS_OCR2, HOST_NO_ADDRESS, 0xFF, TOV2, OCF2, OCF2,
+			{0, 1, 8, 32, 64, 128, 256, 1024}}
+};
+
+/* Virtual time the counter of each timer was last updated at */
+static uint64 g_updateTime[HOST_TIMERS_NUM];
+
+static const uint8 g_timerRegisters[] =
+{
+	HOST_ADDRESS_TCNT0, HOST_ADDRESS_TCCR0, HOST_ADDRESS_OCR0, HOST_ADDRESS_TCNT1, HOST_ADDRESS_TCNT1 + 1,
+	HOST_ADDRESS_TCCR1A, HOST_ADDRESS_TCCR1B, HOST_ADDRESS_OCR1A, HOST_ADDRESS_OCR1A + 1, HOST_ADDRESS_OCR1B,
+	HOST_ADDRESS_OCR1B + 1, HOST_ADDRESS_TCNT2, HOST_ADDRESS_TCCR2, HOST_ADDRESS_OCR2, HOST_ADDRESS_TIFR,
+	HOST_ADDRESS_TIMSK, HOST_NO_ADDRESS
+};
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Return the timer clock prescaler, 0 when the timer is stopped.
+ */
+static uint16 HOST_timerPrescaler(uint8 timer_id);
+
+/*
+ * Return TRUE when the timer is in the clear timer on compare match mode.
+ */
+static boolean HOST_timerIsCtc(uint8 timer_id);
+
+/*
+ * Register value access for the 8-bit and the 16-bit timers.
+ */
+static uint16 HOST_timerGet(uint8 timer_id, uint8 address);
+static void HOST_timerSet(uint8 timer_id, uint8 address, uint16 value);
+
+/*
+ * Return the timer counts from the count to the target, a full period when they
+ * are equal and 0 when the count never reaches the target.
+ */
+static uint32 HOST_timerDistance(uint16 count, uint16 target, uint16 top);
+
+/*
+ * Return the count at which the compare flag is set: the flag follows the match
+ * by one timer clock, when the counter leaves the compare value.
+ */
+static uint16 HOST_timerFlagCount(uint8 timer_id, uint8 compare_address, uint16 top);
+
+/*
+ * Return the timer counts to the next compare match or overflow, the events with
+ * a disabled interrupt are skipped when only_enabled is TRUE.
+ */
+static uint32 HOST_timerNextCounts(uint8 timer_id, boolean only_enabled);
+
+/*
+ * Count the timer up to the virtual time now and set its flags on the way.
+ */
+static void HOST_timerUpdate(uint8 timer_id, uint64 now);
+
+/*
+ * Return the timer owning the register or HOST_TIMERS_NUM for the shared registers.
+ */
+static uint8 HOST_timerOf(uint8 address);
+
+/*
+ * Interrupt call backs, the flag is cleared when the interrupt is served.
+ */
+static boolean HOST_timerIsPending(uint8 flag);
+static void HOST_timerAcknowledge(uint8 flag);
+#define HOST_TIMER_INTERRUPT(NAME,FLAG) \
+	static boolean HOST_##NAME##IsPending(void) { return HOST_timerIsPending(FLAG); } \
+	static void HOST_##NAME##Acknowledge(void) { HOST_timerAcknowledge(FLAG); }
+HOST_TIMER_INTERRUPT(timer2Compare,OCF2)
+HOST_TIMER_INTERRUPT(timer2Overflow,TOV2)
+HOST_TIMER_INTERRUPT(timer1CompareA,OCF1A)
+HOST_TIMER_INTERRUPT(timer1CompareB,OCF1B)
+HOST_TIMER_INTERRUPT(timer1Overflow,TOV1)
+HOST_TIMER_INTERRUPT(timer0Compare,OCF0)
+HOST_TIMER_INTERRUPT(timer0Overflow,TOV0)
+
+/*
+ * Peripheral call backs.
+ */
+static void HOST_timerReset(void);
+static void HOST_timerWrite(uint8 address, uint8 old_value);
+static uint64 HOST_timerNextEvent(void);
+static void HOST_timerAdvance(uint64 now);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+static uint16 HOST_timerPrescaler(uint8 timer_id)
+{
+	uint8 control;
+
+	switch(timer_id)
+	{
+	case HOST_TIMER0:
+		control = HOST_io[HOST_ADDRESS_TCCR0];
+		break;
+	case HOST_TIMER1:
+		control = HOST_io[HOST_ADDRESS_TCCR1B];
+		break;
+	default:
+		control = HOST_io[HOST_ADDRESS_TCCR2];
+		break;
+	}
+	return g_timers[timer_id].prescalers[control & 0x07];
+}
+
+static boolean HOST_timerIsCtc(uint8 timer_id)
+{
+	switch(timer_id)
+	{
+	case HOST_TIMER0:
+		return BIT_IS_SET(HOST_io[HOST_ADDRESS_TCCR0],WGM01) && BIT_IS_CLEAR(HOST_io[HOST_ADDRESS_TCCR0],WGM00);
+	case HOST_TIMER1:
+		/* Mode 4 only, the CTC mode with its top in ICR1 is not used */
+		return ((HOST_io[HOST_ADDRESS_TCCR1B] & 0x18) == (1 << WGM12)) && ((HOST_io[HOST_ADDRESS_TCCR1A] & 0x03) == 0);
+	default:
+		return BIT_IS_SET(HOST_io[HOST_ADDRESS_TCCR2],WGM21) && BIT_IS_CLEAR(HOST_io[HOST_ADDRESS_TCCR2],WGM20);
+	}
+}
+
+static uint16 HOST_timerGet(uint8 timer_id, uint8 address)
+{
+	return (g_timers[timer_id].max == 0xFF) ? HOST_IO8(address) : HOST_IO16(address);
+}
+
+static void HOST_timerSet(uint8 timer_id, uint8 address, uint16 value)
+{
+	HOST_setRegister(address, (uint8)value);
+	if(g_timers[timer_id].max != 0xFF)
+	{
+		HOST_setRegister(address + 1, (uint8)(value >> 8));
+	}
+}
+
+static uint32 HOST_timerDistance(uint16 count, uint16 target, uint16 top)
+{
+	if(target > top)
+	{
+		return 0;
+	}
+	if(target > count)
+	{
+		return target - count;
+	}
+	return ((uint32)top - count) + 1 + target;
+}
+
+static uint16 HOST_timerFlagCount(uint8 timer_id, uint8 compare_address, uint16 top)
+{
+	uint16 compare = HOST_timerGet(timer_id, compare_address);
+
+	/* A compare value above the top is never matched, it is kept so the distance is 0 */
+	if(compare > top)
+	{
+		return compare;
+	}
+	return (compare == top) ? 0 : (compare + 1);
+}
+
+static uint32 HOST_timerNextCounts(uint8 timer_id, boolean only_enabled)
+{
+	const HOST_TimerType *timer = &g_timers[timer_id];
+	uint8 enabled = only_enabled ? HOST_io[HOST_ADDRESS_TIMSK] : 0xFF;
+	uint16 count = HOST_timerGet(timer_id, timer->counter_address);
+	uint16 top = HOST_timerIsCtc(timer_id) ? HOST_timerGet(timer_id, timer->compare_a_address) : timer->max;
+	uint32 nearest = 0;
+	uint32 distance;
+
+	/* The counter wraps after the top, only the normal mode sets the overflow flag there */
+	if(!HOST_timerIsCtc(timer_id) && BIT_IS_SET(enabled,timer->overflow_flag))
+	{
+		nearest = ((uint32)top - count) + 1;
+	}
+	else if(!only_enabled)
+	{
+		nearest = ((uint32)top - count) + 1;
+	}
+
+	if(BIT_IS_SET(enabled,timer->compare_a_flag))
+	{
+		distance = HOST_timerDistance(count, HOST_timerFlagCount(timer_id, timer->compare_a_address, top), top);
+		if((distance != 0) && ((nearest == 0) || (distance < nearest)))
+		{
+			nearest = distance;
+		}
+	}
+	if((timer->compare_b_address != HOST_NO_ADDRESS) && BIT_IS_SET(enabled,timer->compare_b_flag))
+	{
+		distance = HOST_timerDistance(count, HOST_timerFlagCount(timer_id, timer->compare_b_address, top), top);
+		if((distance != 0) && ((nearest == 0) || (distance < nearest)))
+		{
+			nearest = distance;
+		}
+	}
+	return nearest;
+}
+
+static void HOST_timerUpdate(uint8 timer_id, uint64 now)
+{
+	const HOST_TimerType *timer = &g_timers[timer_id];
+	uint16 prescaler = HOST_timerPrescaler(timer_id);
+	uint64 ticks;
+	uint32 step;
+	uint16 count;
+	uint16 top;
+	uint8 flags;
+
+	if(prescaler == 0)
+	{
+		g_updateTime[timer_id] = now;
+		return;
+	}
+
+	/* The prescaler runs all the time, the timer counts on its clock edges */
+	ticks = (now / prescaler) - (g_updateTime[timer_id] / prescaler);
+	g_updateTime[timer_id] = now;
+
+	top = HOST_timerIsCtc(timer_id) ? HOST_timerGet(timer_id, timer->compare_a_address) : timer->max;
+	count = HOST_timerGet(timer_id, timer->counter_address);
+	flags = HOST_io[HOST_ADDRESS_TIFR];
+	while(ticks > 0)
+	{
+		step = HOST_timerNextCounts(timer_id, FALSE);
+		if(ticks < step)
+		{
+			count += (uint16)ticks;
+			HOST_timerSet(timer_id, timer->counter_address, count);
+			break;
+		}
+		ticks -= step;
+		if(((uint32)count + step) > top)
+		{
+			count = (uint16)(((uint32)count + step) - top - 1);
+			if(!HOST_timerIsCtc(timer_id))
+			{
+				SET_BIT(flags,timer->overflow_flag);
+			}
+		}
+		else
+		{
+			count += (uint16)step;
+		}
+		if(count == HOST_timerFlagCount(timer_id, timer->compare_a_address, top))
+		{
+			SET_BIT(flags,timer->compare_a_flag);
+		}
+		if((timer->compare_b_address != HOST_NO_ADDRESS) && (count == HOST_timerFlagCount(timer_id, timer->compare_b_address, top)))
+		{
+			SET_BIT(flags,timer->compare_b_flag);
+		}
+		HOST_timerSet(timer_id, timer->counter_address, count);
+	}
+	HOST_setRegister(HOST_ADDRESS_TIFR, flags);
+}
+
+static uint8 HOST_timerOf(uint8 address)
+{
+	switch(address)
+	{
+	case HOST_ADDRESS_TCNT0:
+	case HOST_ADDRESS_TCCR0:
+	case HOST_ADDRESS_OCR0:
+		return HOST_TIMER0;
+	case HOST_ADDRESS_TCNT2:
+	case HOST_ADDRESS_TCCR2:
+	case HOST_ADDRESS_OCR2:
+		return HOST_TIMER2;
+	case HOST_ADDRESS_TIFR:
+	case HOST_ADDRESS_TIMSK:
+		return HOST_TIMERS_NUM;
+	default:
+		return HOST_TIMER1;
+	}
+}
+
+static boolean HOST_timerIsPending(uint8 flag)
+{
+	return BIT_IS_SET(HOST_io[HOST_ADDRESS_TIFR],flag) && BIT_IS_SET(HOST_io[HOST_ADDRESS_TIMSK],flag);
+}
+
+static void HOST_timerAcknowledge(uint8 flag)
+{
+	HOST_setRegister(HOST_ADDRESS_TIFR, HOST_io[HOST_ADDRESS_TIFR] & ~(1 << flag));
+}
+
+static void HOST_timerReset(void)
+{
+	uint8 timer_id;
+
+	for(timer_id = 0 ; timer_id < HOST_TIMERS_NUM ; timer_id++)
+	{
+		g_updateTime[timer_id] = 0;
+	}
+}
+
+static void HOST_timerWrite(uint8 address, uint8 old_value)
+{
+	uint8 timer_id = HOST_timerOf(address);
+
+	if(address == HOST_ADDRESS_TIFR)
+	{
+		/* The flags are cleared by writing one to them */
+		HOST_setRegister(address, old_value & ~HOST_io[address]);
+	}
+	else if(timer_id != HOST_TIMERS_NUM)
+	{
+		/*
+		 * The counter already counted up to the write, a new counter value or
+		 * setting is used from now on.
+		 */
+		g_updateTime[timer_id] = HOST_getTime();
+	}
+}
+
+static uint64 HOST_timerNextEvent(void)
+{
+	uint64 nearest = HOST_NEVER;
+	uint64 next;
+	uint32 counts;
+	uint16 prescaler;
+	uint8 timer_id;
+
+	for(timer_id = 0 ; timer_id < HOST_TIMERS_NUM ; timer_id++)
+	{
+		prescaler = HOST_timerPrescaler(timer_id);
+		counts = HOST_timerNextCounts(timer_id, TRUE);
+		if((prescaler != 0) && (counts != 0))
+		{
+			/* The counts happen on the prescaler clock edges after the last update */
+			next = ((g_updateTime[timer_id] / prescaler) + counts) * prescaler;
+			if(next < nearest)
+			{
+				nearest = next;
+			}
+		}
+	}
+	return nearest;
+}
+
+static void HOST_timerAdvance(uint64 now)
+{
+	uint8 timer_id;
+
+	for(timer_id = 0 ; timer_id < HOST_TIMERS_NUM ; timer_id++)
+	{
+		HOST_timerUpdate(timer_id, now);
+	}
+}
+
+/*******************************************************************************
+ *                      Peripheral Description                                 *
+ *******************************************************************************/
+
+static const HOST_InterruptType g_timerInterrupts[] =
+{
+	{HOST_VECTOR_TIMER2_COMP, HOST_timer2CompareIsPending, HOST_timer2CompareAcknowledge},
+	{HOST_VECTOR_TIMER2_OVF, HOST_timer2OverflowIsPending, HOST_timer2OverflowAcknowledge},
+	{HOST_VECTOR_TIMER1_COMPA, HOST_timer1CompareAIsPending, HOST_timer1CompareAAcknowledge},
+	{HOST_VECTOR_TIMER1_COMPB, HOST_timer1CompareBIsPending, HOST_timer1CompareBAcknowledge},
+	{HOST_VECTOR_TIMER1_OVF, HOST_timer1OverflowIsPending, HOST_timer1OverflowAcknowledge},
+	{HOST_VECTOR_TIMER0_COMP, HOST_timer0CompareIsPending, HOST_timer0CompareAcknowledge},
+	{HOST_VECTOR_TIMER0_OVF, HOST_timer0OverflowIsPending, HOST_timer0OverflowAcknowledge}
+};
+
+const HOST_ModelType HOST_timerModel =
+{
+	"TIMER", g_timerRegisters, g_timerInterrupts, sizeof(g_timerInterrupts) / sizeof(g_timerInterrupts[0]),
+	HOST_timerReset, HOST_timerWrite, NULL_PTR, HOST_timerNextEvent, HOST_timerAdvance, NULL_PTR
+};
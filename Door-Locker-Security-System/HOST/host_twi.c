@@ -0,0 +1,420 @@
+ /******************************************************************************
+ *
+ * Module: HOST
+ *
+ * File Name: host_twi.c
+ *
+ * Description: Source file for the emulated ATmega32 TWI master and the 24C16
+ *              external EEPROM connected to it
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                      Used Header Files                                      *
+ *******************************************************************************/
+
+#include "host_models.h"
+#include <stdio.h>
+#include <string.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* TWI status codes of the master modes */
+#define HOST_TWI_START               0x08
+#define HOST_TWI_REP_START           0x10
+#define HOST_TWI_MT_SLA_W_ACK        0x18
+#define HOST_TWI_MT_SLA_W_NACK       0x20
+#define HOST_TWI_MT_DATA_ACK         0x28
+#define HOST_TWI_MT_DATA_NACK        0x30
+#define HOST_TWI_MR_SLA_R_ACK        0x40
+#define HOST_TWI_MR_SLA_R_NACK       0x48
+#define HOST_TWI_MR_DATA_ACK         0x50
+#define HOST_TWI_MR_DATA_NACK        0x58
+#define HOST_TWI_NO_STATE            0xF8
+
+/* SCL periods taken by a start condition and by a byte with its acknowledge */
+#define HOST_TWI_START_PERIODS       1
+#define HOST_TWI_BYTE_PERIODS        9
+
+/* 24C16: 2K bytes in 8 blocks of 256 selected by the slave address, 16 bytes pages */
+#define HOST_EEPROM_SIZE             2048
+#define HOST_EEPROM_ADDRESS          0x50
+#define HOST_EEPROM_ADDRESS_MASK     0x78
+#define HOST_EEPROM_PAGE_SIZE        16
+#define HOST_EEPROM_WRITE_CYCLE_MS   5
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+typedef enum
+{
+	HOST_TWI_IDLE, HOST_TWI_STARTED, HOST_TWI_TRANSMITTING, HOST_TWI_RECEIVING
+}HOST_TwiStateType;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+static const HOST_TwiDeviceType *g_twiDevices[HOST_TWI_DEVICES_MAX];
+static uint8 g_twiDevicesNum = 0;
+
+/* Master state, the addressed device and the operation in progress */
+static HOST_TwiStateType g_twiState;
+static const HOST_TwiDeviceType *g_twiDevice;
+static boolean g_twiBusy;
+static uint64 g_twiEndTime;
+
+/* Call back of the bus monitor */
+static void (*g_twiMonitor)(uint8 condition) = NULL_PTR;
+static uint8 g_twiStatus;
+
+/* External EEPROM */
+static uint8 g_eeprom[HOST_EEPROM_SIZE];
+static uint16 g_eepromAddress;
+static uint8 g_eepromBlock;
+static boolean g_eepromAddressed;
+static boolean g_eepromWritten;
+static uint64 g_eepromBusyEndTime = 0;
+static const char *g_eepromFile = NULL_PTR;
+
+/* Statistics */
+static uint32 g_eepromWrites;
+static uint32 g_eepromReads;
+
+static const uint8 g_twiRegisters[] =
+{
+	HOST_ADDRESS_TWBR, HOST_ADDRESS_TWSR, HOST_ADDRESS_TWAR, HOST_ADDRESS_TWDR, HOST_ADDRESS_TWCR,
+	HOST_NO_ADDRESS
+};
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Start the bus operation requested by writing one to TWINT.
+ */
+static void HOST_twiOperation(uint8 control);
+
+/*
+ * Return the CPU cycles of the SCL periods with the current bit rate.
+ */
+static uint64 HOST_twiCycles(uint8 periods);
+
+/*
+ * External EEPROM device call backs.
+ */
+static boolean HOST_eepromStart(uint8 address, boolean read);
+static boolean HOST_eepromWrite(uint8 data);
+static uint8 HOST_eepromRead(void);
+static void HOST_eepromStop(void);
+
+/*
+ * Interrupt call backs.
+ */
+static boolean HOST_twiIsPending(void);
+
+/*
+ * Peripheral call backs.
+ */
+static void HOST_twiReset(void);
+static void HOST_twiWrite(uint8 address, uint8 old_value);
+static uint64 HOST_twiNextEvent(void);
+static void HOST_twiAdvance(uint64 now);
+static void HOST_twiReport(void);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*[FUNCTION NAME]	: HOST_twiAttach
+ *[DESCRIPTION]		: Connect a device to the TWI bus
+ *[ARGUMENTS]		: pointer to the device call backs of type HOST_TwiDeviceType
+ *[RETURNS]			: void
+ */
+void HOST_twiAttach(const HOST_TwiDeviceType *device)
+{
+	if(g_twiDevicesNum >= HOST_TWI_DEVICES_MAX)
+	{
+		HOST_fatal("more than %d TWI devices", HOST_TWI_DEVICES_MAX);
+	}
+	g_twiDevices[g_twiDevicesNum++] = device;
+}
+
+/*[FUNCTION NAME]	: HOST_twiMonitor
+ *[DESCRIPTION]		: Give the START and STOP conditions on the bus to the call back
+ *[ARGUMENTS]		: pointer to the call back function
+ *[RETURNS]			: void
+ */
+void HOST_twiMonitor(void (*a_ptr)(uint8 condition))
+{
+	g_twiMonitor = a_ptr;
+}
+
+/*[FUNCTION NAME]	: HOST_eepromUseFile
+ *[DESCRIPTION]		: Load the EEPROM from the file and save it after every write cycle
+ *[ARGUMENTS]		: file path
+ *[RETURNS]			: void
+ */
+void HOST_eepromUseFile(const char *path)
+{
+	FILE *file = fopen(path, "rb");
+
+	g_eepromFile = path;
+	if(file != NULL_PTR)
+	{
+		if(fread(g_eeprom, 1, HOST_EEPROM_SIZE, file) != HOST_EEPROM_SIZE)
+		{
+			HOST_log("%s is shorter than the EEPROM, the rest is erased", path);
+		}
+		fclose(file);
+	}
+}
+
+static void HOST_twiOperation(uint8 control)
+{
+	uint8 data = HOST_io[HOST_ADDRESS_TWDR];
+	uint8 id;
+
+	g_twiBusy = TRUE;
+	g_twiEndTime = HOST_getTime() + HOST_twiCycles(HOST_TWI_BYTE_PERIODS);
+
+	if(BIT_IS_SET(control,TWSTA))
+	{
+		g_twiStatus = (g_twiState == HOST_TWI_IDLE) ? HOST_TWI_START : HOST_TWI_REP_START;
+		g_twiState = HOST_TWI_STARTED;
+		g_twiEndTime = HOST_getTime() + HOST_twiCycles(HOST_TWI_START_PERIODS);
+		if(g_twiMonitor != NULL_PTR)
+		{
+			g_twiMonitor(HOST_TWI_BUS_START);
+		}
+		return;
+	}
+
+	switch(g_twiState)
+	{
+	case HOST_TWI_STARTED:
+		/* SLA+R/W, the addressed device acknowledges */
+		g_twiDevice = NULL_PTR;
+		for(id = 0 ; id < g_twiDevicesNum ; id++)
+		{
+			if(((data >> 1) & g_twiDevices[id]->address_mask) == g_twiDevices[id]->address)
+			{
+				g_twiDevice = g_twiDevices[id];
+			}
+		}
+		if((g_twiDevice != NULL_PTR) && g_twiDevice->start(data >> 1, BIT_IS_SET(data,0)))
+		{
+			g_twiStatus = BIT_IS_SET(data,0) ? HOST_TWI_MR_SLA_R_ACK : HOST_TWI_MT_SLA_W_ACK;
+			g_twiState = BIT_IS_SET(data,0) ? HOST_TWI_RECEIVING : HOST_TWI_TRANSMITTING;
+		}
+		else
+		{
+			g_twiStatus = BIT_IS_SET(data,0) ? HOST_TWI_MR_SLA_R_NACK : HOST_TWI_MT_SLA_W_NACK;
+			g_twiDevice = NULL_PTR;
+		}
+		break;
+	case HOST_TWI_TRANSMITTING:
+		g_twiStatus = g_twiDevice->write(data) ? HOST_TWI_MT_DATA_ACK : HOST_TWI_MT_DATA_NACK;
+		break;
+	case HOST_TWI_RECEIVING:
+		HOST_setRegister(HOST_ADDRESS_TWDR, g_twiDevice->read());
+		g_twiStatus = BIT_IS_SET(control,TWEA) ? HOST_TWI_MR_DATA_ACK : HOST_TWI_MR_DATA_NACK;
+		break;
+	default:
+		/* Nothing is addressed, the bus stays idle */
+		g_twiStatus = HOST_TWI_NO_STATE;
+		break;
+	}
+}
+
+static uint64 HOST_twiCycles(uint8 periods)
+{
+	uint8 prescaler_select = HOST_io[HOST_ADDRESS_TWSR] & 0x03;
+
+	/* SCL frequency = F_CPU / (16 + 2 * TWBR * 4^TWPS) */
+	return (uint64)periods * (16 + (2 * (uint64)HOST_io[HOST_ADDRESS_TWBR] * ((uint64)1 << (2 * prescaler_select))));
+}
+
+static boolean HOST_eepromStart(uint8 address, boolean read)
+{
+	/* The EEPROM doesn't acknowledge during its write cycle */
+	if(HOST_getTime() < g_eepromBusyEndTime)
+	{
+		return FALSE;
+	}
+	g_eepromBlock = address & 0x07;
+	g_eepromAddressed = read;
+	g_eepromWritten = FALSE;
+	return TRUE;
+}
+
+static boolean HOST_eepromWrite(uint8 data)
+{
+	if(!g_eepromAddressed)
+	{
+		/* The first byte is the word address in the block */
+		g_eepromAddress = ((uint16)g_eepromBlock << 8) | data;
+		g_eepromAddressed = TRUE;
+	}
+	else
+	{
+		g_eeprom[g_eepromAddress] = data;
+		g_eepromWritten = TRUE;
+		g_eepromWrites++;
+		/* The address rolls over inside the page */
+		g_eepromAddress = (g_eepromAddress & ~(HOST_EEPROM_PAGE_SIZE - 1)) |
+				((g_eepromAddress + 1) & (HOST_EEPROM_PAGE_SIZE - 1));
+	}
+	return TRUE;
+}
+
+static uint8 HOST_eepromRead(void)
+{
+	uint8 data = g_eeprom[g_eepromAddress];
+
+	g_eepromReads++;
+	g_eepromAddress = (g_eepromAddress + 1) % HOST_EEPROM_SIZE;
+	return data;
+}
+
+static void HOST_eepromStop(void)
+{
+	FILE *file;
+
+	if(g_eepromWritten)
+	{
+		g_eepromWritten = FALSE;
+		g_eepromBusyEndTime = HOST_getTime() + HOST_MS_TO_CYCLES(HOST_EEPROM_WRITE_CYCLE_MS);
+		if(g_eepromFile != NULL_PTR)
+		{
+			file = fopen(g_eepromFile, "wb");
+			if(file != NULL_PTR)
+			{
+				fwrite(g_eeprom, 1, HOST_EEPROM_SIZE, file);
+				fclose(file);
+			}
+		}
+	}
+}
+
+static boolean HOST_twiIsPending(void)
+{
+	return BIT_IS_SET(HOST_io[HOST_ADDRESS_TWCR],TWINT) && BIT_IS_SET(HOST_io[HOST_ADDRESS_TWCR],TWIE);
+}
+
+static void HOST_twiReset(void)
+{
+	static const HOST_TwiDeviceType eeprom =
+	{
+		HOST_EEPROM_ADDRESS, HOST_EEPROM_ADDRESS_MASK, HOST_eepromStart, HOST_eepromWrite,
+		HOST_eepromRead, HOST_eepromStop
+	};
+
+	memset(g_eeprom, 0xFF, sizeof(g_eeprom));
+	g_twiDevicesNum = 0;
+	HOST_twiAttach(&eeprom);
+
+	g_twiState = HOST_TWI_IDLE;
+	g_twiBusy = FALSE;
+	HOST_setRegister(HOST_ADDRESS_TWSR, HOST_TWI_NO_STATE);
+	HOST_setRegister(HOST_ADDRESS_TWAR, 0xFE);
+	HOST_setRegister(HOST_ADDRESS_TWDR, 0xFF);
+}
+
+static void HOST_twiWrite(uint8 address, uint8 old_value)
+{
+	uint8 control = HOST_io[address];
+
+	switch(address)
+	{
+	case HOST_ADDRESS_TWCR:
+		if(BIT_IS_CLEAR(control,TWEN))
+		{
+			/* Disabling the TWI ends any transmission */
+			g_twiState = HOST_TWI_IDLE;
+			g_twiBusy = FALSE;
+		}
+		else if(BIT_IS_SET(control,TWINT))
+		{
+			/* Writing one to TWINT clears it and starts the next operation */
+			CLEAR_BIT(control,TWINT);
+			if(BIT_IS_SET(control,TWSTO))
+			{
+				if(g_twiDevice != NULL_PTR)
+				{
+					g_twiDevice->stop();
+				}
+				g_twiDevice = NULL_PTR;
+				g_twiState = HOST_TWI_IDLE;
+				CLEAR_BIT(control,TWSTO);
+				if(g_twiMonitor != NULL_PTR)
+				{
+					g_twiMonitor(HOST_TWI_BUS_STOP);
+				}
+				HOST_setRegister(HOST_ADDRESS_TWSR, (HOST_io[HOST_ADDRESS_TWSR] & 0x03) | HOST_TWI_NO_STATE);
+			}
+			else
+			{
+				HOST_twiOperation(control);
+			}
+		}
+		else
+		{
+			/* Writing zero to TWINT keeps the flag */
+			control |= old_value & (1 << TWINT);
+		}
+		HOST_setRegister(address, control);
+		break;
+	case HOST_ADDRESS_TWSR:
+		/* Only the prescaler bits are written */
+		HOST_setRegister(address, (old_value & 0xF8) | (control & 0x03));
+		break;
+	default:
+		/* TWBR, TWAR and TWDR are used as written */
+		break;
+	}
+}
+
+static uint64 HOST_twiNextEvent(void)
+{
+	return g_twiBusy ? g_twiEndTime : HOST_NEVER;
+}
+
+static void HOST_twiAdvance(uint64 now)
+{
+	if(g_twiBusy && (g_twiEndTime <= now))
+	{
+		g_twiBusy = FALSE;
+		HOST_setRegister(HOST_ADDRESS_TWSR, (HOST_io[HOST_ADDRESS_TWSR] & 0x03) | g_twiStatus);
+		HOST_setRegister(HOST_ADDRESS_TWCR, HOST_io[HOST_ADDRESS_TWCR] | (1 << TWINT));
+	}
+}
+
+static void HOST_twiReport(void)
+{
+	if((g_eepromWrites != 0) || (g_eepromReads != 0))
+	{
+		HOST_log("EEPROM %lu bytes written, %lu bytes read", (unsigned long)g_eepromWrites, (unsigned long)g_eepromReads);
+	}
+}
+
+/*******************************************************************************
+ *                      Peripheral Description                                 *
+ *******************************************************************************/
+
+static const HOST_InterruptType g_twiInterrupts[] =
+{
+	{HOST_VECTOR_TWI, HOST_twiIsPending, NULL_PTR}
+};
+
+const HOST_ModelType HOST_twiModel =
+{
+	"TWI", g_twiRegisters, g_twiInterrupts, 1, HOST_twiReset, HOST_twiWrite,
+	NULL_PTR, HOST_twiNextEvent, HOST_twiAdvance, HOST_twiReport
+};
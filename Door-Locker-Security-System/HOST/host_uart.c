@@ -0,0 +1,391 @@
+ /******************************************************************************
+ *
+ * Module: HOST
+ *
+ * File Name: host_uart.c
+ *
+ * Description: Source file for the emulated ATmega32 USART in the asynchronous mode
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                      Used Header Files                                      *
+ *******************************************************************************/
+
+#include "host_models.h"
+#include <stdio.h>
+#include <unistd.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Bytes kept by the receive buffer, the third byte in the shift register is not emulated */
+#define HOST_UART_RX_BUFFER_SIZE     2
+
+/*
+ * The frame settings are only used for the frame duration, the whole data byte
+ * is always given to the peer. Reading UCSRC gives UCSRC, the read sequence
+ * returning UBRRH first is not emulated.
+ */
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+static uint8 g_ucsrc;
+static uint8 g_ubrrh;
+
+/* Transmitter: the shift register and the data buffer (UDR) */
+static boolean g_txShifting;
+static uint8 g_txShiftData;
+static uint64 g_txEndTime;
+static boolean g_txBufferFull;
+static uint8 g_txBufferData;
+
+/* Receiver buffer */
+static uint8 g_rxBuffer[HOST_UART_RX_BUFFER_SIZE];
+static uint8 g_rxCount;
+
+/* Peer receiving the transmitted bytes */
+static void (*g_txCallBack)(uint8 data) = NULL_PTR;
+
+/* Redirected stdin received one byte at a time, each one when the buffer is empty */
+static boolean g_stdinUsed = FALSE;
+static uint64 g_stdinNextTime = HOST_NEVER;
+
+/* Statistics */
+static uint32 g_txBytes;
+static uint32 g_rxBytes;
+static uint32 g_rxOverruns;
+
+static const uint8 g_uartRegisters[] =
+{
+	HOST_ADDRESS_UDR, HOST_ADDRESS_UCSRA, HOST_ADDRESS_UCSRB, HOST_ADDRESS_UBRRL, HOST_ADDRESS_UCSRC,
+	HOST_NO_ADDRESS
+};
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Update the status flags and the UDR value read by the firmware.
+ */
+static void HOST_uartUpdateRegisters(void);
+
+/*
+ * Move the byte to the shift register and give it to the peer at the start of its frame.
+ */
+static void HOST_uartStartFrame(uint8 data, uint64 start_time);
+
+/*
+ * End of the frame, the byte goes to the stdout and the log when there is no peer.
+ */
+static void HOST_uartTransmitted(uint8 data);
+
+/*
+ * Interrupt call backs.
+ */
+static boolean HOST_uartRxcIsPending(void);
+static boolean HOST_uartUdreIsPending(void);
+static boolean HOST_uartTxcIsPending(void);
+static void HOST_uartTxcAcknowledge(void);
+
+/*
+ * Peripheral call backs.
+ */
+static void HOST_uartReset(void);
+static void HOST_uartWrite(uint8 address, uint8 old_value);
+static void HOST_uartRead(uint8 address);
+static uint64 HOST_uartNextEvent(void);
+static void HOST_uartAdvance(uint64 now);
+static void HOST_uartReport(void);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*[FUNCTION NAME]	: HOST_uartReceive
+ *[DESCRIPTION]		: Put a received byte in the receive buffer
+ *[ARGUMENTS]		: received data of type uint8
+ *[RETURNS]			: void
+ */
+void HOST_uartReceive(uint8 data)
+{
+	if(BIT_IS_CLEAR(HOST_io[HOST_ADDRESS_UCSRB],RXEN))
+	{
+		return;
+	}
+	if(g_rxCount < HOST_UART_RX_BUFFER_SIZE)
+	{
+		g_rxBuffer[g_rxCount++] = data;
+		g_rxBytes++;
+	}
+	else
+	{
+		SET_BIT(HOST_io[HOST_ADDRESS_UCSRA],DOR);
+		g_rxOverruns++;
+	}
+	HOST_uartUpdateRegisters();
+}
+
+/*[FUNCTION NAME]	: HOST_uartConnect
+ *[DESCRIPTION]		: Give the transmitted bytes to the call back instead of the stdout
+ *[ARGUMENTS]		: pointer to the call back function
+ *[RETURNS]			: void
+ */
+void HOST_uartConnect(void (*a_ptr)(uint8 data))
+{
+	g_txCallBack = a_ptr;
+	g_stdinUsed = FALSE;
+	g_stdinNextTime = HOST_NEVER;
+}
+
+/*[FUNCTION NAME]	: HOST_uartUseStdio
+ *[DESCRIPTION]		: Receive the stdin when it is redirected to a file or a pipe
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: void
+ */
+void HOST_uartUseStdio(void)
+{
+	g_stdinUsed = !isatty(STDIN_FILENO);
+}
+
+/*[FUNCTION NAME]	: HOST_uartGetFrameCycles
+ *[DESCRIPTION]		: Calculate the frame duration from the baud rate and the frame format
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: CPU cycles of type uint64
+ */
+uint64 HOST_uartGetFrameCycles(void)
+{
+	uint16 ubrr = ((uint16)(g_ubrrh & 0x0F) << 8) | HOST_io[HOST_ADDRESS_UBRRL];
+	uint8 character_size = ((g_ucsrc >> UCSZ0) & 0x03) | (BIT_IS_SET(HOST_io[HOST_ADDRESS_UCSRB],UCSZ2) ? 0x04 : 0);
+	uint8 bits;
+
+	/* Start bit, data bits, parity bit and stop bits */
+	bits = 1 + ((character_size == 7) ? 9 : (5 + (character_size & 0x03)));
+	bits += BIT_IS_SET(g_ucsrc,UPM1) ? 1 : 0;
+	bits += BIT_IS_SET(g_ucsrc,USBS) ? 2 : 1;
+
+	return (uint64)bits * ((uint64)ubrr + 1) * (BIT_IS_SET(HOST_io[HOST_ADDRESS_UCSRA],U2X) ? 8 : 16);
+}
+
+static void HOST_uartUpdateRegisters(void)
+{
+	uint8 status = HOST_io[HOST_ADDRESS_UCSRA] & ((1 << TXC) | (1 << FE) | (1 << DOR) | (1 << PE) | (1 << U2X) | (1 << MPCM));
+
+	if(g_rxCount != 0)
+	{
+		SET_BIT(status,RXC);
+	}
+	if(!g_txBufferFull)
+	{
+		SET_BIT(status,UDRE);
+	}
+	HOST_setRegister(HOST_ADDRESS_UCSRA, status);
+	HOST_setRegister(HOST_ADDRESS_UDR, (g_rxCount != 0) ? g_rxBuffer[0] : 0);
+	HOST_setRegister(HOST_ADDRESS_UCSRC, g_ucsrc);
+}
+
+static void HOST_uartStartFrame(uint8 data, uint64 start_time)
+{
+	g_txShiftData = data;
+	g_txShifting = TRUE;
+	g_txEndTime = start_time + HOST_uartGetFrameCycles();
+	if(g_txCallBack != NULL_PTR)
+	{
+		g_txCallBack(data);
+	}
+}
+
+static void HOST_uartTransmitted(uint8 data)
+{
+	g_txBytes++;
+	if(g_txCallBack == NULL_PTR)
+	{
+		HOST_log("UART TX 0x%02X", data);
+		if(!isatty(STDOUT_FILENO))
+		{
+			putchar(data);
+		}
+	}
+}
+
+static boolean HOST_uartRxcIsPending(void)
+{
+	return BIT_IS_SET(HOST_io[HOST_ADDRESS_UCSRA],RXC) && BIT_IS_SET(HOST_io[HOST_ADDRESS_UCSRB],RXCIE);
+}
+
+static boolean HOST_uartUdreIsPending(void)
+{
+	return BIT_IS_SET(HOST_io[HOST_ADDRESS_UCSRA],UDRE) && BIT_IS_SET(HOST_io[HOST_ADDRESS_UCSRB],UDRIE);
+}
+
+static boolean HOST_uartTxcIsPending(void)
+{
+	return BIT_IS_SET(HOST_io[HOST_ADDRESS_UCSRA],TXC) && BIT_IS_SET(HOST_io[HOST_ADDRESS_UCSRB],TXCIE);
+}
+
+static void HOST_uartTxcAcknowledge(void)
+{
+	HOST_setRegister(HOST_ADDRESS_UCSRA, HOST_io[HOST_ADDRESS_UCSRA] & ~(1 << TXC));
+}
+
+static void HOST_uartReset(void)
+{
+	g_ucsrc = (1 << URSEL) | (1 << UCSZ1) | (1 << UCSZ0);
+	g_ubrrh = 0;
+	g_txShifting = FALSE;
+	g_txBufferFull = FALSE;
+	g_rxCount = 0;
+	HOST_uartUpdateRegisters();
+}
+
+static void HOST_uartWrite(uint8 address, uint8 old_value)
+{
+	uint8 value = HOST_io[address];
+
+	switch(address)
+	{
+	case HOST_ADDRESS_UDR:
+		if(BIT_IS_CLEAR(HOST_io[HOST_ADDRESS_UCSRB],TXEN))
+		{
+			/* Do Nothing */
+		}
+		else if(!g_txShifting)
+		{
+			/* The byte goes to the shift register at once and the buffer is free again */
+			HOST_uartStartFrame(value, HOST_getTime());
+		}
+		else if(!g_txBufferFull)
+		{
+			g_txBufferData = value;
+			g_txBufferFull = TRUE;
+		}
+		break;
+	case HOST_ADDRESS_UCSRA:
+		/*
+		 * Only U2X and MPCM are written, writing one to TXC clears it. A write
+		 * leaving the register unchanged is not seen so TXC stays set then.
+		 */
+		HOST_io[address] = (old_value & ~((1 << U2X) | (1 << MPCM) | (1 << TXC))) |
+				(value & ((1 << U2X) | (1 << MPCM))) | (old_value & ~value & (1 << TXC));
+		break;
+	case HOST_ADDRESS_UCSRC:
+		if(BIT_IS_SET(value,URSEL))
+		{
+			g_ucsrc = value;
+		}
+		else
+		{
+			g_ubrrh = value;
+		}
+		break;
+	default:
+		/* UCSRB and UBRRL are used as written */
+		break;
+	}
+	if((address == HOST_ADDRESS_UCSRB) && BIT_IS_CLEAR(value,RXEN))
+	{
+		/* Disabling the receiver flushes its buffer */
+		g_rxCount = 0;
+	}
+	HOST_uartUpdateRegisters();
+}
+
+static void HOST_uartRead(uint8 address)
+{
+	uint8 index;
+
+	/* Reading UDR takes the byte out of the receive buffer */
+	if((address == HOST_ADDRESS_UDR) && (g_rxCount != 0))
+	{
+		for(index = 1 ; index < g_rxCount ; index++)
+		{
+			g_rxBuffer[index - 1] = g_rxBuffer[index];
+		}
+		g_rxCount--;
+		CLEAR_BIT(HOST_io[HOST_ADDRESS_UCSRA],DOR);
+		HOST_uartUpdateRegisters();
+	}
+}
+
+static uint64 HOST_uartNextEvent(void)
+{
+	uint64 nearest = g_txShifting ? g_txEndTime : HOST_NEVER;
+
+	if(g_stdinUsed && BIT_IS_SET(HOST_io[HOST_ADDRESS_UCSRB],RXEN) && (g_rxCount == 0))
+	{
+		if(g_stdinNextTime == HOST_NEVER)
+		{
+			/* The next byte is sent as soon as the receiver is enabled and empty */
+			g_stdinNextTime = HOST_getTime() + HOST_uartGetFrameCycles();
+		}
+		if(g_stdinNextTime < nearest)
+		{
+			nearest = g_stdinNextTime;
+		}
+	}
+	return nearest;
+}
+
+static void HOST_uartAdvance(uint64 now)
+{
+	int data;
+
+	while(g_txShifting && (g_txEndTime <= now))
+	{
+		HOST_uartTransmitted(g_txShiftData);
+		SET_BIT(HOST_io[HOST_ADDRESS_UCSRA],TXC);
+		if(g_txBufferFull)
+		{
+			g_txBufferFull = FALSE;
+			HOST_uartStartFrame(g_txBufferData, g_txEndTime);
+		}
+		else
+		{
+			g_txShifting = FALSE;
+		}
+		HOST_uartUpdateRegisters();
+	}
+
+	if(g_stdinUsed && (g_stdinNextTime <= now))
+	{
+		g_stdinNextTime = HOST_NEVER;
+		data = getchar();
+		if(data == EOF)
+		{
+			g_stdinUsed = FALSE;
+		}
+		else
+		{
+			HOST_uartReceive((uint8)data);
+		}
+	}
+}
+
+static void HOST_uartReport(void)
+{
+	HOST_log("UART %lu bytes sent, %lu bytes received, %lu bytes lost",
+			(unsigned long)g_txBytes, (unsigned long)g_rxBytes, (unsigned long)g_rxOverruns);
+}
+
+/*******************************************************************************
+ *                      Peripheral Description                                 *
+ *******************************************************************************/
+
+static const HOST_InterruptType g_uartInterrupts[] =
+{
+	{HOST_VECTOR_USART_RXC, HOST_uartRxcIsPending, NULL_PTR},
+	{HOST_VECTOR_USART_UDRE, HOST_uartUdreIsPending, NULL_PTR},
+	{HOST_VECTOR_USART_TXC, HOST_uartTxcIsPending, HOST_uartTxcAcknowledge}
+};
+
+const HOST_ModelType HOST_uartModel =
+{
+	"UART", g_uartRegisters, g_uartInterrupts, 3, HOST_uartReset, HOST_uartWrite,
+	HOST_uartRead, HOST_uartNextEvent, HOST_uartAdvance, HOST_uartReport
+};
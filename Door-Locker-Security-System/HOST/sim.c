@@ -0,0 +1,664 @@
+ /******************************************************************************
+ *
+ * Module: SIM
+ *
+ * File Name: sim.c
+ *
+ * Description: Source file for the co-simulation of the two ECUs, the scheduler
+ *              sharing the virtual clock, the UART link and the runs
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                      Used Header Files                                      *
+ *******************************************************************************/
+
+#include "sim.h"
+#include "prof.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <ucontext.h>
+#include <sys/wait.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Each ECU runs its firmware main() in its own coroutine. The scheduler always
+ * resumes the ECU behind in virtual time and lets it run up to a limit it can't
+ * pass without a byte of the other ECU being missed: a byte is known at the
+ * start of its frame and received at its end, so the other ECU can't make a
+ * difference before the earliest time it runs again plus one of its frames,
+ * the ECU stops one cycle before to receive a byte ending at this time.
+ * This assumes the ECUs don't make their UART faster after the start.
+ */
+
+#define SIM_STACK_SIZE               0x100000
+
+/* Bytes in flight on the UART link towards one ECU */
+#define SIM_LINK_SIZE                64
+
+/* Defaults of the command line options */
+#define SIM_DEFAULT_TIME_LIMIT_S     600
+#define SIM_DEFAULT_PRESS_MS         120
+#define SIM_DEFAULT_GAP_MS           200
+
+/* Profiling table of the profiling builds (prof.h), printed on stdout when its frame ends */
+#define SIM_DUMP_SIZE                1024
+
+/* Failed runs printed in the summary */
+#define SIM_FAILURES_SHOWN           5
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+/* Byte on the UART link and the end time of its frame */
+typedef struct
+{
+	uint8 data;
+	uint64 time;
+}SIM_ByteType;
+
+typedef struct
+{
+	const HOST_EcuType *host;
+	const char *name;
+	ucontext_t context;
+	void *stack;
+	/* Time limit given to the ECU when it was resumed, lowered when it sends a byte */
+	uint64 limit;
+	/* Bytes sent by the other ECU, received at the end of their frames */
+	SIM_ByteType link[SIM_LINK_SIZE];
+	uint8 link_head;
+	uint8 link_count;
+	/* Profiling table sent by the ECU */
+	char dump[SIM_DUMP_SIZE];
+	uint16 dump_length;
+	boolean dumping;
+}SIM_EcuType;
+
+/* Result of one run, given by the run process to the main process */
+typedef struct
+{
+	boolean passed;
+	uint64 time;
+	char message[2 * SIM_TEXT_SIZE];
+	SIM_LatencyType latency;
+}SIM_ResultType;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+static SIM_EcuType g_ecus[SIM_ECUS_NUM] =
+{
+	{&HMI_ECU_host, "HMI_ECU"}, {&CONTROL_ECU_host, "CONTROL_ECU"}
+};
+
+/* ECU running now and the context of the scheduler */
+static uint8 g_running = SIM_HMI_ECU;
+static ucontext_t g_schedulerContext;
+
+/* Virtual time limit of a run */
+static uint64 g_endTime = HOST_MS_TO_CYCLES(SIM_DEFAULT_TIME_LIMIT_S * 1000ULL);
+
+static boolean g_verbose = FALSE;
+
+/* Result of the run */
+static boolean g_finished = FALSE;
+static SIM_ResultType g_result;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Called by an ECU at its time limit, go back to the scheduler.
+ */
+static void SIM_yield(void);
+
+/*
+ * Coroutine of an ECU, run the firmware main function.
+ */
+static void SIM_ecuEntry(void);
+
+/*
+ * Set the limit of the ECU and give it to the emulated MCU.
+ */
+static void SIM_setLimit(uint8 ecu_id, uint64 limit);
+
+/*
+ * Resume the ECUs until the end of the run.
+ */
+static void SIM_schedule(void);
+
+/*
+ * Send a byte from the ECU to the other one, called at the start of its frame.
+ */
+static void SIM_linkSend(uint8 ecu_id, uint8 data);
+
+/*
+ * Collect the bytes of a profiling table sent by the ECU and print it at its end.
+ */
+static void SIM_linkDump(uint8 ecu_id, uint8 data);
+
+/*
+ * Receive the bytes whose frames ended up to now.
+ */
+static void SIM_linkAdvance(uint8 ecu_id, uint64 now);
+
+/*
+ * End time of the next frame received by the ECU.
+ */
+static uint64 SIM_linkNextEvent(uint8 ecu_id);
+
+/*
+ * Call backs of the UART link of each ECU.
+ */
+static void SIM_hmiSend(uint8 data);
+static void SIM_controlSend(uint8 data);
+static void SIM_hmiLinkAdvance(uint64 now);
+static void SIM_controlLinkAdvance(uint64 now);
+static uint64 SIM_hmiLinkNextEvent(void);
+static uint64 SIM_controlLinkNextEvent(void);
+
+/*
+ * Run the scenario once in this process and exit, the result is written to the file.
+ */
+static void SIM_runProcess(const char *scenario, const SIM_KeyTimingType *timing, int result_fd)
+	__attribute__((noreturn));
+
+/*
+ * Run the scenario the given times, up to jobs processes at the same time, and
+ * print the summary. Return the number of failed runs.
+ */
+static uint32 SIM_runScenario(const char *scenario, uint32 runs, uint32 jobs, const SIM_KeyTimingType *timing);
+
+/*
+ * Print the command line help.
+ */
+static void SIM_usage(const char *program);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+int main(int argc, char *argv[])
+{
+	SIM_KeyTimingType timing = {SIM_DEFAULT_PRESS_MS, SIM_DEFAULT_GAP_MS, 0, 0};
+	uint32 runs = 1;
+	uint32 jobs = 1;
+	uint32 failures = 0;
+	const char *json_path = NULL_PTR;
+	int option;
+
+	while((option = getopt(argc, argv, "n:j:r:t:o:vlh")) != -1)
+	{
+		switch(option)
+		{
+		case 'n':
+			runs = (uint32)strtoul(optarg, NULL_PTR, 10);
+			break;
+		case 'j':
+			jobs = (uint32)strtoul(optarg, NULL_PTR, 10);
+			break;
+		case 'r':
+			/* Random key times up to the press time more */
+			timing.seed = (uint32)strtoul(optarg, NULL_PTR, 10);
+			timing.jitter_ms = SIM_DEFAULT_PRESS_MS;
+			break;
+		case 't':
+			g_endTime = HOST_MS_TO_CYCLES(strtoull(optarg, NULL_PTR, 10) * 1000ULL);
+			break;
+		case 'o':
+			json_path = optarg;
+			break;
+		case 'v':
+			g_verbose = TRUE;
+			break;
+		case 'l':
+			SIM_scriptList();
+			return EXIT_SUCCESS;
+		default:
+			SIM_usage(argv[0]);
+			return (option == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+	if((optind >= argc) || (runs == 0) || (jobs == 0))
+	{
+		SIM_usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if((json_path != NULL_PTR) && !SIM_benchOpen(json_path, runs, &timing))
+	{
+		return EXIT_FAILURE;
+	}
+	for( ; optind < argc ; optind++)
+	{
+		if(!SIM_scriptLoad(argv[optind]))
+		{
+			return EXIT_FAILURE;
+		}
+		failures += SIM_runScenario(argv[optind], runs, jobs, &timing);
+	}
+	SIM_benchClose();
+	return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*[FUNCTION NAME]	: SIM_getEcu
+ *[DESCRIPTION]		: Return the entry points of the ECU
+ *[ARGUMENTS]		: ECU ID of type uint8
+ *[RETURNS]			: pointer to the entry points of type HOST_EcuType
+ */
+const HOST_EcuType *SIM_getEcu(uint8 ecu_id)
+{
+	return g_ecus[ecu_id].host;
+}
+
+/*[FUNCTION NAME]	: SIM_log
+ *[DESCRIPTION]		: Print a message of the ECU on stderr in the verbose mode
+ *[ARGUMENTS]		: ECU ID of type uint8, printf format and arguments
+ *[RETURNS]			: void
+ */
+void SIM_log(uint8 ecu_id, const char *format, ...)
+{
+	va_list arguments;
+
+	if(!g_verbose)
+	{
+		return;
+	}
+	fprintf(stderr, "[%-11s %10.3f ms] ", g_ecus[ecu_id].name,
+			(double)g_ecus[ecu_id].host->getTime() / HOST_CYCLES_PER_MS);
+	va_start(arguments, format);
+	vfprintf(stderr, format, arguments);
+	va_end(arguments);
+	fputc('\n', stderr);
+}
+
+/*[FUNCTION NAME]	: SIM_finish
+ *[DESCRIPTION]		: End the run, the running ECU stops at once
+ *[ARGUMENTS]		: result of type boolean and the failure message
+ *[RETURNS]			: void
+ */
+void SIM_finish(boolean passed, const char *message)
+{
+	if(g_finished)
+	{
+		return;
+	}
+	g_finished = TRUE;
+	g_result.passed = passed;
+	g_result.time = g_ecus[g_running].host->getTime();
+	snprintf(g_result.message, sizeof(g_result.message), "%s", (message != NULL_PTR) ? message : "");
+	SIM_setLimit(g_running, g_result.time);
+}
+
+static void SIM_yield(void)
+{
+	swapcontext(&g_ecus[g_running].context, &g_schedulerContext);
+}
+
+static void SIM_ecuEntry(void)
+{
+	g_ecus[g_running].host->main();
+
+	SIM_finish(FALSE, "the firmware main() returned");
+	SIM_yield();
+}
+
+static void SIM_setLimit(uint8 ecu_id, uint64 limit)
+{
+	g_ecus[ecu_id].limit = limit;
+	g_ecus[ecu_id].host->setTimeLimit(limit, SIM_yield);
+}
+
+static void SIM_schedule(void)
+{
+	SIM_EcuType *other;
+	uint64 wake_time;
+	uint64 limit;
+	uint8 ecu_id;
+
+	while(!g_finished)
+	{
+		/* Resume the ECU behind, the HMI_ECU first at the same time */
+		ecu_id = (g_ecus[SIM_HMI_ECU].host->getTime() <= g_ecus[SIM_CONTROL_ECU].host->getTime()) ?
+				SIM_HMI_ECU : SIM_CONTROL_ECU;
+		other = &g_ecus[SIM_ECUS_NUM - 1 - ecu_id];
+		if(g_ecus[ecu_id].host->getTime() >= g_endTime)
+		{
+			SIM_finish(FALSE, "virtual time limit reached");
+			break;
+		}
+
+		/* The other ECU runs again at its wake up time or at the next byte it receives */
+		wake_time = other->host->getWakeTime();
+		if((other->link_count != 0) && (other->link[other->link_head].time < wake_time))
+		{
+			wake_time = other->link[other->link_head].time;
+		}
+		limit = (wake_time >= g_endTime) ? g_endTime : (wake_time + other->host->uartGetFrameCycles() - 1);
+		if(limit > g_endTime)
+		{
+			limit = g_endTime;
+		}
+
+		SIM_setLimit(ecu_id, limit);
+		g_running = ecu_id;
+		swapcontext(&g_schedulerContext, &g_ecus[ecu_id].context);
+	}
+}
+
+static void SIM_linkSend(uint8 ecu_id, uint8 data)
+{
+	SIM_EcuType *sender = &g_ecus[ecu_id];
+	SIM_EcuType *receiver = &g_ecus[SIM_ECUS_NUM - 1 - ecu_id];
+	uint64 end_time = sender->host->getTime() + sender->host->uartGetFrameCycles();
+	uint64 limit;
+	uint8 index;
+
+	if(receiver->link_count >= SIM_LINK_SIZE)
+	{
+		SIM_finish(FALSE, "UART link overflow");
+		return;
+	}
+	if(end_time <= receiver->host->getTime())
+	{
+		/* The scheduler let the receiver pass the end of the frame */
+		SIM_finish(FALSE, "UART byte received in the past");
+		return;
+	}
+	index = (receiver->link_head + receiver->link_count) % SIM_LINK_SIZE;
+	receiver->link[index].data = data;
+	receiver->link[index].time = end_time;
+	receiver->link_count++;
+	SIM_log(ecu_id, "UART 0x%02X -> %s", data, receiver->name);
+	SIM_benchUart(ecu_id, data, FALSE, sender->host->getTime());
+	SIM_linkDump(ecu_id, data);
+
+	/* The receiver may answer one of its frames after this one */
+	limit = end_time + receiver->host->uartGetFrameCycles() - 1;
+	if(limit < sender->limit)
+	{
+		SIM_setLimit(ecu_id, limit);
+	}
+}
+
+static void SIM_linkDump(uint8 ecu_id, uint8 data)
+{
+	SIM_EcuType *ecu = &g_ecus[ecu_id];
+
+	if(data == PROF_FRAME_START)
+	{
+		ecu->dumping = TRUE;
+		ecu->dump_length = 0;
+	}
+	else if(!ecu->dumping)
+	{
+		return;
+	}
+	else if(data == PROF_FRAME_END)
+	{
+		/* The frame bytes are also command bytes of the application, a table starts with P0 */
+		ecu->dumping = FALSE;
+		ecu->dump[ecu->dump_length] = '\0';
+		if(ecu->dump[0] == 'P')
+		{
+			printf("%s profile at %.3f ms:\n%s", ecu->name,
+					(double)ecu->host->getTime() / HOST_CYCLES_PER_MS, ecu->dump);
+			fflush(stdout);
+		}
+	}
+	else if((data != '\n') && (data != '\r') && ((data < ' ') || (data > '~')))
+	{
+		/* Not a table */
+		ecu->dumping = FALSE;
+	}
+	else if((data != '\r') && (ecu->dump_length < (SIM_DUMP_SIZE - 1)))
+	{
+		ecu->dump[ecu->dump_length] = (char)data;
+		ecu->dump_length++;
+	}
+}
+
+static void SIM_linkAdvance(uint8 ecu_id, uint64 now)
+{
+	SIM_EcuType *ecu = &g_ecus[ecu_id];
+
+	while((ecu->link_count != 0) && (ecu->link[ecu->link_head].time <= now))
+	{
+		ecu->host->uartReceive(ecu->link[ecu->link_head].data);
+		SIM_benchUart(ecu_id, ecu->link[ecu->link_head].data, TRUE, ecu->link[ecu->link_head].time);
+		ecu->link_head = (ecu->link_head + 1) % SIM_LINK_SIZE;
+		ecu->link_count--;
+	}
+}
+
+static uint64 SIM_linkNextEvent(uint8 ecu_id)
+{
+	SIM_EcuType *ecu = &g_ecus[ecu_id];
+
+	return (ecu->link_count != 0) ? ecu->link[ecu->link_head].time : HOST_NEVER;
+}
+
+static void SIM_hmiSend(uint8 data)
+{
+	SIM_linkSend(SIM_HMI_ECU, data);
+}
+
+static void SIM_controlSend(uint8 data)
+{
+	SIM_linkSend(SIM_CONTROL_ECU, data);
+}
+
+static void SIM_hmiLinkAdvance(uint64 now)
+{
+	SIM_linkAdvance(SIM_HMI_ECU, now);
+}
+
+static void SIM_controlLinkAdvance(uint64 now)
+{
+	SIM_linkAdvance(SIM_CONTROL_ECU, now);
+}
+
+static uint64 SIM_hmiLinkNextEvent(void)
+{
+	return SIM_linkNextEvent(SIM_HMI_ECU);
+}
+
+static uint64 SIM_controlLinkNextEvent(void)
+{
+	return SIM_linkNextEvent(SIM_CONTROL_ECU);
+}
+
+static void SIM_runProcess(const char *scenario, const SIM_KeyTimingType *timing, int result_fd)
+{
+	static const HOST_DeviceType hmi_link = {NULL_PTR, SIM_hmiLinkNextEvent, SIM_hmiLinkAdvance};
+	static const HOST_DeviceType control_link = {NULL_PTR, SIM_controlLinkNextEvent, SIM_controlLinkAdvance};
+	uint8 ecu_id;
+
+	for(ecu_id = 0 ; ecu_id < SIM_ECUS_NUM ; ecu_id++)
+	{
+		g_ecus[ecu_id].host->setName(g_ecus[ecu_id].name);
+		g_ecus[ecu_id].stack = malloc(SIM_STACK_SIZE);
+		getcontext(&g_ecus[ecu_id].context);
+		g_ecus[ecu_id].context.uc_stack.ss_sp = g_ecus[ecu_id].stack;
+		g_ecus[ecu_id].context.uc_stack.ss_size = SIM_STACK_SIZE;
+		g_ecus[ecu_id].context.uc_link = &g_schedulerContext;
+		makecontext(&g_ecus[ecu_id].context, SIM_ecuEntry, 0);
+	}
+
+	/* The UART of each ECU is wired to the other one */
+	HMI_ECU_host.uartConnect(SIM_hmiSend);
+	HMI_ECU_host.addDevice(&hmi_link);
+	CONTROL_ECU_host.uartConnect(SIM_controlSend);
+	CONTROL_ECU_host.addDevice(&control_link);
+	CONTROL_ECU_host.twiMonitor(SIM_benchTwi);
+
+	SIM_hmiInit();
+	SIM_controlInit();
+	SIM_scriptStart(timing);
+
+	SIM_schedule();
+
+	if(!SIM_benchGet(&g_result.latency) && g_result.passed)
+	{
+		g_result.passed = FALSE;
+		snprintf(g_result.message, sizeof(g_result.message), "the measured flow didn't reach its end");
+	}
+
+	if(g_verbose)
+	{
+		SIM_log(SIM_HMI_ECU, "%s %s%s%s", scenario, g_result.passed ? "passed" : "failed",
+				g_result.passed ? "" : ": ", g_result.message);
+		for(ecu_id = 0 ; ecu_id < SIM_ECUS_NUM ; ecu_id++)
+		{
+			g_ecus[ecu_id].host->report();
+		}
+	}
+	if(write(result_fd, &g_result, sizeof(g_result)) != sizeof(g_result))
+	{
+		_exit(EXIT_FAILURE);
+	}
+	_exit(g_result.passed ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+static uint32 SIM_runScenario(const char *scenario, uint32 runs, uint32 jobs, const SIM_KeyTimingType *timing)
+{
+	SIM_KeyTimingType run_timing = *timing;
+	SIM_ResultType result;
+	struct timespec start, end;
+	pid_t *pids = calloc(jobs, sizeof(pid_t));
+	int *fds = calloc(jobs, sizeof(int));
+	uint32 *run_ids = calloc(jobs, sizeof(uint32));
+	SIM_LatencyType *latencies = calloc(runs, sizeof(SIM_LatencyType));
+	uint32 next_run = 0;
+	uint32 active = 0;
+	uint32 passed = 0;
+	uint32 failed = 0;
+	double time_sum = 0.0;
+	double time_min = 0.0;
+	double time_max = 0.0;
+	double seconds;
+	double wall;
+	int pipe_fds[2];
+	int status;
+	pid_t pid;
+	uint32 slot;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	fflush(stdout);
+	fflush(stderr);
+
+	while((next_run < runs) || (active != 0))
+	{
+		/* Start the runs up to the jobs limit, each one in its own process */
+		while((next_run < runs) && (active < jobs))
+		{
+			for(slot = 0 ; pids[slot] != 0 ; slot++);
+			if(pipe(pipe_fds) != 0)
+			{
+				perror("pipe");
+				exit(EXIT_FAILURE);
+			}
+			run_timing.seed = timing->seed + next_run;
+			pid = fork();
+			if(pid < 0)
+			{
+				perror("fork");
+				exit(EXIT_FAILURE);
+			}
+			if(pid == 0)
+			{
+				close(pipe_fds[0]);
+				SIM_runProcess(scenario, &run_timing, pipe_fds[1]);
+			}
+			close(pipe_fds[1]);
+			pids[slot] = pid;
+			fds[slot] = pipe_fds[0];
+			run_ids[slot] = next_run++;
+			active++;
+		}
+
+		pid = wait(&status);
+		for(slot = 0 ; (slot < jobs) && (pids[slot] != pid) ; slot++);
+		if(slot == jobs)
+		{
+			continue;
+		}
+		if(read(fds[slot], &result, sizeof(result)) != sizeof(result))
+		{
+			memset(&result, 0, sizeof(result));
+			snprintf(result.message, sizeof(result.message), "the run process stopped with the status %d",
+					WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+		}
+		close(fds[slot]);
+		pids[slot] = 0;
+		active--;
+
+		if(result.passed)
+		{
+			seconds = (double)result.time / (double)F_CPU;
+			time_min = ((passed == 0) || (seconds < time_min)) ? seconds : time_min;
+			time_max = ((passed == 0) || (seconds > time_max)) ? seconds : time_max;
+			time_sum += seconds;
+			latencies[passed] = result.latency;
+			passed++;
+		}
+		else
+		{
+			if(failed < SIM_FAILURES_SHOWN)
+			{
+				printf("%s: run %lu (seed %lu) failed at %.3f s: %s\n", scenario, (unsigned long)run_ids[slot],
+						(unsigned long)(timing->seed + run_ids[slot]), (double)result.time / (double)F_CPU,
+						result.message);
+			}
+			failed++;
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	wall = (double)(end.tv_sec - start.tv_sec) + ((double)(end.tv_nsec - start.tv_nsec) / 1e9);
+
+	printf("%s: %lu runs, %lu passed, %lu failed\n", scenario, (unsigned long)runs,
+			(unsigned long)passed, (unsigned long)failed);
+	if(passed != 0)
+	{
+		printf("  virtual time per run: min %.3f s, mean %.3f s, max %.3f s\n",
+				time_min, time_sum / passed, time_max);
+	}
+	printf("  wall time %.3f s, %.1f runs/s, %.0fx real time with %lu jobs\n", wall, runs / wall,
+			time_sum / wall, (unsigned long)jobs);
+	SIM_benchReport(scenario, latencies, passed, failed);
+
+	free(pids);
+	free(fds);
+	free(run_ids);
+	free(latencies);
+	return failed;
+}
+
+static void SIM_usage(const char *program)
+{
+	fprintf(stderr,
+			"usage: %s [options] scenario|script ...\n"
+			"Run the HMI_ECU and the CONTROL_ECU firmwares with a virtual keypad, LCD, door,\n"
+			"motor and buzzer, the scenario scripts type the keys and wait for the screens.\n"
+			"  -n RUNS     run each scenario RUNS times (1)\n"
+			"  -j JOBS     run up to JOBS runs in parallel processes (1)\n"
+			"  -r SEED     add random times to the key presses, run N uses the seed SEED+N\n"
+			"  -t SECONDS  virtual time limit of a run (%d)\n"
+			"  -o FILE     write the latency percentiles of the measured flows to the JSON file\n"
+			"  -v          print the screens, the UART bytes, the door and the ECU summaries\n"
+			"  -l          list the built-in scenarios\n", program, SIM_DEFAULT_TIME_LIMIT_S);
+}
@@ -0,0 +1,191 @@
+ /******************************************************************************
+ *
+ * Module: SIM
+ *
+ * File Name: sim.h
+ *
+ * Description: Header file for the co-simulation of the two ECUs with their
+ *              virtual devices on a shared virtual clock
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+#ifndef SIM_H_
+#define SIM_H_
+
+#include "host.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* ECUs of the co-simulation */
+#define SIM_HMI_ECU                  0
+#define SIM_CONTROL_ECU              1
+#define SIM_ECUS_NUM                 2
+
+/* Length of the script texts and of the failure messages */
+#define SIM_TEXT_SIZE                64
+
+/* Phases of the latency measurement, from the ENTER key to the end of the flow */
+#define SIM_PHASES_NUM               9
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+/* Timing of the scripted key presses */
+typedef struct
+{
+	uint32 press_ms;        /* Time a key is held down */
+	uint32 gap_ms;          /* Time between the release and the next press */
+	uint32 jitter_ms;       /* Random time added to both, 0 for the exact times */
+	uint32 seed;            /* Seed of the random times */
+}SIM_KeyTimingType;
+
+/* Latency of each phase of a measured run in CPU cycles */
+typedef struct
+{
+	boolean measured;                   /* The script measured a flow */
+	boolean valid[SIM_PHASES_NUM];      /* The phase happened in the flow */
+	uint64 cycles[SIM_PHASES_NUM];
+}SIM_LatencyType;
+
+/*******************************************************************************
+ *                           External Variables                                *
+ *******************************************************************************/
+
+/* Entry points of the ECU objects, see HOST_EcuType */
+extern const HOST_EcuType HMI_ECU_host;
+extern const HOST_EcuType CONTROL_ECU_host;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Return the entry points of the ECU.
+ */
+const HOST_EcuType *SIM_getEcu(uint8 ecu_id);
+
+/*
+ * Description :
+ * Print a message prefixed with the ECU name and its virtual time on stderr,
+ * only in the verbose mode.
+ */
+void SIM_log(uint8 ecu_id, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+/*
+ * Description :
+ * End the run with its result, the failure message is printed in the summary.
+ */
+void SIM_finish(boolean passed, const char *message);
+
+/*
+ * Description :
+ * Connect the keypad and the LCD to the HMI_ECU pins (sim_hmi.c).
+ */
+void SIM_hmiInit(void);
+
+/*
+ * Description :
+ * Return TRUE when the character is on the keypad legend, 'C' stands for ON/C.
+ */
+boolean SIM_keypadIsKey(char key);
+
+/*
+ * Description :
+ * Press the key of the given character or release the keys with the character 0.
+ */
+void SIM_keypadSet(char key);
+
+/*
+ * Description :
+ * Return TRUE when the settled LCD screen shows the text on one of its rows.
+ */
+boolean SIM_lcdShows(const char *text);
+
+/*
+ * Description :
+ * Return a number changing every time the LCD screen settles on new contents.
+ */
+uint32 SIM_lcdGetVersion(void);
+
+/*
+ * Description :
+ * Copy the two rows of the LCD screen to the text, as "|row 0|row 1|".
+ */
+void SIM_lcdGetScreen(char *text);
+
+/*
+ * Description :
+ * Connect the door, its motor, sensors and the buzzer to the CONTROL_ECU pins
+ * (sim_control.c).
+ */
+void SIM_controlInit(void);
+
+/*
+ * Description :
+ * Put an obstruction on the way of the next closing of the door at the given
+ * travel percent, it stays for the given time once the door reaches it.
+ */
+void SIM_doorObstruct(uint8 percent, uint32 time_ms);
+
+/*
+ * Description :
+ * Load the script of a built-in scenario name or of a file (sim_script.c).
+ * Return FALSE with an error printed when it can't be loaded.
+ */
+boolean SIM_scriptLoad(const char *name);
+
+/*
+ * Description :
+ * Print the names of the built-in scenarios.
+ */
+void SIM_scriptList(void);
+
+/*
+ * Description :
+ * Start the loaded script with the key timing, its steps are run as a device
+ * of the HMI_ECU.
+ */
+void SIM_scriptStart(const SIM_KeyTimingType *timing);
+
+/*
+ * Description :
+ * Measure the next flow: its start is the next key press and its end the motor
+ * start (motor_end TRUE) or the first LCD screen after the CONTROL_ECU answer
+ * (sim_bench.c).
+ */
+void SIM_benchArm(boolean motor_end);
+
+/*
+ * Description :
+ * Events of the ECUs and the devices taken as the marks of the measured flow.
+ */
+void SIM_benchKey(uint64 time);
+void SIM_benchUart(uint8 ecu_id, uint8 data, boolean received, uint64 time);
+void SIM_benchTwi(uint8 condition);
+void SIM_benchMotor(uint64 time);
+void SIM_benchScreen(uint64 time);
+
+/*
+ * Description :
+ * Give the phase latencies of the run, return FALSE when the measured flow
+ * didn't reach its end.
+ */
+boolean SIM_benchGet(SIM_LatencyType *latency);
+
+/*
+ * Description :
+ * Write the latency percentiles of the scenarios to a JSON file: open it before
+ * the first scenario, report each scenario then close it. The report is printed
+ * even without a file.
+ */
+boolean SIM_benchOpen(const char *path, uint32 runs, const SIM_KeyTimingType *timing);
+void SIM_benchReport(const char *scenario, const SIM_LatencyType *latencies, uint32 count, uint32 failed);
+void SIM_benchClose(void);
+
+#endif /* SIM_H_ */
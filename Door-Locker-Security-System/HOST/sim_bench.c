@@ -0,0 +1,421 @@
+ /******************************************************************************
+ *
+ * Module: SIM
+ *
+ * File Name: sim_bench.c
+ *
+ * Description: Source file for the latency measurement of the password flows,
+ *              from the final ENTER key to the motor start or the LCD feedback
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                      Used Header Files                                      *
+ *******************************************************************************/
+
+#include "sim.h"
+#include "common_macros.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * The marks are taken on the wires, the firmware is not changed:
+ *   ENTER        the ENTER key goes down
+ *   COMMAND      the HMI_ECU starts sending its first byte, the flow command
+ *   READY        the HMI_ECU received CONTROL_ECU_READY
+ *   PASSWORD     the CONTROL_ECU received the last password byte
+ *   EEPROM_START the first START on the TWI bus of the CONTROL_ECU after it
+ *   EEPROM_END   the last STOP on the TWI bus before the answer
+ *   RESULT       the HMI_ECU received the answer of the CONTROL_ECU
+ *   FEEDBACK     the last write of the first LCD screen shown after the answer
+ *   MOTOR        the motor driver inputs select CW after the answer
+ */
+#define SIM_MARK_ENTER               0
+#define SIM_MARK_COMMAND             1
+#define SIM_MARK_READY               2
+#define SIM_MARK_PASSWORD            3
+#define SIM_MARK_EEPROM_START        4
+#define SIM_MARK_EEPROM_END          5
+#define SIM_MARK_RESULT              6
+#define SIM_MARK_FEEDBACK            7
+#define SIM_MARK_MOTOR               8
+#define SIM_MARKS_NUM                9
+/* End of the flow, the MOTOR or the FEEDBACK mark as armed */
+#define SIM_MARK_END                 SIM_MARKS_NUM
+
+/* Protocol values of hmi_mcu.c and control_ecu.c */
+#define SIM_CONTROL_ECU_READY        0x20
+#define SIM_PASSWORD_SIZE            5
+
+/* Percentiles of the report */
+#define SIM_PERCENTILES_NUM          3
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+typedef struct
+{
+	const char *name;
+	uint8 from;
+	uint8 to;
+}SIM_PhaseType;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/* The phases follow each other up to the answer, then the LCD and the motor run in parallel */
+static const SIM_PhaseType g_phases[SIM_PHASES_NUM] =
+{
+	{"keypad",        SIM_MARK_ENTER,        SIM_MARK_COMMAND},
+	{"handshake",     SIM_MARK_COMMAND,      SIM_MARK_READY},
+	{"transfer",      SIM_MARK_READY,        SIM_MARK_PASSWORD},
+	{"receive_delay", SIM_MARK_PASSWORD,     SIM_MARK_EEPROM_START},
+	{"eeprom",        SIM_MARK_EEPROM_START, SIM_MARK_EEPROM_END},
+	{"reply",         SIM_MARK_EEPROM_END,   SIM_MARK_RESULT},
+	{"lcd",           SIM_MARK_RESULT,       SIM_MARK_FEEDBACK},
+	{"motor",         SIM_MARK_EEPROM_END,   SIM_MARK_MOTOR},
+	{"end_to_end",    SIM_MARK_ENTER,        SIM_MARK_END}
+};
+
+static const uint8 g_percentiles[SIM_PERCENTILES_NUM] = {50, 90, 99};
+
+/* Marks of the run */
+static boolean g_armed = FALSE;
+static boolean g_measuring = FALSE;
+static boolean g_motorEnd;
+static uint64 g_marks[SIM_MARKS_NUM];
+static uint16 g_marked = 0;
+static uint8 g_passwordBytes = 0;
+static boolean g_answerSent = FALSE;
+
+/* Results file */
+static FILE *g_json = NULL_PTR;
+static boolean g_jsonFirst = TRUE;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Take the mark at the time, only its first time is kept.
+ */
+static void SIM_benchMark(uint8 mark, uint64 time);
+
+/*
+ * Return TRUE when the mark was taken.
+ */
+static boolean SIM_benchIsMarked(uint8 mark);
+
+/*
+ * Compare two cycle counts for qsort.
+ */
+static int SIM_benchCompare(const void *first, const void *second);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*[FUNCTION NAME]	: SIM_benchArm
+ *[DESCRIPTION]		: Start the measurement at the next key press
+ *[ARGUMENTS]		: TRUE to end the flow at the motor start, FALSE at the LCD feedback
+ *[RETURNS]			: void
+ */
+void SIM_benchArm(boolean motor_end)
+{
+	g_armed = TRUE;
+	g_measuring = TRUE;
+	g_motorEnd = motor_end;
+	g_marked = 0;
+	g_passwordBytes = 0;
+	g_answerSent = FALSE;
+}
+
+/*[FUNCTION NAME]	: SIM_benchKey
+ *[DESCRIPTION]		: A key went down on the keypad
+ *[ARGUMENTS]		: virtual time of type uint64
+ *[RETURNS]			: void
+ */
+void SIM_benchKey(uint64 time)
+{
+	if(g_armed)
+	{
+		g_armed = FALSE;
+		SIM_benchMark(SIM_MARK_ENTER, time);
+	}
+}
+
+/*[FUNCTION NAME]	: SIM_benchUart
+ *[DESCRIPTION]		: A byte started on the UART link or was received at the end of its frame
+ *[ARGUMENTS]		: ECU sending or receiving the byte, the byte, TRUE when it was received
+ *                    and the virtual time
+ *[RETURNS]			: void
+ */
+void SIM_benchUart(uint8 ecu_id, uint8 data, boolean received, uint64 time)
+{
+	if(!SIM_benchIsMarked(SIM_MARK_ENTER))
+	{
+		return;
+	}
+	if(ecu_id == SIM_HMI_ECU)
+	{
+		if(!received)
+		{
+			SIM_benchMark(SIM_MARK_COMMAND, time);
+		}
+		else if(SIM_benchIsMarked(SIM_MARK_COMMAND) && (data == SIM_CONTROL_ECU_READY))
+		{
+			SIM_benchMark(SIM_MARK_READY, time);
+		}
+		else if(g_answerSent)
+		{
+			SIM_benchMark(SIM_MARK_RESULT, time);
+		}
+	}
+	else if(SIM_benchIsMarked(SIM_MARK_READY))
+	{
+		if(received && (g_passwordBytes < SIM_PASSWORD_SIZE) && (++g_passwordBytes == SIM_PASSWORD_SIZE))
+		{
+			SIM_benchMark(SIM_MARK_PASSWORD, time);
+		}
+		else if(!received && SIM_benchIsMarked(SIM_MARK_PASSWORD))
+		{
+			g_answerSent = TRUE;
+		}
+	}
+}
+
+/*[FUNCTION NAME]	: SIM_benchTwi
+ *[DESCRIPTION]		: A START or a STOP condition on the TWI bus of the CONTROL_ECU
+ *[ARGUMENTS]		: condition of type uint8, HOST_TWI_BUS_START or HOST_TWI_BUS_STOP
+ *[RETURNS]			: void
+ */
+void SIM_benchTwi(uint8 condition)
+{
+	uint64 time = CONTROL_ECU_host.getTime();
+
+	if(!SIM_benchIsMarked(SIM_MARK_PASSWORD) || g_answerSent)
+	{
+		return;
+	}
+	if(condition == HOST_TWI_BUS_START)
+	{
+		SIM_benchMark(SIM_MARK_EEPROM_START, time);
+	}
+	else if(SIM_benchIsMarked(SIM_MARK_EEPROM_START))
+	{
+		/* Every STOP moves the end up to the answer */
+		g_marks[SIM_MARK_EEPROM_END] = time;
+		g_marked |= (1 << SIM_MARK_EEPROM_END);
+	}
+}
+
+/*[FUNCTION NAME]	: SIM_benchMotor
+ *[DESCRIPTION]		: The motor driver inputs selected the CW rotation, opening the door
+ *[ARGUMENTS]		: virtual time of type uint64
+ *[RETURNS]			: void
+ */
+void SIM_benchMotor(uint64 time)
+{
+	if(g_answerSent)
+	{
+		SIM_benchMark(SIM_MARK_MOTOR, time);
+	}
+}
+
+/*[FUNCTION NAME]	: SIM_benchScreen
+ *[DESCRIPTION]		: The LCD settled on a new screen
+ *[ARGUMENTS]		: virtual time of the last write of the screen of type uint64
+ *[RETURNS]			: void
+ */
+void SIM_benchScreen(uint64 time)
+{
+	if(SIM_benchIsMarked(SIM_MARK_RESULT))
+	{
+		SIM_benchMark(SIM_MARK_FEEDBACK, time);
+	}
+}
+
+/*[FUNCTION NAME]	: SIM_benchGet
+ *[DESCRIPTION]		: Give the phase latencies of the run
+ *[ARGUMENTS]		: pointer to the latencies of type SIM_LatencyType
+ *[RETURNS]			: FALSE when the measured flow didn't reach its end of type boolean
+ */
+boolean SIM_benchGet(SIM_LatencyType *latency)
+{
+	uint8 phase;
+	uint8 to;
+
+	memset(latency, 0, sizeof(*latency));
+	latency->measured = g_measuring;
+	if(!g_measuring)
+	{
+		return TRUE;
+	}
+	if(!SIM_benchIsMarked(g_motorEnd ? SIM_MARK_MOTOR : SIM_MARK_FEEDBACK))
+	{
+		return FALSE;
+	}
+	for(phase = 0 ; phase < SIM_PHASES_NUM ; phase++)
+	{
+		to = (g_phases[phase].to == SIM_MARK_END) ? (g_motorEnd ? SIM_MARK_MOTOR : SIM_MARK_FEEDBACK) :
+				g_phases[phase].to;
+		if(SIM_benchIsMarked(g_phases[phase].from) && SIM_benchIsMarked(to) &&
+				(g_marks[to] >= g_marks[g_phases[phase].from]))
+		{
+			latency->valid[phase] = TRUE;
+			latency->cycles[phase] = g_marks[to] - g_marks[g_phases[phase].from];
+		}
+	}
+	return TRUE;
+}
+
+/*[FUNCTION NAME]	: SIM_benchOpen
+ *[DESCRIPTION]		: Create the JSON results file
+ *[ARGUMENTS]		: file path, runs of each scenario and the key timing
+ *[RETURNS]			: FALSE when the file can't be created of type boolean
+ */
+boolean SIM_benchOpen(const char *path, uint32 runs, const SIM_KeyTimingType *timing)
+{
+	g_json = fopen(path, "w");
+	if(g_json == NULL_PTR)
+	{
+		perror(path);
+		return FALSE;
+	}
+	fprintf(g_json, "{\n  \"tool\": \"DOOR_SIM\",\n  \"f_cpu\": %lu,\n  \"unit\": \"us\",\n", (unsigned long)F_CPU);
+	fprintf(g_json, "  \"runs\": %lu,\n  \"seed\": %lu,\n  \"press_ms\": %lu,\n  \"gap_ms\": %lu,\n  \"jitter_ms\": %lu,\n",
+			(unsigned long)runs, (unsigned long)timing->seed, (unsigned long)timing->press_ms,
+			(unsigned long)timing->gap_ms, (unsigned long)timing->jitter_ms);
+	fprintf(g_json, "  \"scenarios\": [");
+	g_jsonFirst = TRUE;
+	return TRUE;
+}
+
+/*[FUNCTION NAME]	: SIM_benchReport
+ *[DESCRIPTION]		: Print the latency percentiles of the measured runs of the scenario
+ *                    and add them to the JSON results file
+ *[ARGUMENTS]		: scenario name, pointer to the latencies of the passed runs, their
+ *                    number and the number of failed runs
+ *[RETURNS]			: void
+ */
+void SIM_benchReport(const char *scenario, const SIM_LatencyType *latencies, uint32 count, uint32 failed)
+{
+	uint64 *values = malloc((count + 1) * sizeof(uint64));
+	uint64 percentiles[SIM_PERCENTILES_NUM];
+	double sum;
+	boolean first_phase = TRUE;
+	uint32 measured = 0;
+	uint32 samples;
+	uint32 run;
+	uint8 phase;
+	uint8 index;
+
+	for(run = 0 ; run < count ; run++)
+	{
+		measured += latencies[run].measured ? 1 : 0;
+	}
+	if(measured == 0)
+	{
+		free(values);
+		return;
+	}
+
+	printf("  latency (ms)         runs      min      p50      p90      p99      max\n");
+	if(g_json != NULL_PTR)
+	{
+		fprintf(g_json, "%s\n    {\n      \"name\": \"%s\",\n      \"measured_runs\": %lu,\n      \"failed_runs\": %lu,\n"
+				"      \"phases\": {", g_jsonFirst ? "" : ",", scenario, (unsigned long)measured, (unsigned long)failed);
+		g_jsonFirst = FALSE;
+	}
+
+	for(phase = 0 ; phase < SIM_PHASES_NUM ; phase++)
+	{
+		samples = 0;
+		sum = 0;
+		for(run = 0 ; run < count ; run++)
+		{
+			if(latencies[run].measured && latencies[run].valid[phase])
+			{
+				values[samples++] = latencies[run].cycles[phase];
+				sum += (double)latencies[run].cycles[phase];
+			}
+		}
+		if(samples == 0)
+		{
+			continue;
+		}
+		qsort(values, samples, sizeof(uint64), SIM_benchCompare);
+
+		/* Nearest rank percentiles */
+		for(index = 0 ; index < SIM_PERCENTILES_NUM ; index++)
+		{
+			percentiles[index] = values[(((uint64)g_percentiles[index] * samples) + 99) / 100 - 1];
+		}
+
+		printf("  %-18s %6lu %8.3f %8.3f %8.3f %8.3f %8.3f\n", g_phases[phase].name, (unsigned long)samples,
+				(double)values[0] / HOST_CYCLES_PER_MS, (double)percentiles[0] / HOST_CYCLES_PER_MS,
+				(double)percentiles[1] / HOST_CYCLES_PER_MS, (double)percentiles[2] / HOST_CYCLES_PER_MS,
+				(double)values[samples - 1] / HOST_CYCLES_PER_MS);
+		if(g_json != NULL_PTR)
+		{
+			fprintf(g_json, "%s\n        \"%s\": {\"samples\": %lu, \"min\": %.1f, \"p50\": %.1f, \"p90\": %.1f, "
+					"\"p99\": %.1f, \"max\": %.1f, \"mean\": %.1f}", first_phase ? "" : ",", g_phases[phase].name,
+					(unsigned long)samples, (double)values[0] * 1000 / HOST_CYCLES_PER_MS,
+					(double)percentiles[0] * 1000 / HOST_CYCLES_PER_MS, (double)percentiles[1] * 1000 / HOST_CYCLES_PER_MS,
+					(double)percentiles[2] * 1000 / HOST_CYCLES_PER_MS,
+					(double)values[samples - 1] * 1000 / HOST_CYCLES_PER_MS, sum * 1000 / HOST_CYCLES_PER_MS / samples);
+			first_phase = FALSE;
+		}
+	}
+	if(g_json != NULL_PTR)
+	{
+		fprintf(g_json, "\n      }\n    }");
+	}
+	free(values);
+}
+
+/*[FUNCTION NAME]	: SIM_benchClose
+ *[DESCRIPTION]		: End the JSON results file
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: void
+ */
+void SIM_benchClose(void)
+{
+	if(g_json != NULL_PTR)
+	{
+		fprintf(g_json, "\n  ]\n}\n");
+		fclose(g_json);
+		g_json = NULL_PTR;
+	}
+}
+
+static void SIM_benchMark(uint8 mark, uint64 time)
+{
+	if(!SIM_benchIsMarked(mark))
+	{
+		g_marks[mark] = time;
+		g_marked |= (1 << mark);
+	}
+}
+
+static boolean SIM_benchIsMarked(uint8 mark)
+{
+	return BIT_IS_SET(g_marked,mark) ? TRUE : FALSE;
+}
+
+static int SIM_benchCompare(const void *first, const void *second)
+{
+	uint64 a = *(const uint64 *)first;
+	uint64 b = *(const uint64 *)second;
+
+	return (a > b) - (a < b);
+}
@@ -0,0 +1,343 @@
+ /******************************************************************************
+ *
+ * Module: SIM
+ *
+ * File Name: sim_control.c
+ *
+ * Description: Source file for the virtual door, motor, door sensors and buzzer
+ *              wired to the CONTROL_ECU
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                      Used Header Files                                      *
+ *******************************************************************************/
+
+#include "sim.h"
+#include "gpio.h"
+#include "dc_motor.h"
+#include "door_sensor.h"
+#include "current_sensor.h"
+#include "buzzer.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Door travel time between the two end positions at the full motor speed */
+#define SIM_DOOR_TRAVEL_MS           6000
+
+/* Motor current at the full speed while the door moves and while it is blocked */
+#define SIM_MOTOR_RUN_MILLIAMPS      300
+#define SIM_MOTOR_STALL_MILLIAMPS    1500
+
+/* The PWM output OC0 and the timers clock select bits */
+#define SIM_PWM_PORT_ID              PORTB_ID
+#define SIM_PWM_PIN_ID               PIN3_ID
+#define SIM_TIMER_CLOCK_MASK         0x07
+
+/* Door positions are counted in encoder pulses, the encoder output is high on the second half of a pulse */
+#define SIM_DOOR_HALF_PULSE          0.5
+#define SIM_DOOR_EPSILON             1e-9
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/* Door position from 0 (closed) to DOOR_SENSOR_TRAVEL_PULSES (open) */
+static double g_position = 0;
+/* Door speed in pulses per cycle, positive while opening */
+static double g_speed = 0;
+static uint64 g_time = 0;
+/* Motor driver inputs driven by the ECU */
+static uint8 g_motorInputs = 0;
+
+/* Levels driven on the sensor pins, only the changes are given to the ECU */
+static uint8 g_openLevel = 0xFF;
+static uint8 g_closedLevel = 0xFF;
+static uint8 g_encoderLevel = 0xFF;
+static uint16 g_current = 0xFFFF;
+
+/* Obstruction on the way of the closing door */
+static boolean g_obstructionArmed = FALSE;
+static double g_obstructionPosition;
+static uint64 g_obstructionTime;
+static uint64 g_obstructionEnd = HOST_NEVER;
+
+/* Buzzer state and statistics */
+static boolean g_buzzerOn = FALSE;
+static uint32 g_beeps = 0;
+
+/* Timer2 prescaler divisions of the clock select values */
+static const uint16 g_timer2Divisions[SIM_TIMER_CLOCK_MASK + 1] = {0, 1, 8, 32, 64, 128, 256, 1024};
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Return TRUE while the obstruction holds the closing door at its position.
+ */
+static boolean SIM_doorIsBlocked(void);
+
+/*
+ * Return the door speed from the motor driver inputs and the PWM output.
+ */
+static double SIM_motorSpeed(uint8 inputs);
+
+/*
+ * Drive the limit switches, the encoder and the current sensor from the door state.
+ */
+static void SIM_doorUpdatePins(void);
+
+/*
+ * Follow the buzzer timer output.
+ */
+static void SIM_buzzerUpdate(void);
+
+/*
+ * Device call backs.
+ */
+static void SIM_controlPortChanged(uint8 port_id);
+static uint64 SIM_controlNextEvent(void);
+static void SIM_controlAdvance(uint64 now);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*[FUNCTION NAME]	: SIM_controlInit
+ *[DESCRIPTION]		: Connect the door, its motor, sensors and the buzzer to the CONTROL_ECU
+ *                    pins, the door starts closed
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: void
+ */
+void SIM_controlInit(void)
+{
+	static const HOST_DeviceType device = {SIM_controlPortChanged, SIM_controlNextEvent, SIM_controlAdvance};
+
+	CONTROL_ECU_host.addDevice(&device);
+	SIM_doorUpdatePins();
+}
+
+/*[FUNCTION NAME]	: SIM_doorObstruct
+ *[DESCRIPTION]		: Put an obstruction on the way of the next closing of the door
+ *[ARGUMENTS]		: travel percent of type uint8, obstruction time in ms of type uint32
+ *[RETURNS]			: void
+ */
+void SIM_doorObstruct(uint8 percent, uint32 time_ms)
+{
+	g_obstructionArmed = TRUE;
+	g_obstructionPosition = ((double)percent * DOOR_SENSOR_TRAVEL_PULSES) / 100;
+	g_obstructionTime = HOST_MS_TO_CYCLES(time_ms);
+	g_obstructionEnd = HOST_NEVER;
+}
+
+static boolean SIM_doorIsBlocked(void)
+{
+	return (g_obstructionArmed && (g_obstructionEnd != HOST_NEVER) &&
+			(g_position <= g_obstructionPosition + SIM_DOOR_EPSILON)) ? TRUE : FALSE;
+}
+
+static double SIM_motorSpeed(uint8 inputs)
+{
+	const HOST_EcuType *control = &CONTROL_ECU_host;
+	uint8 tccr0 = control->getRegister(HOST_ADDRESS_TCCR0);
+	double duty;
+	double speed;
+
+	/* OC0 follows the compare unit when it is connected, else the PORTB3 pin */
+	if((tccr0 & SIM_TIMER_CLOCK_MASK) && BIT_IS_SET(tccr0,COM01))
+	{
+		duty = (double)control->getRegister(HOST_ADDRESS_OCR0) / 255;
+	}
+	else
+	{
+		duty = BIT_IS_SET(control->getPortOutput(SIM_PWM_PORT_ID) & control->getPortDirection(SIM_PWM_PORT_ID),
+				SIM_PWM_PIN_ID) ? 1 : 0;
+	}
+
+	speed = (duty * DOOR_SENSOR_TRAVEL_PULSES) / (double)HOST_MS_TO_CYCLES(SIM_DOOR_TRAVEL_MS);
+	if(BIT_IS_SET(inputs,DC_MOTOR_IN2_PIN_ID) && BIT_IS_CLEAR(inputs,DC_MOTOR_IN1_PIN_ID))
+	{
+		/* CW opens the door */
+		return speed;
+	}
+	if(BIT_IS_SET(inputs,DC_MOTOR_IN1_PIN_ID) && BIT_IS_CLEAR(inputs,DC_MOTOR_IN2_PIN_ID))
+	{
+		return -speed;
+	}
+	return 0;
+}
+
+static void SIM_doorUpdatePins(void)
+{
+	const HOST_EcuType *control = &CONTROL_ECU_host;
+	double duty = (g_speed < 0 ? -g_speed : g_speed) * (double)HOST_MS_TO_CYCLES(SIM_DOOR_TRAVEL_MS) / DOOR_SENSOR_TRAVEL_PULSES;
+	boolean blocked = ((g_speed > 0) && (g_position >= DOOR_SENSOR_TRAVEL_PULSES)) ||
+			((g_speed < 0) && ((g_position <= 0) || SIM_doorIsBlocked()));
+	uint8 level;
+	uint16 current;
+
+	/* The switches pull their pins low at the end positions, the pull ups keep them high else */
+	level = (g_position >= DOOR_SENSOR_TRAVEL_PULSES) ? LOGIC_LOW : LOGIC_HIGH;
+	if(level != g_openLevel)
+	{
+		g_openLevel = level;
+		if(level == LOGIC_LOW)
+		{
+			control->drivePin(DOOR_SENSOR_OPEN_PORT_ID, DOOR_SENSOR_OPEN_PIN_ID, LOGIC_LOW);
+		}
+		else
+		{
+			control->releasePin(DOOR_SENSOR_OPEN_PORT_ID, DOOR_SENSOR_OPEN_PIN_ID);
+		}
+	}
+	level = (g_position <= 0) ? LOGIC_LOW : LOGIC_HIGH;
+	if(level != g_closedLevel)
+	{
+		g_closedLevel = level;
+		if(level == LOGIC_LOW)
+		{
+			control->drivePin(DOOR_SENSOR_CLOSED_PORT_ID, DOOR_SENSOR_CLOSED_PIN_ID, LOGIC_LOW);
+		}
+		else
+		{
+			control->releasePin(DOOR_SENSOR_CLOSED_PORT_ID, DOOR_SENSOR_CLOSED_PIN_ID);
+		}
+	}
+	level = ((g_position - (uint32)g_position) >= SIM_DOOR_HALF_PULSE - SIM_DOOR_EPSILON) ? LOGIC_HIGH : LOGIC_LOW;
+	if(level != g_encoderLevel)
+	{
+		g_encoderLevel = level;
+		control->drivePin(DOOR_SENSOR_ENCODER_PORT_ID, DOOR_SENSOR_ENCODER_PIN_ID, level);
+	}
+
+	current = CURRENT_SENSOR_MILLIAMPS(duty * (blocked ? SIM_MOTOR_STALL_MILLIAMPS : SIM_MOTOR_RUN_MILLIAMPS));
+	if(current != g_current)
+	{
+		g_current = current;
+		control->setAnalogInput(CURRENT_SENSOR_CHANNEL_ID, current);
+	}
+}
+
+static void SIM_buzzerUpdate(void)
+{
+	uint8 tccr2 = CONTROL_ECU_host.getRegister(HOST_ADDRESS_TCCR2);
+	boolean on = ((tccr2 & SIM_TIMER_CLOCK_MASK) && BIT_IS_SET(tccr2,COM20)) ? TRUE : FALSE;
+
+	if(on == g_buzzerOn)
+	{
+		return;
+	}
+	g_buzzerOn = on;
+	if(on)
+	{
+		g_beeps++;
+		SIM_log(SIM_CONTROL_ECU, "buzzer on %lu Hz", (unsigned long)(F_CPU /
+				(2UL * g_timer2Divisions[tccr2 & SIM_TIMER_CLOCK_MASK] * (CONTROL_ECU_host.getRegister(HOST_ADDRESS_OCR2) + 1UL))));
+	}
+	else
+	{
+		SIM_log(SIM_CONTROL_ECU, "buzzer off, %lu beeps", (unsigned long)g_beeps);
+	}
+}
+
+static void SIM_controlPortChanged(uint8 port_id)
+{
+	(void)port_id;
+	SIM_controlAdvance(CONTROL_ECU_host.getTime());
+}
+
+static uint64 SIM_controlNextEvent(void)
+{
+	double boundary;
+	uint64 next = HOST_NEVER;
+	uint64 cycles;
+
+	if(g_speed > 0)
+	{
+		boundary = ((uint32)((g_position + SIM_DOOR_EPSILON) / SIM_DOOR_HALF_PULSE) + 1) * SIM_DOOR_HALF_PULSE;
+		if(g_position < DOOR_SENSOR_TRAVEL_PULSES)
+		{
+			cycles = (uint64)((boundary - g_position) / g_speed) + 1;
+			next = g_time + cycles;
+		}
+	}
+	else if((g_speed < 0) && !SIM_doorIsBlocked())
+	{
+		boundary = ((uint32)((g_position - SIM_DOOR_EPSILON) / SIM_DOOR_HALF_PULSE)) * SIM_DOOR_HALF_PULSE;
+		if(g_position > 0)
+		{
+			cycles = (uint64)((g_position - boundary) / -g_speed) + 1;
+			next = g_time + cycles;
+		}
+	}
+	if(g_obstructionArmed && (g_obstructionEnd < next))
+	{
+		next = g_obstructionEnd;
+	}
+	return next;
+}
+
+static void SIM_controlAdvance(uint64 now)
+{
+	uint8 inputs;
+	double speed;
+	double position;
+
+	if(now > g_time)
+	{
+		/* The door moved at the speed set up to now */
+		position = g_position + (g_speed * (double)(now - g_time));
+		if(position > DOOR_SENSOR_TRAVEL_PULSES)
+		{
+			position = DOOR_SENSOR_TRAVEL_PULSES;
+		}
+		if(position < 0)
+		{
+			position = 0;
+		}
+		if(g_obstructionArmed && (g_speed < 0) && (g_position >= g_obstructionPosition) &&
+				(position <= g_obstructionPosition))
+		{
+			position = g_obstructionPosition;
+			if(g_obstructionEnd == HOST_NEVER)
+			{
+				g_obstructionEnd = g_time + (uint64)((g_obstructionPosition - g_position) / g_speed) + g_obstructionTime;
+				SIM_log(SIM_CONTROL_ECU, "door obstructed at %.1f pulses", position);
+			}
+		}
+		g_position = position;
+		g_time = now;
+	}
+	if(g_obstructionArmed && (g_obstructionEnd != HOST_NEVER) && (now >= g_obstructionEnd))
+	{
+		g_obstructionArmed = FALSE;
+		SIM_log(SIM_CONTROL_ECU, "obstruction removed");
+	}
+
+	/* The start of the opening is the end of the unlock latency measurement */
+	inputs = CONTROL_ECU_host.getPortOutput(DC_MOTOR_PORT_ID) & CONTROL_ECU_host.getPortDirection(DC_MOTOR_PORT_ID) &
+			((1 << DC_MOTOR_IN1_PIN_ID) | (1 << DC_MOTOR_IN2_PIN_ID));
+	if(inputs != g_motorInputs)
+	{
+		g_motorInputs = inputs;
+		if(inputs == (1 << DC_MOTOR_IN2_PIN_ID))
+		{
+			SIM_benchMotor(now);
+		}
+	}
+
+	speed = SIM_motorSpeed(inputs);
+	if((speed == 0) != (g_speed == 0))
+	{
+		SIM_log(SIM_CONTROL_ECU, (speed == 0) ? "motor stop at %.1f pulses" :
+				(speed > 0) ? "motor open from %.1f pulses" : "motor close from %.1f pulses", g_position);
+	}
+	g_speed = speed;
+	SIM_doorUpdatePins();
+	SIM_buzzerUpdate();
+}
@@ -0,0 +1,538 @@
+ /******************************************************************************
+ *
+ * Module: SIM
+ *
+ * File Name: sim_hmi.c
+ *
+ * Description: Source file for the virtual keypad and LCD wired to the HMI_ECU
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                      Used Header Files                                      *
+ *******************************************************************************/
+
+#include "sim.h"
+#include "gpio.h"
+#include "keypad.h"
+#include "lcd.h"
+#include <stdio.h>
+#include <string.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Value of g_keyRow while no key is pressed */
+#define SIM_NO_KEY                   0xFF
+
+/* Columns levels while no row pulls them low, through the pull-up resistors */
+#define SIM_KEYPAD_COLUMNS_HIGH      ((uint8)((1 << KEYPAD_NUM_COLS) - 1))
+
+/*
+ * HD44780 controller: DDRAM addresses 0x00-0x27 are the first line and 0x40-0x67
+ * the second one in the two lines mode. The display shift, the CGRAM contents and
+ * the one line mode are not emulated.
+ */
+#define SIM_LCD_DDRAM_SIZE           0x68
+#define SIM_LCD_LINE_END             0x27
+#define SIM_LCD_SECOND_LINE          0x40
+#define SIM_LCD_EXECUTION_US         37
+#define SIM_LCD_LONG_EXECUTION_US    1520
+
+/*
+ * Initialization by instruction: the controller takes no write for 15ms after
+ * the power on, then the first two function sets of the 8-bit interface take
+ * 4.1ms and 100us.
+ */
+#define SIM_LCD_POWER_ON_US          15000
+#define SIM_LCD_RESET_STEPS          2
+
+/* The screen is taken as shown once no write changed it for this time */
+#define SIM_LCD_SETTLE_MS            10
+
+/* Data pins of the LCD bus on its port */
+#if (LCD_DATA_BITS_MODE == 4)
+#define SIM_LCD_DATA_FIRST_PIN       LCD_DB4_PIN_ID
+#define SIM_LCD_DATA_PINS_NUM        4
+#else
+#define SIM_LCD_DATA_FIRST_PIN       PIN0_ID
+#define SIM_LCD_DATA_PINS_NUM        8
+#endif
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/* Keypad legend of each row and column, 'C' is the ON/C key */
+static const char g_keypadLegend[KEYPAD_NUM_ROWS][KEYPAD_NUM_COLS + 1] =
+{
+	"789%", "456*", "123-", "C0=+"
+};
+
+/* Execution time of the function sets of the initialization by instruction */
+static const uint32 g_lcdResetUs[SIM_LCD_RESET_STEPS] = {4100, 100};
+
+/* Pressed key and the column levels driven on the pins */
+static uint8 g_keyRow = SIM_NO_KEY;
+static uint8 g_keyColumn;
+static uint8 g_columns = 0;
+
+/* LCD controller state */
+static uint8 g_ddram[SIM_LCD_DDRAM_SIZE];
+static uint8 g_address = 0;
+static boolean g_cgramSelected = FALSE;
+static boolean g_increment = TRUE;
+static boolean g_displayOn = FALSE;
+static boolean g_eightBits = TRUE;
+static boolean g_secondNibble = FALSE;
+static uint8 g_highNibble;
+static boolean g_readSecondNibble = FALSE;
+static boolean g_enable = FALSE;
+static uint64 g_busyEnd = (uint64)SIM_LCD_POWER_ON_US * (F_CPU / 1000000UL);
+static uint8 g_resetStep = 0;
+
+/* Screen shown after the last writes settled */
+static char g_screen[LCD_ROWS][LCD_COLS + 1];
+static uint32 g_screenVersion = 0;
+static boolean g_screenChanging = FALSE;
+static uint64 g_lastWriteTime;
+
+/* Characters written since the last settled screen and the time of the first one */
+static uint32 g_drawCharacters = 0;
+static uint64 g_drawStart;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Drive the columns from the pressed key and the rows driven low by the scan,
+ * and the wake up pin from the columns.
+ */
+static void SIM_keypadUpdate(void);
+
+/*
+ * Execute an instruction (RS = 0) or write a data byte (RS = 1).
+ */
+static void SIM_lcdExecute(boolean data, uint8 value);
+
+/*
+ * Return the next or the previous DDRAM address of the two lines mode.
+ */
+static uint8 SIM_lcdStep(uint8 address, boolean forward);
+
+/*
+ * Drive the busy flag and the address counter on the data pins for a read.
+ */
+static void SIM_lcdDriveRead(void);
+
+/*
+ * Device call backs.
+ */
+static void SIM_hmiPortChanged(uint8 port_id);
+static uint64 SIM_hmiNextEvent(void);
+static void SIM_hmiAdvance(uint64 now);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*[FUNCTION NAME]	: SIM_hmiInit
+ *[DESCRIPTION]		: Connect the keypad and the LCD to the HMI_ECU pins
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: void
+ */
+void SIM_hmiInit(void)
+{
+	static const HOST_DeviceType device = {SIM_hmiPortChanged, SIM_hmiNextEvent, SIM_hmiAdvance};
+	uint8 row;
+
+	memset(g_ddram, ' ', sizeof(g_ddram));
+	for(row = 0 ; row < LCD_ROWS ; row++)
+	{
+		memset(g_screen[row], ' ', LCD_COLS);
+		g_screen[row][LCD_COLS] = '\0';
+	}
+	HMI_ECU_host.addDevice(&device);
+	SIM_keypadUpdate();
+}
+
+/*[FUNCTION NAME]	: SIM_keypadIsKey
+ *[DESCRIPTION]		: Check that the character is on the keypad legend
+ *[ARGUMENTS]		: key character of type char
+ *[RETURNS]			: TRUE for a keypad key of type boolean
+ */
+boolean SIM_keypadIsKey(char key)
+{
+	uint8 row;
+
+	for(row = 0 ; row < KEYPAD_NUM_ROWS ; row++)
+	{
+		if((key != '\0') && (strchr(g_keypadLegend[row], key) != NULL_PTR))
+		{
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/*[FUNCTION NAME]	: SIM_keypadSet
+ *[DESCRIPTION]		: Press the key of the character, the character 0 releases the keys
+ *[ARGUMENTS]		: key character of type char
+ *[RETURNS]			: void
+ */
+void SIM_keypadSet(char key)
+{
+	const char *column;
+	uint8 row;
+
+	if(key == '\0')
+	{
+		SIM_log(SIM_HMI_ECU, "key %c up", g_keypadLegend[g_keyRow][g_keyColumn]);
+		g_keyRow = SIM_NO_KEY;
+	}
+	else
+	{
+		for(row = 0 ; row < KEYPAD_NUM_ROWS ; row++)
+		{
+			column = strchr(g_keypadLegend[row], key);
+			if(column != NULL_PTR)
+			{
+				g_keyRow = row;
+				g_keyColumn = (uint8)(column - g_keypadLegend[row]);
+				SIM_log(SIM_HMI_ECU, "key %c down", key);
+				SIM_benchKey(HMI_ECU_host.getTime());
+				break;
+			}
+		}
+	}
+	SIM_keypadUpdate();
+}
+
+/*[FUNCTION NAME]	: SIM_lcdShows
+ *[DESCRIPTION]		: Check if the settled screen shows the text
+ *[ARGUMENTS]		: pointer to the text
+ *[RETURNS]			: TRUE when a row contains the text of type boolean
+ */
+boolean SIM_lcdShows(const char *text)
+{
+	uint8 row;
+
+	for(row = 0 ; row < LCD_ROWS ; row++)
+	{
+		if(strstr(g_screen[row], text) != NULL_PTR)
+		{
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/*[FUNCTION NAME]	: SIM_lcdGetVersion
+ *[DESCRIPTION]		: Return the number of the settled screen contents
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: version of type uint32
+ */
+uint32 SIM_lcdGetVersion(void)
+{
+	return g_screenVersion;
+}
+
+/*[FUNCTION NAME]	: SIM_lcdGetScreen
+ *[DESCRIPTION]		: Copy the two rows of the settled screen to the text
+ *[ARGUMENTS]		: pointer to the text, 2 * (LCD_COLS + 1) + 2 characters at least
+ *[RETURNS]			: void
+ */
+void SIM_lcdGetScreen(char *text)
+{
+	sprintf(text, "|%.*s|%.*s|", LCD_COLS, g_screen[0], LCD_COLS, g_screen[1]);
+}
+
+static void SIM_keypadUpdate(void)
+{
+	const HOST_EcuType *hmi = &HMI_ECU_host;
+	uint8 rows_low = hmi->getPortDirection(KEYPAD_ROW_PORT_ID) & ~hmi->getPortOutput(KEYPAD_ROW_PORT_ID);
+	uint8 columns = SIM_KEYPAD_COLUMNS_HIGH;
+	uint8 column;
+
+	/* The pressed switch connects its row to its column */
+	if((g_keyRow != SIM_NO_KEY) && BIT_IS_SET(rows_low,(KEYPAD_FIRST_ROW_PIN_ID + g_keyRow)))
+	{
+		CLEAR_BIT(columns,g_keyColumn);
+	}
+	if(columns == g_columns)
+	{
+		return;
+	}
+	g_columns = columns;
+
+	for(column = 0 ; column < KEYPAD_NUM_COLS ; column++)
+	{
+		hmi->drivePin(KEYPAD_COL_PORT_ID, KEYPAD_FIRST_COL_PIN_ID + column, GET_BIT(columns,column));
+	}
+#if (KEYPAD_WAKE_ON_KEYPRESS == TRUE)
+	/* The wake up pin is wired-AND to the columns */
+	hmi->drivePin(KEYPAD_WAKE_PORT_ID, KEYPAD_WAKE_PIN_ID,
+			(columns == SIM_KEYPAD_COLUMNS_HIGH) ? LOGIC_HIGH : LOGIC_LOW);
+#endif
+}
+
+static void SIM_lcdExecute(boolean data, uint8 value)
+{
+	uint64 now = HMI_ECU_host.getTime();
+	uint32 execution_us = SIM_LCD_EXECUTION_US;
+
+	char message[48];
+
+	/* A write while the controller is busy is lost on the real LCD */
+	if(now < g_busyEnd)
+	{
+		snprintf(message, sizeof(message), "LCD %s 0x%02X written while busy", data ? "data" : "instruction", value);
+		SIM_finish(FALSE, message);
+		return;
+	}
+	g_readSecondNibble = FALSE;
+
+	if(data)
+	{
+		if(!g_cgramSelected)
+		{
+			g_ddram[g_address] = value;
+			g_screenChanging = TRUE;
+			if(g_drawCharacters == 0)
+			{
+				g_drawStart = now;
+			}
+			g_drawCharacters++;
+		}
+		g_address = SIM_lcdStep(g_address, g_increment);
+	}
+	else if(value & 0x80)
+	{
+		/* Set DDRAM address */
+		g_address = value & 0x7F;
+		if(g_address >= SIM_LCD_DDRAM_SIZE)
+		{
+			g_address = 0;
+		}
+		g_cgramSelected = FALSE;
+	}
+	else if(value & 0x40)
+	{
+		/* Set CGRAM address */
+		g_cgramSelected = TRUE;
+	}
+	else if(value & 0x20)
+	{
+		/* Function set, DL selects the 8-bit interface */
+		if(g_eightBits && BIT_IS_SET(value,4) && (g_resetStep < SIM_LCD_RESET_STEPS))
+		{
+			execution_us = g_lcdResetUs[g_resetStep];
+			g_resetStep++;
+		}
+		g_eightBits = BIT_IS_SET(value,4) ? TRUE : FALSE;
+		g_secondNibble = FALSE;
+	}
+	else if(value & 0x10)
+	{
+		/* Cursor shift, S/C = 0 moves the cursor and R/L selects the direction */
+		if(BIT_IS_CLEAR(value,3))
+		{
+			g_address = SIM_lcdStep(g_address, BIT_IS_SET(value,2) ? TRUE : FALSE);
+		}
+	}
+	else if(value & 0x08)
+	{
+		g_displayOn = BIT_IS_SET(value,2) ? TRUE : FALSE;
+		g_screenChanging = TRUE;
+	}
+	else if(value & 0x04)
+	{
+		/* Entry mode set, I/D selects the increment */
+		g_increment = BIT_IS_SET(value,1) ? TRUE : FALSE;
+	}
+	else if(value & 0x02)
+	{
+		/* Return home */
+		g_address = 0;
+		g_cgramSelected = FALSE;
+		execution_us = SIM_LCD_LONG_EXECUTION_US;
+	}
+	else if(value == 0x01)
+	{
+		/* Clear display */
+		memset(g_ddram, ' ', sizeof(g_ddram));
+		g_address = 0;
+		g_cgramSelected = FALSE;
+		g_increment = TRUE;
+		g_screenChanging = TRUE;
+		execution_us = SIM_LCD_LONG_EXECUTION_US;
+	}
+
+	if(g_screenChanging)
+	{
+		g_lastWriteTime = now;
+	}
+	g_busyEnd = now + ((uint64)execution_us * (F_CPU / 1000000UL));
+}
+
+static uint8 SIM_lcdStep(uint8 address, boolean forward)
+{
+	if(forward)
+	{
+		return (address == SIM_LCD_LINE_END) ? SIM_LCD_SECOND_LINE :
+				(address == (SIM_LCD_SECOND_LINE + SIM_LCD_LINE_END)) ? 0 : (uint8)(address + 1);
+	}
+	return (address == 0) ? (SIM_LCD_SECOND_LINE + SIM_LCD_LINE_END) :
+			(address == SIM_LCD_SECOND_LINE) ? SIM_LCD_LINE_END : (uint8)(address - 1);
+}
+
+static void SIM_lcdDriveRead(void)
+{
+	uint8 value = ((HMI_ECU_host.getTime() < g_busyEnd) ? 0x80 : 0) | g_address;
+	uint8 pin;
+
+#if (LCD_DATA_BITS_MODE == 4)
+	/* The high nibble first, then the low nibble with the next enable pulse */
+	if(!g_eightBits)
+	{
+		value = g_readSecondNibble ? (value & 0x0F) : (value >> 4);
+		g_readSecondNibble = !g_readSecondNibble;
+	}
+	else
+	{
+		value >>= 4;
+	}
+#endif
+	for(pin = 0 ; pin < SIM_LCD_DATA_PINS_NUM ; pin++)
+	{
+		HMI_ECU_host.drivePin(LCD_DATA_PORT_ID, SIM_LCD_DATA_FIRST_PIN + pin, GET_BIT(value,pin));
+	}
+}
+
+static void SIM_hmiPortChanged(uint8 port_id)
+{
+	const HOST_EcuType *hmi = &HMI_ECU_host;
+	boolean enable;
+	boolean read;
+	uint8 value;
+	uint8 pin;
+
+	if(port_id == KEYPAD_ROW_PORT_ID)
+	{
+		SIM_keypadUpdate();
+	}
+	if((port_id != LCD_E_PORT_ID) && (port_id != LCD_RS_PORT_ID) && (port_id != LCD_RW_PORT_ID) &&
+			(port_id != LCD_DATA_PORT_ID))
+	{
+		return;
+	}
+
+	enable = BIT_IS_SET(hmi->getPortOutput(LCD_E_PORT_ID),LCD_E_PIN_ID) ? TRUE : FALSE;
+	if(enable == g_enable)
+	{
+		return;
+	}
+	g_enable = enable;
+	read = BIT_IS_SET(hmi->getPortOutput(LCD_RW_PORT_ID),LCD_RW_PIN_ID) ? TRUE : FALSE;
+
+	if(read)
+	{
+		/* The LCD drives the bus while E is high */
+		if(enable)
+		{
+			SIM_lcdDriveRead();
+		}
+		else
+		{
+			for(pin = 0 ; pin < SIM_LCD_DATA_PINS_NUM ; pin++)
+			{
+				hmi->releasePin(LCD_DATA_PORT_ID, SIM_LCD_DATA_FIRST_PIN + pin);
+			}
+		}
+		return;
+	}
+	if(enable)
+	{
+		return;
+	}
+
+	/* The write is latched on the falling edge of E */
+	value = (uint8)(hmi->getPortOutput(LCD_DATA_PORT_ID) >> SIM_LCD_DATA_FIRST_PIN);
+#if (LCD_DATA_BITS_MODE == 4)
+	value &= 0x0F;
+	if(g_eightBits)
+	{
+		/* DB0-DB3 are not wired, they read 0 */
+		value <<= 4;
+	}
+	else if(!g_secondNibble)
+	{
+		g_highNibble = value;
+		g_secondNibble = TRUE;
+		return;
+	}
+	else
+	{
+		value |= g_highNibble << 4;
+		g_secondNibble = FALSE;
+	}
+#endif
+	SIM_lcdExecute(BIT_IS_SET(hmi->getPortOutput(LCD_RS_PORT_ID),LCD_RS_PIN_ID) ? TRUE : FALSE, value);
+}
+
+static uint64 SIM_hmiNextEvent(void)
+{
+	return g_screenChanging ? (g_lastWriteTime + HOST_MS_TO_CYCLES(SIM_LCD_SETTLE_MS)) : HOST_NEVER;
+}
+
+static void SIM_hmiAdvance(uint64 now)
+{
+	char screen[LCD_ROWS][LCD_COLS + 1];
+	char text[2 * (LCD_COLS + 1) + 2];
+	uint32 characters = g_drawCharacters;
+	double draw_ms;
+	uint8 row;
+	uint8 column;
+
+	if(!g_screenChanging || (now < g_lastWriteTime + HOST_MS_TO_CYCLES(SIM_LCD_SETTLE_MS)))
+	{
+		return;
+	}
+	g_screenChanging = FALSE;
+	g_drawCharacters = 0;
+
+	for(row = 0 ; row < LCD_ROWS ; row++)
+	{
+		for(column = 0 ; column < LCD_COLS ; column++)
+		{
+			screen[row][column] = g_displayOn ? (char)g_ddram[(row * SIM_LCD_SECOND_LINE) + column] : ' ';
+			if((screen[row][column] < ' ') || (screen[row][column] > '~'))
+			{
+				screen[row][column] = '?';
+			}
+		}
+		screen[row][LCD_COLS] = '\0';
+	}
+	if(memcmp(screen, g_screen, sizeof(screen)) != 0)
+	{
+		memcpy(g_screen, screen, sizeof(screen));
+		g_screenVersion++;
+		SIM_lcdGetScreen(text);
+		/* The drawing speed counts the time between the first and the last character */
+		draw_ms = (characters != 0) ? ((double)(g_lastWriteTime - g_drawStart) / HOST_CYCLES_PER_MS) : 0;
+		if(characters > 1)
+		{
+			SIM_log(SIM_HMI_ECU, "LCD %s %lu characters in %.3f ms, %.0f characters/s", text,
+					(unsigned long)characters, draw_ms, (characters - 1) * 1000.0 / draw_ms);
+		}
+		else
+		{
+			SIM_log(SIM_HMI_ECU, "LCD %s", text);
+		}
+		SIM_benchScreen(g_lastWriteTime);
+	}
+}
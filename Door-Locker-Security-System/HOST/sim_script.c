@@ -0,0 +1,499 @@
+ /******************************************************************************
+ *
+ * Module: SIM
+ *
+ * File Name: sim_script.c
+ *
+ * Description: Source file for the scenario scripts typing on the virtual keypad
+ *              and waiting for the LCD screens
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                      Used Header Files                                      *
+ *******************************************************************************/
+
+#include "sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * A script has one command per line, '#' starts a comment:
+ *   press KEYS          press and release each key in turn
+ *   hold KEY MS         keep the key pressed for MS milliseconds
+ *   wait TEXT           wait until a row of the LCD shows the text
+ *   delay MS            do nothing for MS milliseconds
+ *   obstruct PERCENT MS block the next closing of the door at the travel percent
+ *   timeout SECONDS     time the next waits fail after
+ *   measure motor|lcd   measure the latency from the next key press to the motor
+ *                       start or to the LCD screen after the CONTROL_ECU answer
+ * The run passes at the end of the script.
+ */
+
+#define SIM_SCRIPT_STEPS_MAX         128
+#define SIM_SCRIPT_FILE_SIZE         8192
+#define SIM_DEFAULT_WAIT_TIMEOUT_S   120
+
+/* The first password setting of all the built-in scenarios, the EEPROM starts erased */
+#define SIM_SET_PASSWORD \
+	"wait PLZ Enter Pass:\n" \
+	"press 12345=\n" \
+	"wait same pass:\n" \
+	"press 12345=\n" \
+	"wait + : Open Door\n"
+
+/* A full door sequence after the right password */
+#define SIM_DOOR_SEQUENCE \
+	"wait Door Unlocking\n" \
+	"wait Door is Unlock!\n" \
+	"wait Door Locking\n" \
+	"wait Door is Locked!\n" \
+	"wait + : Open Door\n"
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+typedef enum
+{
+	SIM_STEP_PRESS, SIM_STEP_HOLD, SIM_STEP_WAIT, SIM_STEP_DELAY, SIM_STEP_OBSTRUCT, SIM_STEP_TIMEOUT,
+	SIM_STEP_MEASURE
+}SIM_StepKind;
+
+typedef struct
+{
+	SIM_StepKind kind;
+	char text[SIM_TEXT_SIZE];
+	uint32 value1;
+	uint32 value2;
+}SIM_StepType;
+
+typedef struct
+{
+	const char *name;
+	const char *description;
+	const char *text;
+}SIM_ScenarioType;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+static const SIM_ScenarioType g_scenarios[] =
+{
+	{"unlock", "set the password then open the door",
+		SIM_SET_PASSWORD
+		"press +\n"
+		"wait PLZ Enter Pass:\n"
+		"press 12345=\n"
+		SIM_DOOR_SEQUENCE},
+	{"lockout", "three wrong passwords lock the keypad, then open the door",
+		SIM_SET_PASSWORD
+		"press +\n"
+		"wait PLZ Enter Pass:\n"
+		"press 11111=\n"
+		"wait WRONG PASS!!\n"
+		"wait PLZ Enter Pass:\n"
+		"press 22222=\n"
+		"wait WRONG PASS!!\n"
+		"wait PLZ Enter Pass:\n"
+		"press 33333=\n"
+		"wait !!!Warning!!!\n"
+		"wait + : Open Door\n"
+		"press +\n"
+		"wait PLZ Enter Pass:\n"
+		"press 12345=\n"
+		SIM_DOOR_SEQUENCE},
+	{"change", "change the password then open the door with the new one",
+		SIM_SET_PASSWORD
+		"press -\n"
+		"wait old pass:\n"
+		"press 12345=\n"
+		"wait PLZ Enter Pass:\n"
+		"press 54321=\n"
+		"wait same pass:\n"
+		"press 54321=\n"
+		"wait + : Open Door\n"
+		"press +\n"
+		"wait PLZ Enter Pass:\n"
+		"press 54321=\n"
+		SIM_DOOR_SEQUENCE},
+	{"obstruction", "the closing door is blocked half way, it opens again then closes",
+		"obstruct 50 2000\n"
+		SIM_SET_PASSWORD
+		"press +\n"
+		"wait PLZ Enter Pass:\n"
+		"press 12345=\n"
+		"wait Door Unlocking\n"
+		"wait Door Locking\n"
+		"wait Door Unlocking\n"
+		SIM_DOOR_SEQUENCE},
+	{"clear", "erase the typed keys with a long press on * then open the door",
+		SIM_SET_PASSWORD
+		"press +\n"
+		"wait PLZ Enter Pass:\n"
+		"press 99\n"
+		"hold * 1000\n"
+		"press 12345=\n"
+		SIM_DOOR_SEQUENCE},
+	{"profile", "open the door then print the profiling tables of the PROFILE=1 builds",
+		SIM_SET_PASSWORD
+		"press +\n"
+		"wait PLZ Enter Pass:\n"
+		"press 12345=\n"
+		SIM_DOOR_SEQUENCE
+		"press %\n"
+		"delay 3000\n"},
+	{"bench-open", "latency from the ENTER key of the right password to the motor start",
+		SIM_SET_PASSWORD
+		"press +\n"
+		"wait PLZ Enter Pass:\n"
+		"press 12345\n"
+		"measure motor\n"
+		"press =\n"
+		"wait Door Unlocking\n"},
+	{"bench-change", "latency from the ENTER key of the old password to the new password screen",
+		SIM_SET_PASSWORD
+		"press -\n"
+		"wait old pass:\n"
+		"press 12345\n"
+		"measure lcd\n"
+		"press =\n"
+		"wait PLZ Enter Pass:\n"},
+	{"bench-wrong", "latency from the ENTER key of a wrong password to the WRONG PASS screen",
+		SIM_SET_PASSWORD
+		"press +\n"
+		"wait PLZ Enter Pass:\n"
+		"press 11111\n"
+		"measure lcd\n"
+		"press =\n"
+		"wait WRONG PASS!!\n"},
+};
+
+/* Loaded script */
+static SIM_StepType g_steps[SIM_SCRIPT_STEPS_MAX];
+static uint8 g_stepsNum = 0;
+
+/* Script run state */
+static const SIM_KeyTimingType *g_timing;
+static uint32 g_seed;
+static uint8 g_step = 0;
+static uint8 g_keyIndex = 0;
+static boolean g_keyDown = FALSE;
+static uint64 g_actionTime = 0;
+static boolean g_waiting = FALSE;
+static uint64 g_waitEnd;
+static uint64 g_waitTimeout = HOST_MS_TO_CYCLES(SIM_DEFAULT_WAIT_TIMEOUT_S * 1000ULL);
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Parse the script text, return FALSE with an error printed on a wrong line.
+ */
+static boolean SIM_scriptParse(const char *name, const char *text);
+
+/*
+ * Return the given time plus the random part of the key timing.
+ */
+static uint64 SIM_scriptKeyTime(uint32 time_ms);
+
+/*
+ * Device call backs.
+ */
+static uint64 SIM_scriptNextEvent(void);
+static void SIM_scriptAdvance(uint64 now);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*[FUNCTION NAME]	: SIM_scriptLoad
+ *[DESCRIPTION]		: Load the script of a built-in scenario or of a file
+ *[ARGUMENTS]		: scenario name or script file name
+ *[RETURNS]			: FALSE when the script can't be loaded of type boolean
+ */
+boolean SIM_scriptLoad(const char *name)
+{
+	static char text[SIM_SCRIPT_FILE_SIZE];
+	FILE *file;
+	size_t size;
+	uint8 id;
+
+	for(id = 0 ; id < sizeof(g_scenarios) / sizeof(g_scenarios[0]) ; id++)
+	{
+		if(strcmp(name, g_scenarios[id].name) == 0)
+		{
+			return SIM_scriptParse(name, g_scenarios[id].text);
+		}
+	}
+
+	file = fopen(name, "r");
+	if(file == NULL_PTR)
+	{
+		fprintf(stderr, "%s: no such scenario or script file (-l lists the scenarios)\n", name);
+		return FALSE;
+	}
+	size = fread(text, 1, sizeof(text) - 1, file);
+	fclose(file);
+	if(size == sizeof(text) - 1)
+	{
+		fprintf(stderr, "%s: script longer than %d bytes\n", name, SIM_SCRIPT_FILE_SIZE - 1);
+		return FALSE;
+	}
+	text[size] = '\0';
+	return SIM_scriptParse(name, text);
+}
+
+/*[FUNCTION NAME]	: SIM_scriptList
+ *[DESCRIPTION]		: Print the names of the built-in scenarios
+ *[ARGUMENTS]		: void
+ *[RETURNS]			: void
+ */
+void SIM_scriptList(void)
+{
+	uint8 id;
+
+	for(id = 0 ; id < sizeof(g_scenarios) / sizeof(g_scenarios[0]) ; id++)
+	{
+		printf("%-12s %s\n", g_scenarios[id].name, g_scenarios[id].description);
+	}
+}
+
+/*[FUNCTION NAME]	: SIM_scriptStart
+ *[DESCRIPTION]		: Start the loaded script as a device of the HMI_ECU
+ *[ARGUMENTS]		: pointer to the key timing of type SIM_KeyTimingType
+ *[RETURNS]			: void
+ */
+void SIM_scriptStart(const SIM_KeyTimingType *timing)
+{
+	static const HOST_DeviceType device = {NULL_PTR, SIM_scriptNextEvent, SIM_scriptAdvance};
+
+	g_timing = timing;
+	g_seed = timing->seed;
+	g_step = 0;
+	g_waiting = FALSE;
+	g_actionTime = 0;
+	HMI_ECU_host.addDevice(&device);
+}
+
+static boolean SIM_scriptParse(const char *name, const char *text)
+{
+	char line[2 * SIM_TEXT_SIZE];
+	char command[SIM_TEXT_SIZE];
+	char argument[SIM_TEXT_SIZE];
+	SIM_StepType *step;
+	const char *end;
+	uint32 line_number = 0;
+	size_t length;
+	char *character;
+	unsigned long value1 = 0;
+	unsigned long value2 = 0;
+	int fields;
+
+	g_stepsNum = 0;
+	while(*text != '\0')
+	{
+		line_number++;
+		end = strchr(text, '\n');
+		length = (end != NULL_PTR) ? (size_t)(end - text) : strlen(text);
+		if(length >= sizeof(line))
+		{
+			length = sizeof(line) - 1;
+		}
+		memcpy(line, text, length);
+		line[length] = '\0';
+		text = (end != NULL_PTR) ? (end + 1) : (text + strlen(text));
+
+		/* Cut the comment and the trailing spaces */
+		character = strchr(line, '#');
+		if(character != NULL_PTR)
+		{
+			*character = '\0';
+		}
+		for(length = strlen(line) ; (length != 0) && isspace((unsigned char)line[length - 1]) ; length--)
+		{
+			line[length - 1] = '\0';
+		}
+		fields = sscanf(line, "%63s", command);
+		if(fields != 1)
+		{
+			continue;
+		}
+		if(g_stepsNum == SIM_SCRIPT_STEPS_MAX)
+		{
+			fprintf(stderr, "%s:%lu: more than %d steps\n", name, (unsigned long)line_number, SIM_SCRIPT_STEPS_MAX);
+			return FALSE;
+		}
+		step = &g_steps[g_stepsNum];
+		memset(step, 0, sizeof(*step));
+
+		/* The argument is the rest of the line */
+		character = strstr(line, command) + strlen(command);
+		while(isspace((unsigned char)*character))
+		{
+			character++;
+		}
+		snprintf(argument, sizeof(argument), "%s", character);
+
+		if(strcmp(command, "press") == 0)
+		{
+			step->kind = SIM_STEP_PRESS;
+			for(character = argument ; *character != '\0' ; character++)
+			{
+				if(!SIM_keypadIsKey(*character))
+				{
+					break;
+				}
+			}
+			fields = ((argument[0] != '\0') && (*character == '\0')) ? 1 : 0;
+			snprintf(step->text, sizeof(step->text), "%s", argument);
+		}
+		else if(strcmp(command, "hold") == 0)
+		{
+			step->kind = SIM_STEP_HOLD;
+			fields = (sscanf(argument, "%1s %lu", step->text, &value1) == 2) &&
+					SIM_keypadIsKey(step->text[0]);
+		}
+		else if(strcmp(command, "wait") == 0)
+		{
+			step->kind = SIM_STEP_WAIT;
+			fields = (argument[0] != '\0') ? 1 : 0;
+			snprintf(step->text, sizeof(step->text), "%s", argument);
+		}
+		else if(strcmp(command, "delay") == 0)
+		{
+			step->kind = SIM_STEP_DELAY;
+			fields = (sscanf(argument, "%lu", &value1) == 1);
+		}
+		else if(strcmp(command, "obstruct") == 0)
+		{
+			step->kind = SIM_STEP_OBSTRUCT;
+			fields = (sscanf(argument, "%lu %lu", &value1, &value2) == 2) &&
+					(value1 <= 100);
+		}
+		else if(strcmp(command, "timeout") == 0)
+		{
+			step->kind = SIM_STEP_TIMEOUT;
+			fields = (sscanf(argument, "%lu", &value1) == 1);
+		}
+		else if(strcmp(command, "measure") == 0)
+		{
+			step->kind = SIM_STEP_MEASURE;
+			value1 = (strcmp(argument, "motor") == 0) ? TRUE : FALSE;
+			fields = value1 || (strcmp(argument, "lcd") == 0);
+		}
+		else
+		{
+			fields = 0;
+		}
+		if(!fields)
+		{
+			fprintf(stderr, "%s:%lu: wrong command '%s'\n", name, (unsigned long)line_number, line);
+			return FALSE;
+		}
+		step->value1 = (uint32)value1;
+		step->value2 = (uint32)value2;
+		g_stepsNum++;
+	}
+	return TRUE;
+}
+
+static uint64 SIM_scriptKeyTime(uint32 time_ms)
+{
+	uint32 jitter_ms = 0;
+
+	if(g_timing->jitter_ms != 0)
+	{
+		jitter_ms = (uint32)rand_r(&g_seed) % (g_timing->jitter_ms + 1);
+	}
+	return HOST_MS_TO_CYCLES(time_ms + jitter_ms);
+}
+
+static uint64 SIM_scriptNextEvent(void)
+{
+	return (g_step == g_stepsNum) ? HOST_NEVER : g_waiting ? g_waitEnd : g_actionTime;
+}
+
+static void SIM_scriptAdvance(uint64 now)
+{
+	SIM_StepType *step;
+	char message[2 * SIM_TEXT_SIZE];
+	char screen[2 * SIM_TEXT_SIZE];
+
+	/* A wait checks the screen at every change, the other steps run at their time */
+	while((g_step < g_stepsNum) && (g_waiting || (now >= g_actionTime)))
+	{
+		step = &g_steps[g_step];
+		switch(step->kind)
+		{
+		case SIM_STEP_PRESS:
+		case SIM_STEP_HOLD:
+			if(!g_keyDown)
+			{
+				SIM_keypadSet(step->text[g_keyIndex]);
+				g_keyDown = TRUE;
+				g_actionTime += (step->kind == SIM_STEP_HOLD) ? HOST_MS_TO_CYCLES(step->value1) :
+						SIM_scriptKeyTime(g_timing->press_ms);
+				continue;
+			}
+			SIM_keypadSet('\0');
+			g_keyDown = FALSE;
+			g_actionTime += SIM_scriptKeyTime(g_timing->gap_ms);
+			if(step->text[++g_keyIndex] != '\0')
+			{
+				continue;
+			}
+			g_keyIndex = 0;
+			break;
+		case SIM_STEP_WAIT:
+			/* The wait starts at the end of the previous step, a late screen fails the run */
+			if(!g_waiting)
+			{
+				g_waiting = TRUE;
+				g_waitEnd = g_actionTime + g_waitTimeout;
+			}
+			if(!SIM_lcdShows(step->text))
+			{
+				if(now >= g_waitEnd)
+				{
+					SIM_lcdGetScreen(screen);
+					snprintf(message, sizeof(message), "timeout waiting for '%.40s' on %.40s", step->text, screen);
+					SIM_finish(FALSE, message);
+					g_step = g_stepsNum;
+				}
+				return;
+			}
+			g_waiting = FALSE;
+			g_actionTime = now;
+			break;
+		case SIM_STEP_DELAY:
+			g_actionTime += HOST_MS_TO_CYCLES(step->value1);
+			break;
+		case SIM_STEP_OBSTRUCT:
+			SIM_doorObstruct((uint8)step->value1, step->value2);
+			break;
+		case SIM_STEP_TIMEOUT:
+			g_waitTimeout = HOST_MS_TO_CYCLES(step->value1 * 1000ULL);
+			break;
+		case SIM_STEP_MEASURE:
+			SIM_benchArm((boolean)step->value1);
+			break;
+		}
+		g_step++;
+	}
+
+	if((g_step == g_stepsNum) && (now >= g_actionTime))
+	{
+		SIM_finish(TRUE, NULL_PTR);
+	}
+}
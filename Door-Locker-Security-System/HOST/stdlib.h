@@ -0,0 +1,25 @@
+ /******************************************************************************
+ *
+ * Module: HOST
+ *
+ * File Name: stdlib.h
+ *
+ * Description: The C library <stdlib.h> with the avr-libc extensions used by
+ *              the firmware
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+#ifndef HOST_STDLIB_H_
+#define HOST_STDLIB_H_
+
+#include_next <stdlib.h>
+
+/*
+ * Description :
+ * Convert the integer to a string in the given base, as the avr-libc itoa().
+ */
+char *itoa(int value, char *string, int radix);
+
+#endif /* HOST_STDLIB_H_ */
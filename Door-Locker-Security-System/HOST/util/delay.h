@@ -0,0 +1,31 @@
+ /******************************************************************************
+ *
+ * Module: HOST
+ *
+ * File Name: delay.h
+ *
+ * Description: Busy wait delays for the host build, replacing the <util/delay.h>
+ *              of avr-libc
+ *
+ * Author: Karima Mahmoud
+ *
+ *******************************************************************************/
+
+#ifndef HOST_UTIL_DELAY_H_
+#define HOST_UTIL_DELAY_H_
+
+#include "host.h"
+
+#ifndef F_CPU
+#error "F_CPU must be defined for the delay functions"
+#endif
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* The delays advance the virtual time, the interrupts are served meanwhile */
+#define _delay_us(US)   HOST_delay((uint64)((double)(US) * (F_CPU / 1000000.0) + 0.5))
+#define _delay_ms(MS)   HOST_delay((uint64)((double)(MS) * (F_CPU / 1000.0) + 0.5))
+
+#endif /* HOST_UTIL_DELAY_H_ */